@@ -16,6 +16,8 @@
 #include "SettingsState.hpp"
 #include "KeyboardControlState.hpp"
 #include "GameOverState.hpp"
+#include "PlaybackState.hpp"
+#include "LobbyState.hpp"
 #include "NetworkProtocol.hpp"
 
 const sf::Time Application::TimePerFrame = sf::seconds(1.f/60.f);
@@ -28,7 +30,8 @@ Application::Application()
 , mSounds()
 , mKeyBinding1(1)
 , mKeyBinding2(2)
-, mStateStack(State::Context(mWindow, mTextures, mFonts, mMusic, mSounds, mKeyBinding1, mKeyBinding2))
+, mJobs()
+, mStateStack(State::Context(mWindow, mTextures, mFonts, mMusic, mSounds, mKeyBinding1, mKeyBinding2, mJobs))
 , mStatisticsText()
 , mStatisticsUpdateTime()
 , mStatisticsNumFrames(0)
@@ -130,6 +133,10 @@ void Application::registerStates()
 	mStateStack.registerState<HostIpEntryState>(States::HostIpEntry);
 	mStateStack.registerState<MultiplayerGameState>(States::JoinGame, false, JoinIp);
 	mStateStack.registerState<JoinIpEntryState>(States::JoinIpEntry);
+	mStateStack.registerState<MultiplayerGameState>(States::SpectateGame, false, JoinIp, true);
+	mStateStack.registerState<PlaybackState>(States::Playback);
+	mStateStack.registerState<LobbyState>(States::Lobby);
+	mStateStack.registerState<MultiplayerGameState>(States::MatchAuthorityGame, false, JoinIp, false, true);
 	mStateStack.registerState<PauseState>(States::Pause);
 	mStateStack.registerState<PauseState>(States::NetworkPause, true);
 	mStateStack.registerState<SettingsState>(States::Settings);
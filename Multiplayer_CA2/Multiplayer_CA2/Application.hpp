@@ -7,6 +7,7 @@
 #include "StateStack.hpp"
 #include "MusicPlayer.hpp"
 #include "SoundPlayer.hpp"
+#include "JobSystem.hpp"
 
 #include <SFML/System/Time.hpp>
 #include <SFML/Graphics/RenderWindow.hpp>
@@ -40,6 +41,7 @@ class Application
 
 		KeyBinding				mKeyBinding1;
 		KeyBinding				mKeyBinding2;
+		JobSystem				mJobs;
 		StateStack				mStateStack;
 
 		sf::Text				mStatisticsText;
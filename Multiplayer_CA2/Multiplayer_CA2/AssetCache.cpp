@@ -0,0 +1,112 @@
+//D00137655 - Jason Lynch
+//D00194504 - Dylan
+#include "AssetCache.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#ifdef _WIN32
+	#include <direct.h>
+#else
+	#include <sys/stat.h>
+#endif
+
+
+AssetCache::AssetCache(const std::string& directory)
+: mDirectory(directory)
+, mDownloads()
+{
+	// Fails harmlessly when the directory already exists
+#ifdef _WIN32
+	_mkdir(mDirectory.c_str());
+#else
+	mkdir(mDirectory.c_str(), 0755);
+#endif
+}
+
+// 64 bit FNV-1a, collisions between a handful of arena files are not a concern
+sf::Uint64 AssetCache::computeHash(const void* data, std::size_t size)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+	sf::Uint64 hash = 14695981039346656037ULL;
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+bool AssetCache::contains(sf::Uint64 hash) const
+{
+	std::ifstream file(getPath(hash).c_str(), std::ios::binary);
+	return file.is_open();
+}
+
+std::string AssetCache::getPath(sf::Uint64 hash) const
+{
+	std::ostringstream path;
+	path << mDirectory << "/" << std::hex << std::setw(16) << std::setfill('0') << hash << ".blob";
+	return path.str();
+}
+
+void AssetCache::beginDownload(sf::Uint64 hash, std::size_t size)
+{
+	Download& download = mDownloads[hash];
+	download.data.assign(size, 0);
+	download.received = 0;
+}
+
+bool AssetCache::receiveChunk(sf::Uint64 hash, std::size_t offset, const void* data, std::size_t size)
+{
+	auto found = mDownloads.find(hash);
+	if (found == mDownloads.end())
+		return false;
+
+	// Chunks arrive in order over TCP; anything else means the stream is broken and the download starts over next join
+	Download& download = found->second;
+	if (offset != download.received || offset + size > download.data.size())
+	{
+		mDownloads.erase(found);
+		return false;
+	}
+
+	if (size > 0)
+		std::memcpy(&download.data[offset], data, size);
+	download.received += size;
+
+	if (download.received < download.data.size())
+		return false;
+
+	bool stored = store(hash, download.data);
+	mDownloads.erase(found);
+	return stored;
+}
+
+bool AssetCache::store(sf::Uint64 hash, const std::vector<char>& data)
+{
+	if (computeHash(data.empty() ? nullptr : &data[0], data.size()) != hash)
+		return false;
+
+	// Written under a temporary name first, so a cached blob is always complete
+	std::string path = getPath(hash);
+	std::string temporary = path + ".part";
+	{
+		std::ofstream file(temporary.c_str(), std::ios::binary | std::ios::trunc);
+		if (!data.empty())
+			file.write(&data[0], data.size());
+		if (!file)
+			return false;
+	}
+
+	// Another client on this machine may have finished the same blob first, which is just as good
+	if (std::rename(temporary.c_str(), path.c_str()) != 0)
+		std::remove(temporary.c_str());
+
+	return contains(hash);
+}
@@ -0,0 +1,45 @@
+#ifndef BOOK_ASSETCACHE_HPP
+#define BOOK_ASSETCACHE_HPP
+
+#include <SFML/Config.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+
+
+// Client side store of the blobs match servers hand out, kept on disk under their content hash.
+// A blob that is already cached never transfers again, whatever server or asset name it comes from.
+class AssetCache
+{
+	public:
+		explicit							AssetCache(const std::string& directory);
+
+		static sf::Uint64					computeHash(const void* data, std::size_t size);
+
+		bool								contains(sf::Uint64 hash) const;
+		std::string							getPath(sf::Uint64 hash) const;
+
+		void								beginDownload(sf::Uint64 hash, std::size_t size);
+		// True once the last chunk is in and the blob was verified and written to disk
+		bool								receiveChunk(sf::Uint64 hash, std::size_t offset, const void* data, std::size_t size);
+
+
+	private:
+		struct Download
+		{
+			std::vector<char>				data;
+			std::size_t						received;
+		};
+
+
+	private:
+		bool								store(sf::Uint64 hash, const std::vector<char>& data);
+
+
+	private:
+		std::string							mDirectory;
+		std::map<sf::Uint64, Download>		mDownloads;
+};
+
+#endif // BOOK_ASSETCACHE_HPP
@@ -0,0 +1,116 @@
+//D00137655 - Jason Lynch
+//D00194504 - Dylan
+#include "AsyncConnector.hpp"
+
+
+namespace
+{
+	// Long enough for a slow link, short enough that a server still starting up (the host's own) is retried quickly
+	const sf::Time AttemptTimeout = sf::seconds(1.f);
+}
+
+AsyncConnector::AsyncConnector(sf::TcpSocket& socket)
+: mSocket(socket)
+, mStatus(Idle)
+, mAddress()
+, mPort(0)
+, mTimeout(sf::Time::Zero)
+, mClock()
+, mAttemptClock()
+, mAttemptCount(0)
+{
+}
+
+void AsyncConnector::start(const sf::IpAddress& address, unsigned short port, sf::Time timeout)
+{
+	mAddress = address;
+	mPort = port;
+	mTimeout = timeout;
+	retry();
+}
+
+void AsyncConnector::retry()
+{
+	mStatus = Connecting;
+	mAttemptCount = 0;
+	mClock.restart();
+	beginAttempt();
+}
+
+void AsyncConnector::cancel()
+{
+	if (mStatus == Connecting)
+	{
+		mSocket.disconnect();
+		mStatus = Cancelled;
+	}
+}
+
+AsyncConnector::Status AsyncConnector::update()
+{
+	if (mStatus != Connecting)
+		return mStatus;
+
+	// The peer address only resolves once the handshake has completed
+	if (mSocket.getRemoteAddress() != sf::IpAddress::None)
+	{
+		mStatus = Connected;
+		return mStatus;
+	}
+
+	if (mClock.getElapsedTime() >= mTimeout)
+	{
+		mSocket.disconnect();
+		mStatus = Failed;
+	}
+	else if (mAttemptClock.getElapsedTime() >= AttemptTimeout)
+	{
+		beginAttempt();
+	}
+
+	return mStatus;
+}
+
+AsyncConnector::Status AsyncConnector::getStatus() const
+{
+	return mStatus;
+}
+
+sf::Time AsyncConnector::getElapsedTime() const
+{
+	return mClock.getElapsedTime();
+}
+
+std::size_t AsyncConnector::getAttemptCount() const
+{
+	return mAttemptCount;
+}
+
+const sf::IpAddress& AsyncConnector::getAddress() const
+{
+	return mAddress;
+}
+
+unsigned short AsyncConnector::getPort() const
+{
+	return mPort;
+}
+
+void AsyncConnector::beginAttempt()
+{
+	++mAttemptCount;
+	mAttemptClock.restart();
+
+	// connect() closes whatever the socket had before, including an attempt still in progress
+	mSocket.setBlocking(false);
+	sf::Socket::Status status = mSocket.connect(mAddress, mPort);
+
+	// Anything else (e.g. refused straight away) is retried after the attempt timeout, unless it can never succeed
+	if (status == sf::Socket::Done)
+		mStatus = Connected;
+	else if (mAddress == sf::IpAddress::None)
+	{
+		mSocket.disconnect();
+		mStatus = Failed;
+	}
+}
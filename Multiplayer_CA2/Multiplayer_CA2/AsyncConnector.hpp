@@ -0,0 +1,59 @@
+#ifndef BOOK_ASYNCCONNECTOR_HPP
+#define BOOK_ASYNCCONNECTOR_HPP
+
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/Time.hpp>
+#include <SFML/System/NonCopyable.hpp>
+#include <SFML/Network/TcpSocket.hpp>
+#include <SFML/Network/IpAddress.hpp>
+
+
+// Non-blocking TCP connect for a socket owned by the caller, polled once per frame. Refused attempts look the same
+// as slow ones on a non-blocking socket, so each attempt gets a short timeout and is retried until the overall one.
+// Connectors share nothing, any number of them can be in flight at once.
+class AsyncConnector : private sf::NonCopyable
+{
+	public:
+		enum Status
+		{
+			Idle,
+			Connecting,
+			Connected,
+			Failed,
+			Cancelled
+		};
+
+
+	public:
+		explicit				AsyncConnector(sf::TcpSocket& socket);
+
+		void					start(const sf::IpAddress& address, unsigned short port, sf::Time timeout);
+		void					retry();
+		void					cancel();
+		Status					update();
+
+		Status					getStatus() const;
+		sf::Time				getElapsedTime() const;
+		std::size_t				getAttemptCount() const;
+		const sf::IpAddress&	getAddress() const;
+		unsigned short			getPort() const;
+
+
+	private:
+		void					beginAttempt();
+
+
+	private:
+		sf::TcpSocket&			mSocket;
+		Status					mStatus;
+
+		sf::IpAddress			mAddress;
+		unsigned short			mPort;
+		sf::Time				mTimeout;
+
+		sf::Clock				mClock;
+		sf::Clock				mAttemptClock;
+		std::size_t				mAttemptCount;
+};
+
+#endif // BOOK_ASYNCCONNECTOR_HPP
@@ -0,0 +1,92 @@
+//D00137655 - Jason Lynch
+//D00194504 - Dylan
+#include "CategoryIndex.hpp"
+#include "SceneNode.hpp"
+#include "Command.hpp"
+
+#include <cassert>
+
+
+CategoryIndex::CategoryIndex()
+: mHeads()
+, mTails()
+{
+	mHeads.fill(nullptr);
+	mTails.fill(nullptr);
+}
+
+void CategoryIndex::dispatch(const Command& command, sf::Time dt) const
+{
+	for (std::size_t list = 0; list < ListCount; ++list)
+	{
+		if (!(command.category & (1u << list)) || !mHeads[list])
+			continue;
+
+		// Actions may attach nodes (e.g. firing); those joined after the command was issued are left out
+		SceneNode* last = mTails[list];
+		for (SceneNode* node = mHeads[list]; node; )
+		{
+			SceneNode* next = node->mIndexNext;
+			command.action(*node, dt);
+
+			if (node == last)
+				break;
+			node = next;
+		}
+	}
+}
+
+void CategoryIndex::insert(SceneNode& node)
+{
+	assert(!node.mCategoryIndex);
+	node.mCategoryIndex = this;
+	node.mIndexList = ListCount;
+
+	// Uncategorized nodes (layers, sprites, ...) still belong to the index so their children join it, but no list
+	unsigned int category = node.getCategory();
+	if (category == Category::None)
+		return;
+
+	// Every node type reports exactly one category bit, the combined ones only exist as command masks
+	assert((category & (category - 1)) == 0);
+
+	std::size_t list = 0;
+	while (!(category & (1u << list)))
+		++list;
+
+	node.mIndexList = list;
+	node.mIndexPrev = mTails[list];
+	node.mIndexNext = nullptr;
+
+	if (mTails[list])
+		mTails[list]->mIndexNext = &node;
+	else
+		mHeads[list] = &node;
+	mTails[list] = &node;
+}
+
+void CategoryIndex::remove(SceneNode& node)
+{
+	if (node.mCategoryIndex != this)
+		return;
+
+	node.mCategoryIndex = nullptr;
+
+	std::size_t list = node.mIndexList;
+	if (list == ListCount)
+		return;
+
+	if (node.mIndexPrev)
+		node.mIndexPrev->mIndexNext = node.mIndexNext;
+	else
+		mHeads[list] = node.mIndexNext;
+
+	if (node.mIndexNext)
+		node.mIndexNext->mIndexPrev = node.mIndexPrev;
+	else
+		mTails[list] = node.mIndexPrev;
+
+	node.mIndexList = ListCount;
+	node.mIndexPrev = nullptr;
+	node.mIndexNext = nullptr;
+}
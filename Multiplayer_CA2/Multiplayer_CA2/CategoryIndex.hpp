@@ -0,0 +1,37 @@
+#ifndef BOOK_CATEGORYINDEX_HPP
+#define BOOK_CATEGORYINDEX_HPP
+
+#include <SFML/System/NonCopyable.hpp>
+#include <SFML/System/Time.hpp>
+
+#include <array>
+
+
+class SceneNode;
+struct Command;
+
+// One intrusive list per category bit, threaded through the scene nodes themselves. Nodes join when
+// they are attached below an indexed root and leave when they are detached or destroyed, so delivering
+// a command only visits the nodes of its categories instead of the whole scene graph.
+class CategoryIndex : private sf::NonCopyable
+{
+	public:
+											CategoryIndex();
+
+		// Every node of the command's categories, in the order they joined
+		void								dispatch(const Command& command, sf::Time dt) const;
+
+		void								insert(SceneNode& node);
+		void								remove(SceneNode& node);
+
+
+	public:
+		static const std::size_t			ListCount = 32;		// Also the list number of nodes that are in no list
+
+
+	private:
+		std::array<SceneNode*, ListCount>	mHeads;
+		std::array<SceneNode*, ListCount>	mTails;
+};
+
+#endif // BOOK_CATEGORYINDEX_HPP
@@ -0,0 +1,183 @@
+//D00137655 - Jason Lynch
+//D00194504 - Dylan
+#include "CollisionGrid.hpp"
+#include "JobSystem.hpp"
+#include "Foreach.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace
+{
+	// Bounding rects per job; a job should be worth more than the queueing it costs
+	const std::size_t BoundsBatchSize = 64;
+
+	// Cell chunks per thread, so a thread left with a crowded chunk gets the others' help
+	const std::size_t ChunksPerThread = 4;
+}
+
+CollisionGrid::CollisionGrid(float cellSize, JobSystem& jobs)
+: mCellSize(cellSize)
+, mJobs(jobs)
+, mRules()
+, mCategoryMask(0)
+, mNodes()
+, mProxies()
+, mColliders()
+, mEntries()
+, mCellStarts()
+, mChunks()
+{
+}
+
+void CollisionGrid::addRule(unsigned int first, unsigned int second)
+{
+	Rule rule = { first, second };
+	mRules.push_back(rule);
+	mCategoryMask |= first | second;
+}
+
+void CollisionGrid::addProxy(std::size_t proxy, const sf::FloatRect& bounds, unsigned int category)
+{
+	if (!(category & mCategoryMask))
+		return;
+
+	Collider collider = { nullptr, proxy, bounds, category };
+	mProxies.push_back(collider);
+}
+
+void CollisionGrid::computePairs(SceneNode& sceneGraph, std::vector<SceneNode::Pair>& pairs, std::vector<ProxyPair>& proxyPairs)
+{
+	pairs.clear();
+	proxyPairs.clear();
+
+	mNodes.clear();
+	sceneGraph.collectNodes(mCategoryMask, mNodes);
+
+	// Bounding rects are world space and walk the parent chain, so they are computed once per node.
+	// Each job only writes its own slots; collectNodes() has already cached the parents' transforms.
+	mColliders.resize(mNodes.size());
+	std::size_t boundsBatches = (mNodes.size() + BoundsBatchSize - 1) / BoundsBatchSize;
+	mJobs.parallelFor(boundsBatches, [this] (std::size_t batch)
+	{
+		std::size_t end = std::min(mNodes.size(), (batch + 1) * BoundsBatchSize);
+		for (std::size_t i = batch * BoundsBatchSize; i < end; ++i)
+		{
+			Collider collider = { mNodes[i], 0, mNodes[i]->getBoundingRect(), mNodes[i]->getCategory() };
+			mColliders[i] = collider;
+		}
+	});
+
+	mColliders.insert(mColliders.end(), mProxies.begin(), mProxies.end());
+	mProxies.clear();
+
+	mEntries.clear();
+	for (std::size_t c = 0; c < mColliders.size(); ++c)
+	{
+		const Collider& collider = mColliders[c];
+		sf::Uint32 index = static_cast<sf::Uint32>(c);
+
+		sf::Int32 left = getCellCoordinate(collider.bounds.left);
+		sf::Int32 top = getCellCoordinate(collider.bounds.top);
+		sf::Int32 right = getCellCoordinate(collider.bounds.left + collider.bounds.width);
+		sf::Int32 bottom = getCellCoordinate(collider.bounds.top + collider.bounds.height);
+
+		for (sf::Int32 y = top; y <= bottom; ++y)
+		{
+			for (sf::Int32 x = left; x <= right; ++x)
+			{
+				CellEntry entry = { makeCellKey(x, y), index };
+				mEntries.push_back(entry);
+			}
+		}
+	}
+
+	// Sorting groups the entries cell by cell; colliders keep scene graph order inside a cell,
+	// which keeps the pair order independent of where the nodes happen to live in memory
+	std::sort(mEntries.begin(), mEntries.end(), [] (const CellEntry& lhs, const CellEntry& rhs)
+	{
+		return lhs.cell < rhs.cell || (lhs.cell == rhs.cell && lhs.collider < rhs.collider);
+	});
+
+	mCellStarts.clear();
+	for (std::size_t i = 0; i < mEntries.size(); ++i)
+	{
+		if (i == 0 || mEntries[i].cell != mEntries[i - 1].cell)
+			mCellStarts.push_back(i);
+	}
+	mCellStarts.push_back(mEntries.size());
+
+	// Cells are independent; each chunk of consecutive cells is tested by one job into its own vectors
+	std::size_t cellCount = mCellStarts.size() - 1;
+	std::size_t chunkCount = std::min(cellCount, mJobs.getThreadCount() * ChunksPerThread);
+	if (mChunks.size() < chunkCount)
+		mChunks.resize(chunkCount);
+
+	mJobs.parallelFor(chunkCount, [this, cellCount, chunkCount] (std::size_t chunk)
+	{
+		mChunks[chunk].pairs.clear();
+		mChunks[chunk].proxyPairs.clear();
+
+		std::size_t lastCell = cellCount * (chunk + 1) / chunkCount;
+		for (std::size_t cell = cellCount * chunk / chunkCount; cell < lastCell; ++cell)
+			findPairs(mCellStarts[cell], mCellStarts[cell + 1], mChunks[chunk]);
+	});
+
+	// Appended in cell order, whichever thread found them
+	for (std::size_t chunk = 0; chunk < chunkCount; ++chunk)
+	{
+		pairs.insert(pairs.end(), mChunks[chunk].pairs.begin(), mChunks[chunk].pairs.end());
+		proxyPairs.insert(proxyPairs.end(), mChunks[chunk].proxyPairs.begin(), mChunks[chunk].proxyPairs.end());
+	}
+}
+
+void CollisionGrid::findPairs(std::size_t begin, std::size_t end, Chunk& chunk) const
+{
+	for (std::size_t i = begin; i < end; ++i)
+	{
+		const Collider& lhs = mColliders[mEntries[i].collider];
+		for (std::size_t j = i + 1; j < end; ++j)
+		{
+			const Collider& rhs = mColliders[mEntries[j].collider];
+			if ((!lhs.node && !rhs.node) || !accepts(lhs.category, rhs.category))
+				continue;
+
+			sf::FloatRect overlap;
+			if (!lhs.bounds.intersects(rhs.bounds, overlap))
+				continue;
+
+			// Two nodes can share several cells; only the one holding the overlap's top left corner reports them
+			if (makeCellKey(getCellCoordinate(overlap.left), getCellCoordinate(overlap.top)) != mEntries[begin].cell)
+				continue;
+
+			if (lhs.node && rhs.node)
+				chunk.pairs.push_back(std::make_pair(lhs.node, rhs.node));
+			else if (lhs.node)
+				chunk.proxyPairs.push_back(std::make_pair(rhs.proxy, lhs.node));
+			else
+				chunk.proxyPairs.push_back(std::make_pair(lhs.proxy, rhs.node));
+		}
+	}
+}
+
+bool CollisionGrid::accepts(unsigned int first, unsigned int second) const
+{
+	FOREACH(const Rule& rule, mRules)
+	{
+		if ((rule.first & first && rule.second & second) || (rule.first & second && rule.second & first))
+			return true;
+	}
+
+	return false;
+}
+
+sf::Int32 CollisionGrid::getCellCoordinate(float position) const
+{
+	return static_cast<sf::Int32>(std::floor(position / mCellSize));
+}
+
+sf::Uint64 CollisionGrid::makeCellKey(sf::Int32 x, sf::Int32 y)
+{
+	return (static_cast<sf::Uint64>(static_cast<sf::Uint32>(y)) << 32) | static_cast<sf::Uint32>(x);
+}
@@ -0,0 +1,90 @@
+#ifndef BOOK_COLLISIONGRID_HPP
+#define BOOK_COLLISIONGRID_HPP
+
+#include "SceneNode.hpp"
+
+#include <SFML/Config.hpp>
+#include <SFML/System/NonCopyable.hpp>
+#include <SFML/Graphics/Rect.hpp>
+
+#include <vector>
+
+
+class JobSystem;
+
+// Uniform grid broadphase over the scene graph. Only nodes whose category takes part in a rule are bucketed,
+// and only pairs that some rule asks for are narrow phase tested, so the cost follows the number of collidable
+// entities and how crowded they are rather than the square of the node count. Bounding rects and the cells'
+// pair tests are spread over the job system; the result is the same as a serial pass would give.
+class CollisionGrid : private sf::NonCopyable
+{
+	public:
+		// A box that is not a scene node (e.g. a ProjectileSystem bullet) and the node it touches
+		typedef std::pair<std::size_t, SceneNode*> ProxyPair;
+
+
+	public:
+										CollisionGrid(float cellSize, JobSystem& jobs);
+
+		// Pairs with one node in each category mask are reported, either way round
+		void							addRule(unsigned int first, unsigned int second);
+
+		// Takes part in the next computePairs() only; proxies are never paired with each other
+		void							addProxy(std::size_t proxy, const sf::FloatRect& bounds, unsigned int category);
+
+		// Every intersecting, not destroyed pair some rule asks for, each exactly once. The vectors are
+		// cleared first and meant to be kept by the caller, so their storage is reused from frame to frame.
+		void							computePairs(SceneNode& sceneGraph, std::vector<SceneNode::Pair>& pairs, std::vector<ProxyPair>& proxyPairs);
+
+
+	private:
+		struct Rule
+		{
+			unsigned int				first;
+			unsigned int				second;
+		};
+
+		struct Collider
+		{
+			SceneNode*					node;			// nullptr for proxies
+			std::size_t					proxy;
+			sf::FloatRect				bounds;
+			unsigned int				category;
+		};
+
+		struct CellEntry
+		{
+			sf::Uint64					cell;
+			sf::Uint32					collider;
+		};
+
+		// Pairs found in one consecutive range of cells
+		struct Chunk
+		{
+			std::vector<SceneNode::Pair>	pairs;
+			std::vector<ProxyPair>		proxyPairs;
+		};
+
+
+	private:
+		void							findPairs(std::size_t begin, std::size_t end, Chunk& chunk) const;
+		bool							accepts(unsigned int first, unsigned int second) const;
+		sf::Int32						getCellCoordinate(float position) const;
+		static sf::Uint64				makeCellKey(sf::Int32 x, sf::Int32 y);
+
+
+	private:
+		float							mCellSize;
+		JobSystem&						mJobs;
+		std::vector<Rule>				mRules;
+		unsigned int					mCategoryMask;
+
+		std::vector<SceneNode*>			mNodes;
+		std::vector<Collider>			mProxies;
+		std::vector<Collider>			mColliders;
+		std::vector<CellEntry>			mEntries;
+		std::vector<std::size_t>		mCellStarts;	// Index of each cell's first entry, plus the end
+		std::vector<Chunk>				mChunks;
+};
+
+#endif // BOOK_COLLISIONGRID_HPP
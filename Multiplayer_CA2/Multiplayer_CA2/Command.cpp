@@ -6,5 +6,6 @@
 Command::Command()
 : action()
 , category(Category::None)
+, tankIdentifier(0)
 {
 }
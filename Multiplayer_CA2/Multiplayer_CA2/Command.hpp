@@ -2,10 +2,10 @@
 #define BOOK_COMMAND_HPP
 
 #include "Category.hpp"
+#include "CommandAction.hpp"
 
 #include <SFML/System/Time.hpp>
 
-#include <functional>
 #include <cassert>
 
 
@@ -13,12 +13,13 @@ class SceneNode;
 
 struct Command
 {
-	typedef std::function<void(SceneNode&, sf::Time)> Action;
+	typedef CommandAction Action;
 
 								Command();
 
 	Action						action;
 	unsigned int				category;
+	int							tankIdentifier;		// When set, only that tank receives the command (if it is in the category)
 };
 
 template <typename GameObject, typename Function>
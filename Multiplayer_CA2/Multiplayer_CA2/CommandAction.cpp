@@ -0,0 +1,54 @@
+//D00137655 - Jason Lynch
+//D00194504 - Dylan
+#include "CommandAction.hpp"
+
+#include <cassert>
+
+
+CommandAction::CommandAction()
+: mHandlers(nullptr)
+{
+}
+
+CommandAction::CommandAction(const CommandAction& other)
+: mHandlers(other.mHandlers)
+{
+	if (mHandlers)
+		mHandlers->copy(&mStorage, &other.mStorage);
+}
+
+CommandAction& CommandAction::operator= (const CommandAction& other)
+{
+	if (this != &other)
+	{
+		reset();
+		if (other.mHandlers)
+			other.mHandlers->copy(&mStorage, &other.mStorage);
+		mHandlers = other.mHandlers;
+	}
+
+	return *this;
+}
+
+CommandAction::~CommandAction()
+{
+	reset();
+}
+
+void CommandAction::operator() (SceneNode& node, sf::Time dt) const
+{
+	assert(mHandlers);
+	mHandlers->invoke(&mStorage, node, dt);
+}
+
+CommandAction::operator bool() const
+{
+	return mHandlers != nullptr;
+}
+
+void CommandAction::reset()
+{
+	if (mHandlers)
+		mHandlers->destroy(&mStorage);
+	mHandlers = nullptr;
+}
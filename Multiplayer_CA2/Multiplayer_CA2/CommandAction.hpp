@@ -0,0 +1,65 @@
+#ifndef BOOK_COMMANDACTION_HPP
+#define BOOK_COMMANDACTION_HPP
+
+#include <SFML/System/Time.hpp>
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+
+class SceneNode;
+
+// Stands in for std::function<void(SceneNode&, sf::Time)> in commands. The callable is kept inline and
+// reached through a handler table generated per callable type at compile time, so creating, copying and
+// queueing a command never allocates. Captures larger than Capacity are a compile error, not a heap fallback.
+class CommandAction
+{
+	public:
+		static const std::size_t				Capacity = 4 * sizeof(void*);
+
+
+	public:
+												CommandAction();
+												CommandAction(const CommandAction& other);
+		CommandAction&							operator= (const CommandAction& other);
+												~CommandAction();
+
+		template <typename Function, typename = typename std::enable_if<!std::is_same<typename std::decay<Function>::type, CommandAction>::value>::type>
+												CommandAction(Function fn);
+
+		void									operator() (SceneNode& node, sf::Time dt) const;
+		explicit								operator bool() const;
+
+
+	private:
+		struct Handlers
+		{
+			void								(*invoke)(const void* function, SceneNode& node, sf::Time dt);
+			void								(*copy)(void* destination, const void* source);
+			void								(*destroy)(void* function);
+		};
+
+		template <typename Function>
+		struct HandlerTable
+		{
+			static void							invoke(const void* function, SceneNode& node, sf::Time dt);
+			static void							copy(void* destination, const void* source);
+			static void							destroy(void* function);
+
+			static const Handlers				table;
+		};
+
+
+	private:
+		void									reset();
+
+
+	private:
+		const Handlers*							mHandlers;
+		typename std::aligned_storage<Capacity, alignof(std::max_align_t)>::type mStorage;
+};
+
+#include "CommandAction.inl"
+#endif // BOOK_COMMANDACTION_HPP
@@ -0,0 +1,35 @@
+template <typename Function>
+const CommandAction::Handlers CommandAction::HandlerTable<Function>::table =
+{
+	&CommandAction::HandlerTable<Function>::invoke,
+	&CommandAction::HandlerTable<Function>::copy,
+	&CommandAction::HandlerTable<Function>::destroy
+};
+
+template <typename Function>
+void CommandAction::HandlerTable<Function>::invoke(const void* function, SceneNode& node, sf::Time dt)
+{
+	(*static_cast<const Function*>(function))(node, dt);
+}
+
+template <typename Function>
+void CommandAction::HandlerTable<Function>::copy(void* destination, const void* source)
+{
+	new (destination) Function(*static_cast<const Function*>(source));
+}
+
+template <typename Function>
+void CommandAction::HandlerTable<Function>::destroy(void* function)
+{
+	static_cast<Function*>(function)->~Function();
+}
+
+template <typename Function, typename>
+CommandAction::CommandAction(Function fn)
+: mHandlers(&HandlerTable<Function>::table)
+{
+	static_assert(sizeof(Function) <= Capacity, "CommandAction - captures too large, capture a pointer instead");
+	static_assert(alignof(Function) <= alignof(std::max_align_t), "CommandAction - over-aligned callable");
+
+	new (&mStorage) Function(std::move(fn));
+}
@@ -4,19 +4,54 @@
 #include "SceneNode.hpp"
 
 
+namespace
+{
+	const std::size_t InitialCapacity = 256;
+}
+
+CommandQueue::CommandQueue()
+: mBuffer(InitialCapacity)
+, mHead(0)
+, mCount(0)
+{
+}
+
 void CommandQueue::push(const Command& command)
 {
-	mQueue.push(command);
+	if (mCount == mBuffer.size())
+		grow();
+
+	mBuffer[(mHead + mCount) & (mBuffer.size() - 1)] = command;
+	++mCount;
 }
 
 Command CommandQueue::pop()
 {
-	Command command = mQueue.front();
-	mQueue.pop();
+	Command& slot = mBuffer[mHead];
+	Command command = slot;
+	slot.action = Command::Action();
+
+	mHead = (mHead + 1) & (mBuffer.size() - 1);
+	--mCount;
+
+	// World drains the queue every frame, so each frame starts again at the front of the buffer
+	if (mCount == 0)
+		mHead = 0;
+
 	return command;
 }
 
 bool CommandQueue::isEmpty() const
 {
-	return mQueue.empty();
+	return mCount == 0;
+}
+
+void CommandQueue::grow()
+{
+	std::vector<Command> buffer(mBuffer.size() * 2);
+	for (std::size_t i = 0; i < mCount; ++i)
+		buffer[i] = mBuffer[(mHead + i) & (mBuffer.size() - 1)];
+
+	mBuffer.swap(buffer);
+	mHead = 0;
 }
@@ -3,19 +3,29 @@
 
 #include "Command.hpp"
 
-#include <queue>
+#include <vector>
 
 
+// Ring buffer of commands. It only grows when a frame queues more commands than any frame before,
+// so once the game is running pushing and popping never touches the heap.
 class CommandQueue
 {
 	public:
+									CommandQueue();
+
 		void						push(const Command& command);
 		Command						pop();
 		bool						isEmpty() const;
 
-		
+
+	private:
+		void						grow();
+
+
 	private:
-		std::queue<Command>			mQueue;
+		std::vector<Command>		mBuffer;		// Size is a power of two
+		std::size_t					mHead;
+		std::size_t					mCount;
 };
 
 #endif // BOOK_COMMANDQUEUE_HPP
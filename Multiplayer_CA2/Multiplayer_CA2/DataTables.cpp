@@ -302,3 +302,26 @@ std::vector<ObstacleData> initializeObstacleData() //Obstacle data. Holds possib
 
 	return data;
 }
+
+std::vector<ArenaAssetData> initializeArenaAssetData()
+{
+	std::vector<ArenaAssetData> data(4);
+
+	data[0].name = "arena/background";
+	data[0].filename = "Media/Textures/Gamebackground.png";
+	data[0].texture = Textures::ID::Jungle;
+
+	data[1].name = "arena/wall";
+	data[1].filename = "Media/Textures/Arena/Blocks/Block_B_01.png";
+	data[1].texture = Textures::ID::Wall;
+
+	data[2].name = "arena/building";
+	data[2].filename = "Media/Textures/Arena/Buildings/Building_B_02.png";
+	data[2].texture = Textures::ID::DestructableWall;
+
+	data[3].name = "arena/barrel";
+	data[3].filename = "Media/Textures/Barell_01.png";
+	data[3].texture = Textures::ID::Barrel;
+
+	return data;
+}
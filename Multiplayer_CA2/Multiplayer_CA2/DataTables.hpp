@@ -9,6 +9,7 @@
 #include <SFML/Graphics/Rect.hpp>
 
 #include <vector>
+#include <string>
 #include <functional>
 
 
@@ -60,6 +61,14 @@ struct PickupData
 	sf::IntRect						textureRect;
 };
 
+// Arena files a match server hands to joining clients; the name is what both sides agree on
+struct ArenaAssetData
+{
+	std::string						name;
+	std::string						filename;
+	Textures::ID					texture;
+};
+
 struct ParticleData
 {
 	sf::Color						color;
@@ -72,5 +81,6 @@ std::vector<ProjectileData>	initializeProjectileData();
 std::vector<PickupData>		initializePickupData();
 std::vector<ParticleData>	initializeParticleData();
 std::vector<ObstacleData>	initializeObstacleData();
+std::vector<ArenaAssetData>	initializeArenaAssetData();
 
 #endif // BOOK_DATATABLES_HPP
@@ -37,6 +37,12 @@ void EmitterNode::updateCurrent(sf::Time dt, CommandQueue& commands)
 	}
 }
 
+void EmitterNode::resetCurrent()
+{
+	// The particle system found earlier lives as long as the world, and with it the pool this emitter is in
+	mAccumulatedTime = sf::Time::Zero;
+}
+
 void EmitterNode::emitParticles(sf::Time dt)
 {
 	const float emissionRate = 30.f;
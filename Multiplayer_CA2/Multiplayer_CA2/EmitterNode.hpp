@@ -15,6 +15,7 @@ class EmitterNode : public SceneNode
 
 	private:
 		virtual void			updateCurrent(sf::Time dt, CommandQueue& commands);
+		virtual void			resetCurrent();
 		
 		void					emitParticles(sf::Time dt);
 
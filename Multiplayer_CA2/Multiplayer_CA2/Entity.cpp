@@ -1,6 +1,7 @@
 //D00137655 - Jason Lynch
 //D00194504 - Dylan
 #include "Entity.hpp"
+#include "FixedPoint.hpp"
 
 #include <cassert>
 
@@ -8,9 +9,19 @@
 Entity::Entity(int hitpoints)
 : mVelocity()
 , mHitpoints(hitpoints)
+, mReplication()
+, mDeterministic(false)
+, mEntityTable(nullptr)
+, mHandle()
 {
 }
 
+Entity::~Entity()
+{
+	if (mEntityTable)
+		mEntityTable->remove(*this);
+}
+
 void Entity::setVelocity(sf::Vector2f velocity)
 {
 	mVelocity = velocity;
@@ -47,6 +58,7 @@ void Entity::setHitpoints(int points)
 {
 	assert(points > 0);
 	mHitpoints = points;
+	mReplication.markDirty(ReplicationComponent::Hitpoints);
 }
 
 void Entity::repair(int points)
@@ -54,6 +66,7 @@ void Entity::repair(int points)
 	assert(points > 0);
 
 	mHitpoints += points;
+	mReplication.markDirty(ReplicationComponent::Hitpoints);
 }
 
 void Entity::damage(int points)
@@ -61,11 +74,13 @@ void Entity::damage(int points)
 	assert(points > 0);
 
 	mHitpoints -= points;
+	mReplication.markDirty(isDestroyed() ? ReplicationComponent::Hitpoints | ReplicationComponent::Destroyed : ReplicationComponent::Hitpoints);
 }
 
 void Entity::destroy()
 {
 	mHitpoints = 0;
+	mReplication.markDirty(ReplicationComponent::Hitpoints | ReplicationComponent::Destroyed);
 }
 
 void Entity::remove()
@@ -78,7 +93,58 @@ bool Entity::isDestroyed() const
 	return mHitpoints <= 0;
 }
 
+ReplicationComponent& Entity::getReplication()
+{
+	return mReplication;
+}
+
+const ReplicationComponent& Entity::getReplication() const
+{
+	return mReplication;
+}
+
+void Entity::setDeterministic(bool deterministic)
+{
+	mDeterministic = deterministic;
+}
+
+bool Entity::isDeterministic() const
+{
+	return mDeterministic;
+}
+
+EntityHandle Entity::getHandle() const
+{
+	return mHandle;
+}
+
+void Entity::resetEntity(int hitpoints)
+{
+	mVelocity = sf::Vector2f();
+	mHitpoints = hitpoints;
+	mReplication = ReplicationComponent();
+}
+
+void Entity::recycleCurrent()
+{
+	// Whoever held a handle to the previous life of this node must not find it while it waits in the pool
+	if (mEntityTable)
+		mEntityTable->remove(*this);
+}
+
 void Entity::updateCurrent(sf::Time dt, CommandQueue&)
 {	
-	move(mVelocity * dt.asSeconds());
+	if (mDeterministic)
+	{
+		FixedVector position(getPosition());
+		position += FixedVector(mVelocity) * Fixed::fromTime(dt);
+		setPosition(position.toVector2f());
+	}
+	else
+	{
+		move(mVelocity * dt.asSeconds());
+	}
+
+	if (mVelocity != sf::Vector2f())
+		mReplication.markDirty(ReplicationComponent::Position);
 }
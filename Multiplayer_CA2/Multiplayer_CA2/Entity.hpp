@@ -2,12 +2,15 @@
 #define BOOK_ENTITY_HPP
 
 #include "SceneNode.hpp"
+#include "ReplicationComponent.hpp"
+#include "EntityTable.hpp"
 
 
 class Entity : public SceneNode
 {
 	public:
 		explicit			Entity(int hitpoints);
+							~Entity();
 
 		void				setVelocity(sf::Vector2f velocity);
 		void				setVelocity(float vx, float vy);
@@ -23,14 +26,35 @@ class Entity : public SceneNode
 		virtual void		remove();
 		virtual bool		isDestroyed() const;
 
+		ReplicationComponent&		getReplication();
+		const ReplicationComponent&	getReplication() const;
+
+		// Deterministic entities integrate their motion in fixed point, see World::setDeterministic()
+		void				setDeterministic(bool deterministic);
+		bool				isDeterministic() const;
+
+		// Empty unless the entity was inserted into an EntityTable
+		EntityHandle		getHandle() const;
+
 
 	protected:
 		virtual void		updateCurrent(sf::Time dt, CommandQueue& commands);
+		// For resetCurrent() of pooled entities: alive again, at rest and not replicated
+		void				resetEntity(int hitpoints);
+		// Leaves the EntityTable as soon as a pooled entity is given back, so handles to it fail from then on
+		virtual void		recycleCurrent();
 
 
 	private:
 		sf::Vector2f		mVelocity;
 		int					mHitpoints;
+		ReplicationComponent	mReplication;
+		bool				mDeterministic;
+
+		EntityTable*		mEntityTable;
+		EntityHandle		mHandle;
+
+		friend class EntityTable;
 };
 
 #endif // BOOK_ENTITY_HPP
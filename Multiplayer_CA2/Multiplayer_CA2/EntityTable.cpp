@@ -0,0 +1,77 @@
+//D00137655 - Jason Lynch
+//D00194504 - Dylan
+#include "EntityTable.hpp"
+#include "Entity.hpp"
+
+#include <cassert>
+
+
+namespace
+{
+	const sf::Uint32 NoSlot = 0xFFFFFFFF;
+}
+
+EntityHandle::EntityHandle()
+: index(NoSlot)
+, generation(0)
+{
+}
+
+EntityTable::EntityTable()
+: mSlots()
+, mFirstFree(NoSlot)
+{
+}
+
+EntityHandle EntityTable::insert(Entity& entity)
+{
+	assert(!entity.mEntityTable);
+
+	sf::Uint32 index = mFirstFree;
+	if (index != NoSlot)
+	{
+		mFirstFree = mSlots[index].nextFree;
+	}
+	else
+	{
+		Slot slot = { nullptr, 1, NoSlot };
+		index = static_cast<sf::Uint32>(mSlots.size());
+		mSlots.push_back(slot);
+	}
+
+	Slot& slot = mSlots[index];
+	slot.entity = &entity;
+
+	EntityHandle handle;
+	handle.index = index;
+	handle.generation = slot.generation;
+
+	entity.mEntityTable = this;
+	entity.mHandle = handle;
+	return handle;
+}
+
+Entity* EntityTable::get(EntityHandle handle) const
+{
+	if (handle.index >= mSlots.size() || mSlots[handle.index].generation != handle.generation)
+		return nullptr;
+
+	return mSlots[handle.index].entity;
+}
+
+void EntityTable::remove(Entity& entity)
+{
+	Slot& slot = mSlots[entity.mHandle.index];
+	assert(slot.entity == &entity);
+
+	// Every handle given out for this slot so far stops matching; zero stays reserved for empty handles
+	slot.entity = nullptr;
+	if (++slot.generation == 0)
+		slot.generation = 1;
+
+	slot.nextFree = mFirstFree;
+	mFirstFree = entity.mHandle.index;
+
+	entity.mEntityTable = nullptr;
+	entity.mHandle = EntityHandle();
+}
@@ -0,0 +1,54 @@
+#ifndef BOOK_ENTITYTABLE_HPP
+#define BOOK_ENTITYTABLE_HPP
+
+#include <SFML/Config.hpp>
+#include <SFML/System/NonCopyable.hpp>
+
+#include <vector>
+
+
+class Entity;
+
+// Refers to an entity without keeping a pointer to it. The generation changes whenever the slot is freed,
+// so a handle to an entity that has since been destroyed or recycled finds nothing instead of dangling.
+struct EntityHandle
+{
+							EntityHandle();
+
+	sf::Uint32				index;
+	sf::Uint32				generation;		// Zero is never handed out, default handles are always empty
+};
+
+// Slots of entities that others refer to across frames. Entities leave the table on their own when they are
+// destroyed or returned to a pool (e.g. by removeWrecks()), and their slots are reused by later entities.
+class EntityTable : private sf::NonCopyable
+{
+	public:
+								EntityTable();
+
+		EntityHandle			insert(Entity& entity);
+		// nullptr once the entity has left the table
+		Entity*					get(EntityHandle handle) const;
+
+
+	private:
+		struct Slot
+		{
+			Entity*				entity;
+			sf::Uint32			generation;
+			sf::Uint32			nextFree;
+		};
+
+
+	private:
+		void					remove(Entity& entity);
+
+
+	private:
+		std::vector<Slot>		mSlots;
+		sf::Uint32				mFirstFree;
+
+		friend class Entity;
+};
+
+#endif // BOOK_ENTITYTABLE_HPP
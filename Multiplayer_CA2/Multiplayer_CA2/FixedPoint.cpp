@@ -0,0 +1,313 @@
+//D00137655 - Jason Lynch
+//D00194504 - Dylan
+#include "FixedPoint.hpp"
+
+#include <array>
+#include <cmath>
+
+
+namespace
+{
+	// Pi with 30 fraction bits; the tables below are computed in that precision and rounded to 16
+	const sf::Int64 PiQ30 = 3373259426LL;
+	const sf::Int64 OneQ30 = 1LL << 30;
+
+	const int TableSteps = 4096;					// Per turn
+	const int QuarterSteps = TableSteps / 4;
+	const int AtanIterations = 24;
+
+	// Integer division rounds towards zero everywhere, unlike shifting negative numbers it is fully specified
+	sf::Int64 roundedShift(sf::Int64 value, int bits)
+	{
+		sf::Int64 half = 1LL << (bits - 1);
+		return (value >= 0) ? (value + half) / (1LL << bits) : -((-value + half) / (1LL << bits));
+	}
+
+	// Taylor series in Q30 for 0 <= radians <= pi / 2, where it converges to well below the final precision
+	sf::Int64 sineQ30(sf::Int64 radians)
+	{
+		sf::Int64 squared = radians * radians / OneQ30;
+		sf::Int64 term = radians;
+		sf::Int64 sum = radians;
+
+		for (sf::Int64 n = 1; n <= 8; ++n)
+		{
+			term = -(term * squared / OneQ30) / ((2 * n) * (2 * n + 1));
+			sum += term;
+		}
+
+		return sum;
+	}
+
+	// Series in Q30 for 0 < tangent <= 1 / 2
+	sf::Int64 arctangentQ30(sf::Int64 tangent)
+	{
+		sf::Int64 squared = tangent * tangent / OneQ30;
+		sf::Int64 power = tangent;
+		sf::Int64 sum = tangent;
+
+		for (sf::Int64 n = 1; n <= 20; ++n)
+		{
+			power = -(power * squared / OneQ30);
+			sum += power / (2 * n + 1);
+		}
+
+		return sum;
+	}
+
+	struct Tables
+	{
+		Tables()
+		{
+			for (int i = 0; i <= QuarterSteps; ++i)
+				sine[i] = static_cast<sf::Int32>(roundedShift(sineQ30(PiQ30 * i / (2 * QuarterSteps)), 30 - Fixed::FractionBits));
+
+			// CORDIC angles atan(2^-i) in degrees; the first is exactly 45
+			arctangent[0] = 45LL << Fixed::FractionBits;
+			for (int i = 1; i < AtanIterations; ++i)
+				arctangent[i] = arctangentQ30(OneQ30 >> i) * (180LL << Fixed::FractionBits) / PiQ30;
+		}
+
+		std::array<sf::Int32, QuarterSteps + 1>		sine;
+		std::array<sf::Int64, AtanIterations>		arctangent;
+	};
+
+	// Built on first use, which C++11 makes safe from the World's update jobs
+	const Tables& getTables()
+	{
+		static const Tables tables;
+		return tables;
+	}
+
+	sf::Int32 tableSine(int step)
+	{
+		const Tables& tables = getTables();
+		step &= TableSteps - 1;
+
+		int quadrant = step / QuarterSteps;
+		int offset = step % QuarterSteps;
+		switch (quadrant)
+		{
+			case 0:		return tables.sine[offset];
+			case 1:		return tables.sine[QuarterSteps - offset];
+			case 2:		return -tables.sine[offset];
+			default:	return -tables.sine[QuarterSteps - offset];
+		}
+	}
+}
+
+Fixed::Fixed()
+: mRaw(0)
+{
+}
+
+Fixed::Fixed(int value)
+: mRaw(static_cast<sf::Int32>(value * One))
+{
+}
+
+Fixed Fixed::fromRaw(sf::Int32 raw)
+{
+	Fixed fixed;
+	fixed.mRaw = raw;
+	return fixed;
+}
+
+Fixed Fixed::fromFloat(float value)
+{
+	// Scaling by a power of two is exact, lround() rounds the same way everywhere
+	return fromRaw(static_cast<sf::Int32>(std::lround(value * static_cast<float>(One))));
+}
+
+Fixed Fixed::fromTime(sf::Time time)
+{
+	return fromRaw(static_cast<sf::Int32>(time.asMicroseconds() * One / 1000000));
+}
+
+sf::Int32 Fixed::getRaw() const
+{
+	return mRaw;
+}
+
+float Fixed::toFloat() const
+{
+	return static_cast<float>(mRaw) / static_cast<float>(One);
+}
+
+Fixed& Fixed::operator+= (Fixed rhs)
+{
+	mRaw += rhs.mRaw;
+	return *this;
+}
+
+Fixed& Fixed::operator-= (Fixed rhs)
+{
+	mRaw -= rhs.mRaw;
+	return *this;
+}
+
+Fixed& Fixed::operator*= (Fixed rhs)
+{
+	mRaw = static_cast<sf::Int32>(static_cast<sf::Int64>(mRaw) * rhs.mRaw / One);
+	return *this;
+}
+
+Fixed& Fixed::operator/= (Fixed rhs)
+{
+	mRaw = static_cast<sf::Int32>(static_cast<sf::Int64>(mRaw) * One / rhs.mRaw);
+	return *this;
+}
+
+Fixed operator- (Fixed value)
+{
+	return Fixed::fromRaw(-value.getRaw());
+}
+
+Fixed operator+ (Fixed lhs, Fixed rhs)
+{
+	return lhs += rhs;
+}
+
+Fixed operator- (Fixed lhs, Fixed rhs)
+{
+	return lhs -= rhs;
+}
+
+Fixed operator* (Fixed lhs, Fixed rhs)
+{
+	return lhs *= rhs;
+}
+
+Fixed operator/ (Fixed lhs, Fixed rhs)
+{
+	return lhs /= rhs;
+}
+
+bool operator== (Fixed lhs, Fixed rhs)
+{
+	return lhs.getRaw() == rhs.getRaw();
+}
+
+bool operator!= (Fixed lhs, Fixed rhs)
+{
+	return lhs.getRaw() != rhs.getRaw();
+}
+
+bool operator< (Fixed lhs, Fixed rhs)
+{
+	return lhs.getRaw() < rhs.getRaw();
+}
+
+bool operator> (Fixed lhs, Fixed rhs)
+{
+	return lhs.getRaw() > rhs.getRaw();
+}
+
+FixedVector::FixedVector()
+: x()
+, y()
+{
+}
+
+FixedVector::FixedVector(Fixed x, Fixed y)
+: x(x)
+, y(y)
+{
+}
+
+FixedVector::FixedVector(sf::Vector2f vector)
+: x(Fixed::fromFloat(vector.x))
+, y(Fixed::fromFloat(vector.y))
+{
+}
+
+sf::Vector2f FixedVector::toVector2f() const
+{
+	return sf::Vector2f(x.toFloat(), y.toFloat());
+}
+
+FixedVector operator+ (FixedVector lhs, FixedVector rhs)
+{
+	return FixedVector(lhs.x + rhs.x, lhs.y + rhs.y);
+}
+
+FixedVector operator- (FixedVector lhs, FixedVector rhs)
+{
+	return FixedVector(lhs.x - rhs.x, lhs.y - rhs.y);
+}
+
+FixedVector operator* (FixedVector vector, Fixed scalar)
+{
+	return FixedVector(vector.x * scalar, vector.y * scalar);
+}
+
+FixedVector& operator+= (FixedVector& lhs, FixedVector rhs)
+{
+	lhs.x += rhs.x;
+	lhs.y += rhs.y;
+	return lhs;
+}
+
+Fixed fixedSin(Fixed degrees)
+{
+	// Position in table steps with 16 fraction bits, wrapped into one turn
+	const sf::Int64 turn = static_cast<sf::Int64>(TableSteps) << Fixed::FractionBits;
+	sf::Int64 position = static_cast<sf::Int64>(degrees.getRaw()) * TableSteps / 360 % turn;
+	if (position < 0)
+		position += turn;
+
+	int step = static_cast<int>(position >> Fixed::FractionBits);
+	sf::Int64 fraction = position & (Fixed::One - 1);
+
+	sf::Int64 low = tableSine(step);
+	sf::Int64 high = tableSine(step + 1);
+	return Fixed::fromRaw(static_cast<sf::Int32>(low + (high - low) * fraction / Fixed::One));
+}
+
+Fixed fixedCos(Fixed degrees)
+{
+	return fixedSin(degrees + Fixed(90));
+}
+
+Fixed fixedAtan2(Fixed y, Fixed x)
+{
+	if (x == Fixed() && y == Fixed())
+		return Fixed();
+
+	// Headroom for the shifts below; CORDIC grows the vector by about 1.65
+	sf::Int64 vx = static_cast<sf::Int64>(x.getRaw()) * Fixed::One;
+	sf::Int64 vy = static_cast<sf::Int64>(y.getRaw()) * Fixed::One;
+	sf::Int64 angle = 0;
+
+	// Into the right half plane first, the iterations only cover +-99 degrees
+	if (vx < 0)
+	{
+		angle = (vy >= 0) ? (180LL << Fixed::FractionBits) : -(180LL << Fixed::FractionBits);
+		vx = -vx;
+		vy = -vy;
+	}
+
+	const Tables& tables = getTables();
+	for (int i = 0; i < AtanIterations; ++i)
+	{
+		sf::Int64 dx = vy / (1LL << i);
+		sf::Int64 dy = vx / (1LL << i);
+		if (vy > 0)
+		{
+			vx += dx;
+			vy -= dy;
+			angle += tables.arctangent[i];
+		}
+		else
+		{
+			vx -= dx;
+			vy += dy;
+			angle -= tables.arctangent[i];
+		}
+	}
+
+	if (angle > (180LL << Fixed::FractionBits))
+		angle -= 360LL << Fixed::FractionBits;
+
+	return Fixed::fromRaw(static_cast<sf::Int32>(angle));
+}
@@ -0,0 +1,76 @@
+#ifndef BOOK_FIXEDPOINT_HPP
+#define BOOK_FIXEDPOINT_HPP
+
+#include <SFML/Config.hpp>
+#include <SFML/System/Time.hpp>
+#include <SFML/System/Vector2.hpp>
+
+
+// Q16.16 number for the deterministic simulation mode. Arithmetic and trigonometry are integer only, and
+// converting from and to float is a single correctly rounded operation, so the same inputs give the same
+// bits on every compiler and CPU, whatever their float math library does.
+class Fixed
+{
+	public:
+		static const int		FractionBits = 16;
+		static const sf::Int32	One = 1 << FractionBits;
+
+
+	public:
+								Fixed();
+		explicit				Fixed(int value);
+
+		static Fixed			fromRaw(sf::Int32 raw);
+		static Fixed			fromFloat(float value);
+		// From the integer microsecond count, never from float seconds
+		static Fixed			fromTime(sf::Time time);
+
+		sf::Int32				getRaw() const;
+		float					toFloat() const;
+
+		Fixed&					operator+= (Fixed rhs);
+		Fixed&					operator-= (Fixed rhs);
+		Fixed&					operator*= (Fixed rhs);
+		Fixed&					operator/= (Fixed rhs);
+
+
+	private:
+		sf::Int32				mRaw;
+};
+
+Fixed			operator- (Fixed value);
+Fixed			operator+ (Fixed lhs, Fixed rhs);
+Fixed			operator- (Fixed lhs, Fixed rhs);
+Fixed			operator* (Fixed lhs, Fixed rhs);
+Fixed			operator/ (Fixed lhs, Fixed rhs);
+bool			operator== (Fixed lhs, Fixed rhs);
+bool			operator!= (Fixed lhs, Fixed rhs);
+bool			operator< (Fixed lhs, Fixed rhs);
+bool			operator> (Fixed lhs, Fixed rhs);
+
+
+struct FixedVector
+{
+								FixedVector();
+								FixedVector(Fixed x, Fixed y);
+		explicit				FixedVector(sf::Vector2f vector);
+
+		sf::Vector2f			toVector2f() const;
+
+		Fixed					x;
+		Fixed					y;
+};
+
+FixedVector		operator+ (FixedVector lhs, FixedVector rhs);
+FixedVector		operator- (FixedVector lhs, FixedVector rhs);
+FixedVector		operator* (FixedVector vector, Fixed scalar);
+FixedVector&	operator+= (FixedVector& lhs, FixedVector rhs);
+
+
+// Angles in degrees like sf::Transformable's rotation. Sine and cosine interpolate a table of 4096 steps
+// per turn; atan2 returns (-180, 180].
+Fixed			fixedSin(Fixed degrees);
+Fixed			fixedCos(Fixed degrees);
+Fixed			fixedAtan2(Fixed y, Fixed x);
+
+#endif // BOOK_FIXEDPOINT_HPP
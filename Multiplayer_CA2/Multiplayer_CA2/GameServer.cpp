@@ -6,36 +6,183 @@
 #include "Utility.hpp"
 #include "Pickup.hpp"
 #include "Tank.hpp"
+#include "RandomEngine.hpp"
+#include "DataTables.hpp"
+#include "AssetCache.hpp"
 
 #include <SFML/Network/Packet.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+namespace
+{
+	// Snapshot interval bounds for the congestion control, the fastest is the 20 Hz tick
+	const sf::Time MinSnapshotInterval = sf::milliseconds(50);
+	const sf::Time MaxSnapshotInterval = sf::milliseconds(250);
+	const sf::Time PingInterval = sf::milliseconds(500);
+
+	// Longest the loop sleeps between ticks, so packets (pongs included) are picked up close to when they arrive
+	const sf::Time LoopPollInterval = sf::milliseconds(10);
+
+	// Snapshots go out on ticks, the interval is rounded to a whole number of them
+	sf::Uint32 toTicks(sf::Time interval)
+	{
+		return std::max(1, static_cast<int>(std::floor(interval.asSeconds() * ServerTickRate + 0.5f)));
+	}
+
+	// Queued bytes that count as congestion, and the hard cap after which a peer is dropped
+	const std::size_t CongestedQueueBytes = 4 * 1024;
+	const std::size_t MaxOutboundBytes = 256 * 1024;
+
+	// Inbound limits. A client sends ~40 packets/s in normal play; the bucket allows three times that with a burst on top.
+	const float PeerPacketRate = 120.f;
+	const float PeerPacketBurst = 60.f;
+	// Packets handled per loop iteration across all peers, keeps one loop well inside a tick
+	const std::size_t LoopPacketBudget = 256;
+	// A peer that keeps its bucket empty this long is flooding and gets disconnected
+	const sf::Time MaxThrottleTime = sf::seconds(3.f);
+
+	// Ticks of state hashes kept for comparison, and how long a mismatch must last to count as a desync.
+	// Transient mismatches are normal: hitpoints and object changes reach the server and the client at different times.
+	const std::size_t StateHashHistory = 64;
+	const sf::Time DesyncPersistTime = sf::seconds(1.f);
+
+	// Connections that haven't sent their Client::Hello yet
+	const std::size_t MaxPendingPeers = 4;
+
+	// Asset transfers to a joining peer: chunk size, and how much may sit in its outbound queue at once
+	const std::size_t AssetChunkSize = 8 * 1024;
+	const std::size_t AssetWindowBytes = 64 * 1024;
+
+	// How far back tank joins and removals are remembered; resumes older than this get the full roster
+	const sf::Uint32 RosterHistoryTicks = 60 * ServerTickRate;
+
+	// Checkpoint every two seconds; a crashed match loses at most that much
+	const sf::Uint32 CheckpointTicks = 2 * ServerTickRate;
+}
+
 GameServer::RemotePeer::RemotePeer() 
-: ready(false)
+: outboundBytes(0)
+, sendInProgress(false)
+, ready(false)
 , timedOut(false)
+, quit(false)
+, authority(false)
+, receiveTokens(PeerPacketBurst)
+, tokenRefillTime(sf::Time::Zero)
+, drained(false)
+, throttled(false)
+, throttledSince(sf::Time::Zero)
+, sessionToken(0)
+, objectStateAck(0)
+, objectStateSent(0)
+, objectStateSendTime(sf::Time::Zero)
+, snapshotInterval(MinSnapshotInterval)
+, lastSnapshotTick(0)
+, lastRateChange(sf::Time::Zero)
+, lowPrecision(false)
+, pingSequence(0)
+, pingSendTime(sf::Time::Zero)
+, pingOutstanding(false)
+, hasRtt(false)
+, smoothedRtt(sf::Time::Zero)
+, minRtt(sf::Time::Zero)
+, helloReceived(false)
+, helloToken(0)
+, helloTick(0)
+, helloAuthority(false)
+, assetsRequested(false)
+, assetQueue()
+, assetOffset(0)
+, desyncMismatch(false)
+, desyncSince(sf::Time::Zero)
+, desyncFirstTick(0)
+, desyncReported(false)
 {
 	socket.setBlocking(false);
 }
 
-GameServer::GameServer(sf::Vector2f battlefieldSize)
+GameServer::Metrics::Metrics()
+: packetsHandled(0)
+, throttledReads(0)
+, budgetExhaustions(0)
+, overloadDisconnects(0)
+, desyncReports(0)
+{
+}
+
+GameServer::ObjectState::ObjectState()
+: hitpoints(0)
+, destroyed(false)
+, position()
+{
+	for (std::size_t i = 0; i < ReplicationComponent::FieldCount; ++i)
+		fieldVersions[i] = 0;
+}
+
+GameServer::GameServer(sf::Vector2f battlefieldSize, const std::string& recordingFile, unsigned short port)
 : mThread(&GameServer::executionThread, this)
+, mPort(port)
 , mListeningState(false)
 , mClientTimeoutTime(sf::seconds(3.f))
 , mMaxConnectedPlayers(10)
 ,mMaxSpawnPoints(0)
 , mConnectedPlayers(0)
+, mMetrics()
+, mReceiveCursor(0)
 , mWorldHeight(768.f)
 , mBattleFieldRect(0.f, mWorldHeight - battlefieldSize.y, battlefieldSize.x, battlefieldSize.y)
 ,mSpawnPoints()
 , mBattleFieldScrollSpeed(0.0f)
 , mTankCount(0)
 , mPeers(1)
+, mAssets()
 , mTankIdentifierCounter(1)
 , mWaitingThreadEnd(false)
 , mLastSpawnTime(sf::Time::Zero)
 , mTimeForNextSpawn(sf::seconds(5.f))
+, mRecorder()
+, mObjectStates()
+, mObjectStateVersion(0)
+, mObjectStateResendTime(sf::seconds(1.f))
+, mMatchSeed(mixSeed(static_cast<sf::Uint64>(std::time(nullptr)), static_cast<sf::Uint64>(randomInt(0x7FFFFFFF))))
+, mPendingDisconnections(false)
+, mServerTick(0)
+, mSuspendedSessions()
+, mSessionGracePeriod(sf::seconds(20.f))
+, mSessionTokenEngine()
+, mRosterEvents()
+, mStateHash()
+, mHashedTanks()
+, mTickHashes()
+, mCheckpointFile("checkpoint_" + toString(port) + ".bin")
+, mCheckpoint()
+, mCheckpointState()
+, mRestoredTick(0)
 {
 	mListenerSocket.setBlocking(false);
+	mRelayListenerSocket.setBlocking(false);
+	mRelayPeer.reset(new RemotePeer());
 	mPeers[0].reset(new RemotePeer());
+
+	std::random_device device;
+	std::seed_seq tokenSeed = { device(), device(), device(), device(), device(), device(), device(), device() };
+	mSessionTokenEngine.seed(tokenSeed);
+
+	if (!recordingFile.empty())
+		mRecorder.reset(new MatchRecorder(recordingFile, mWorldHeight));
+
+	loadAssets();
+
+	// A match that crashed moments ago picks up where it left off, its players reconnect with their session tokens
+	restoreCheckpoint();
+	mCheckpoint.reset(new MatchCheckpoint(mCheckpointFile));
+
 	mThread.launch();
 
 	mSpawnPoints.push_back(sf::Vector2f(512, 80));
@@ -57,53 +204,62 @@ GameServer::~GameServer()
 {
 	mWaitingThreadEnd = true;
 	mThread.wait();
+
+	// Shut down on purpose, there is nothing to recover
+	mCheckpoint->discard();
+}
+
+std::size_t GameServer::getConnectedPlayers() const
+{
+	sf::Lock lock(mStatusMutex);
+	return mConnectedPlayers;
+}
+
+GameServer::Metrics GameServer::getMetrics() const
+{
+	sf::Lock lock(mStatusMutex);
+	return mMetrics;
+}
+
+std::size_t GameServer::getMaxPlayers() const
+{
+	return mMaxConnectedPlayers;
+}
+
+unsigned short GameServer::getPort() const
+{
+	return mPort;
 }
 
 void GameServer::notifyPlayerRealtimeChange(sf::Int32 TankIdentifier, sf::Int32 action, bool actionEnabled)
 {
-	for (std::size_t i = 0; i < mConnectedPlayers; ++i)
-	{
-		if (mPeers[i]->ready)
-		{
-			sf::Packet packet;
-			packet << static_cast<sf::Int32>(Server::PlayerRealtimeChange);
-			packet << TankIdentifier;
-			packet << action;
-			packet << actionEnabled;
+	sf::Packet packet;
+	beginPacket(packet, Server::PlayerRealtimeChange);
+	packet << TankIdentifier;
+	packet << action;
+	packet << actionEnabled;
 
-			mPeers[i]->socket.send(packet);
-		}
-	}
+	sendToAll(packet);
 }
 
 void GameServer::notifyPlayerEvent(sf::Int32 TankIdentifier, sf::Int32 action)
 {
-	for (std::size_t i = 0; i < mConnectedPlayers; ++i)
-	{
-		if (mPeers[i]->ready)
-		{
-			sf::Packet packet;
-			packet << static_cast<sf::Int32>(Server::PlayerEvent);
-			packet << TankIdentifier;
-			packet << action;
+	sf::Packet packet;
+	beginPacket(packet, Server::PlayerEvent);
+	packet << TankIdentifier;
+	packet << action;
 
-			mPeers[i]->socket.send(packet);
-		}
-	}
+	sendToAll(packet);
 }
 
 void GameServer::notifyPlayerSpawn(sf::Int32 TankIdentifier)
 {
-	for (std::size_t i = 0; i < mConnectedPlayers; ++i)
-	{
-		if (mPeers[i]->ready)
-		{
-			sf::Packet packet;
-			packet << static_cast<sf::Int32>(Server::PlayerConnect);
-			packet << TankIdentifier << mTankInfo[TankIdentifier].position.x << mTankInfo[TankIdentifier].position.y;
-			mPeers[i]->socket.send(packet);
-		}
-	}
+	sf::Packet packet;
+	beginPacket(packet, Server::PlayerConnect);
+	packet << TankIdentifier << mTankInfo[TankIdentifier].position.x << mTankInfo[TankIdentifier].position.y;
+
+	recordRosterEvent(TankIdentifier, true);
+	sendToAll(packet);
 }
 
 void GameServer::setListening(bool enable)
@@ -112,7 +268,7 @@ void GameServer::setListening(bool enable)
 	if (enable)
 	{	
 		if (!mListeningState)
-			mListeningState = (mListenerSocket.listen(ServerPort) == sf::TcpListener::Done);
+			mListeningState = (mListenerSocket.listen(mPort) == sf::TcpListener::Done);
 	}
 	else
 	{
@@ -121,9 +277,40 @@ void GameServer::setListening(bool enable)
 	}
 }
 
+// A spectator relay subscribes once and fans the stream out to its own clients, so watching a match costs the server a single peer
+void GameServer::handleRelayConnection()
+{
+	if (!mRelayPeer->ready)
+	{
+		if (mRelayListenerSocket.accept(mRelayPeer->socket) == sf::TcpListener::Done)
+		{
+			informWorldState(*mRelayPeer);
+			mRelayPeer->ready = true;
+			mRelayPeer->lastPacketTime = now();
+		}
+		return;
+	}
+
+	// The relay only sends heartbeats, drain them to keep the connection alive; same bucket as players so it can't flood either
+	refillReceiveTokens(*mRelayPeer);
+
+	sf::Packet packet;
+	while (mRelayPeer->receiveTokens >= 1.f && mRelayPeer->socket.receive(packet) == sf::Socket::Done)
+	{
+		mRelayPeer->receiveTokens -= 1.f;
+		mRelayPeer->lastPacketTime = now();
+		packet.clear();
+	}
+
+	if (now() >= mRelayPeer->lastPacketTime + mClientTimeoutTime || mRelayPeer->timedOut)
+		mRelayPeer.reset(new RemotePeer());
+}
+
 void GameServer::executionThread()
 {
 	setListening(true);
+	// The relay port sits right after the game port, so servers started side by side need a port stride of 2
+	mRelayListenerSocket.listen(mPort + (RelayPort - ServerPort));
 
 	sf::Time stepInterval = sf::seconds(1.f / 60.f);
 	sf::Time stepTime = sf::Time::Zero;
@@ -135,6 +322,8 @@ void GameServer::executionThread()
 	{	
 		handleIncomingPackets();
 		handleIncomingConnections();
+		handlePendingPeers();
+		handleRelayConnection();
 
 		stepTime += stepClock.getElapsedTime();
 		stepClock.restart();
@@ -156,15 +345,38 @@ void GameServer::executionThread()
 			tickTime -= tickInterval;
 		}
 
-		// Sleep to prevent server from consuming 100% CPU
-		sf::sleep(sf::milliseconds(100));
+		// Push out whatever the sockets accept now, the rest stays queued per peer
+		FOREACH(PeerPtr& peer, mPeers)
+			flushOutbound(*peer);
+		flushOutbound(*mRelayPeer);
+
+		// Peers whose queue overflowed while sending
+		if (mPendingDisconnections)
+		{
+			mPendingDisconnections = false;
+			handleDisconnections();
+		}
+
+		// Sleep to prevent server from consuming 100% CPU, but no further than the next tick is due
+		sf::Time untilTick = tickInterval - tickTime - tickClock.getElapsedTime();
+		sf::sleep(std::min(untilTick, LoopPollInterval));
 	}	
 }
 
 void GameServer::tick()
 {
+	++mServerTick;
+	expireSuspendedSessions();
+	updateSendRates();
+
+	// Object states go out before the snapshot, so a client hashing on the snapshot has this tick's objects already
+	updateObjectStates();
+	updateStateHash();
 	updateClientState();
 
+	if (mServerTick % CheckpointTicks == 0)
+		writeCheckpoint();
+
 	// Check for mission success = all planes with position.y < offset
 	bool allTanksDone = true;
 	FOREACH(auto pair, mTankInfo)
@@ -176,7 +388,7 @@ void GameServer::tick()
 	if (allTanksDone)
 	{
 		sf::Packet missionSuccessPacket;
-		missionSuccessPacket << static_cast<sf::Int32>(Server::MissionSuccess);
+		beginPacket(missionSuccessPacket, Server::MissionSuccess);
 		sendToAll(missionSuccessPacket);
 	}
 
@@ -184,7 +396,10 @@ void GameServer::tick()
 	for (auto itr = mTankInfo.begin(); itr != mTankInfo.end(); )
 	{
 		if (itr->second.hitpoints <= 0)
+		{
+			recordRosterEvent(itr->first, false);
 			mTankInfo.erase(itr++);
+		}
 		else
 			++itr;
 	}
@@ -198,34 +413,120 @@ sf::Time GameServer::now() const
 void GameServer::handleIncomingPackets()
 {
 	bool detectedTimeout = false;
-	
+	Metrics metrics;
+
 	FOREACH(PeerPtr& peer, mPeers)
 	{
 		if (peer->ready)
 		{
-			sf::Packet packet;
-			while (peer->socket.receive(packet) == sf::Socket::Done)
-			{
-				// Interpret packet and react to it
-				handleIncomingPacket(packet, *peer, detectedTimeout);
+			refillReceiveTokens(*peer);
+			peer->drained = false;
+		}
+	}
 
-				// Packet was indeed received, update the ping timer
-				peer->lastPacketTime = now();
-				packet.clear();
-			}
+	// Round robin, one packet per peer per pass, so no single peer can use up the budget or hold up the tick.
+	// A peer out of tokens is simply not read; its packets wait in the socket and TCP slows the sender down.
+	std::size_t budget = LoopPacketBudget;
+	bool handledAny = true;
+	while (budget > 0 && handledAny)
+	{
+		handledAny = false;
+		for (std::size_t n = 0; n < mPeers.size() && budget > 0; ++n)
+		{
+			RemotePeer& peer = *mPeers[(mReceiveCursor + n) % mPeers.size()];
+			if (!peer.ready || peer.timedOut || peer.drained || peer.receiveTokens < 1.f)
+				continue;
 
-			if (now() >= peer->lastPacketTime + mClientTimeoutTime)
+			sf::Packet packet;
+			if (peer.socket.receive(packet) != sf::Socket::Done)
 			{
-				peer->timedOut = true;
-				detectedTimeout = true;
+				peer.drained = true;
+				continue;
 			}
+
+			peer.receiveTokens -= 1.f;
+			--budget;
+			++metrics.packetsHandled;
+			handledAny = true;
+
+			// Interpret packet and react to it
+			handleIncomingPacket(packet, peer, detectedTimeout);
+
+			// Packet was indeed received, update the ping timer
+			peer.lastPacketTime = now();
+		}
+	}
+
+	// Whoever went second this time goes first next time, in case the budget cuts a pass short
+	if (!mPeers.empty())
+		mReceiveCursor = (mReceiveCursor + 1) % mPeers.size();
+
+	if (budget == 0)
+		++metrics.budgetExhaustions;
+
+	FOREACH(PeerPtr& peer, mPeers)
+	{
+		if (peer->ready && !peer->timedOut)
+		{
+			if (!peer->drained && peer->receiveTokens < 1.f)
+				++metrics.throttledReads;
+
+			checkOverload(*peer, detectedTimeout);
+			if (peer->timedOut)
+				++metrics.overloadDisconnects;
+		}
+
+		if (peer->ready && now() >= peer->lastPacketTime + mClientTimeoutTime)
+		{
+			peer->timedOut = true;
+			detectedTimeout = true;
 		}
 	}
 
+	{
+		sf::Lock lock(mStatusMutex);
+		mMetrics.packetsHandled += metrics.packetsHandled;
+		mMetrics.throttledReads += metrics.throttledReads;
+		mMetrics.budgetExhaustions += metrics.budgetExhaustions;
+		mMetrics.overloadDisconnects += metrics.overloadDisconnects;
+	}
+
 	if (detectedTimeout)
 		handleDisconnections();
 }
 
+void GameServer::refillReceiveTokens(RemotePeer& peer)
+{
+	sf::Time elapsed = now() - peer.tokenRefillTime;
+	peer.tokenRefillTime = now();
+	peer.receiveTokens = std::min(PeerPacketBurst, peer.receiveTokens + elapsed.asSeconds() * PeerPacketRate);
+}
+
+// A peer that keeps its bucket empty for seconds is sending faster than any real client, drop it without a session to resume
+void GameServer::checkOverload(RemotePeer& peer, bool& detectedTimeout)
+{
+	if (peer.drained || peer.receiveTokens >= 1.f)
+	{
+		peer.throttled = false;
+		return;
+	}
+
+	if (!peer.throttled)
+	{
+		peer.throttled = true;
+		peer.throttledSince = now();
+		return;
+	}
+
+	if (now() >= peer.throttledSince + MaxThrottleTime)
+	{
+		peer.quit = true;
+		peer.timedOut = true;
+		detectedTimeout = true;
+		broadcastMessage("A Player was disconnected for flooding the server.");
+	}
+}
+
 void GameServer::handleIncomingPacket(sf::Packet& packet, RemotePeer& receivingPeer, bool& detectedTimeout)
 {
 	sf::Int32 packetType;
@@ -235,6 +536,7 @@ void GameServer::handleIncomingPacket(sf::Packet& packet, RemotePeer& receivingP
 	{
 		case Client::Quit:
 		{
+			receivingPeer.quit = true;
 			receivingPeer.timedOut = true;
 			detectedTimeout = true;
 		} break;
@@ -264,14 +566,16 @@ void GameServer::handleIncomingPacket(sf::Packet& packet, RemotePeer& receivingP
 			mTankInfo[mTankIdentifierCounter].position = sf::Vector2f(mBattleFieldRect.width / 2, mBattleFieldRect.top + mBattleFieldRect.height / 2);
 			mTankInfo[mTankIdentifierCounter].hitpoints = 100;
 			mTankInfo[mTankIdentifierCounter].rotation = 0.f;
+			mTankInfo[mTankIdentifierCounter].hitpointsTick = mServerTick;
+			recordRosterEvent(mTankIdentifierCounter, true);
 
 			sf::Packet requestPacket;
-			requestPacket << static_cast<sf::Int32>(Server::AcceptCoopPartner);
+			beginPacket(requestPacket, Server::AcceptCoopPartner);
 			requestPacket << mTankIdentifierCounter;
 			requestPacket << mTankInfo[mTankIdentifierCounter].position.x;
 			requestPacket << mTankInfo[mTankIdentifierCounter].position.y;
 
-			receivingPeer.socket.send(requestPacket);
+			sendToPeer(receivingPeer, requestPacket);
 			mTankCount++;
 
 			// Inform every other peer about this new plane
@@ -280,11 +584,11 @@ void GameServer::handleIncomingPacket(sf::Packet& packet, RemotePeer& receivingP
 				if (peer.get() != &receivingPeer && peer->ready)
 				{
 					sf::Packet notifyPacket;
-					notifyPacket << static_cast<sf::Int32>(Server::PlayerConnect);
+					beginPacket(notifyPacket, Server::PlayerConnect);
 					notifyPacket << mTankIdentifierCounter;
 					notifyPacket << mTankInfo[mTankIdentifierCounter].position.x;
 					notifyPacket << mTankInfo[mTankIdentifierCounter].position.y;
-					peer->socket.send(notifyPacket);
+					sendToPeer(*peer, notifyPacket);
 				}
 			}
 			mTankIdentifierCounter++;
@@ -303,9 +607,122 @@ void GameServer::handleIncomingPacket(sf::Packet& packet, RemotePeer& receivingP
 				sf::Vector2f TankPosition;
 				packet >> TankIdentifier >> TankPosition.x >> TankPosition.y >> TankHitpoints >> TankRotation;
 				mTankInfo[TankIdentifier].position = TankPosition;
+				if (mTankInfo[TankIdentifier].hitpoints != TankHitpoints)
+					mTankInfo[TankIdentifier].hitpointsTick = mServerTick;
 				mTankInfo[TankIdentifier].hitpoints = TankHitpoints;
 				mTankInfo[TankIdentifier].rotation = TankRotation;
 			}
+
+			// Piggybacked hash of the client's state when it applied the snapshot of hashTick
+			sf::Uint32 hashTick, hash;
+			if (packet >> hashTick >> hash)
+				checkStateHash(receivingPeer, hashTick, hash);
+		} break;
+
+		case Client::DesyncDetail:
+		{
+			sf::Uint32 tick;
+			sf::Int32 count;
+			packet >> tick >> count;
+
+			// The count comes from the client: more entries than the server hashed for that tick is never a real report
+			const TickHash* expected = findTickHash(tick);
+			if (!packet || !expected || count < 0 || static_cast<std::size_t>(count) > expected->hash.getEntries().size())
+				break;
+
+			StateHash::Entries entries;
+			for (sf::Int32 i = 0; i < count && packet; ++i)
+			{
+				sf::Uint64 key;
+				sf::Uint32 hash;
+				if (packet >> key >> hash)
+					entries[key] = hash;
+			}
+
+			if (packet)
+				reportDesync(receivingPeer, tick, entries);
+		} break;
+
+		case Client::ObjectStateUpdate:
+		{
+			// The authority simulates obstacles and pickups for everyone
+			if (!receivingPeer.authority)
+				break;
+
+			sf::Int32 count;
+			packet >> count;
+
+			++mObjectStateVersion;
+			for (sf::Int32 i = 0; i < count && packet; ++i)
+			{
+				// Stop at the end of the data whatever the count says, a truncated entry is not applied
+				ReplicatedState state;
+				if (!(packet >> state))
+					break;
+
+				ObjectState& object = mObjectStates[state.identifier];
+				if (state.fields & ReplicationComponent::Hitpoints)
+				{
+					object.hitpoints = state.hitpoints;
+					object.fieldVersions[0] = mObjectStateVersion;
+				}
+				if (state.fields & ReplicationComponent::Destroyed)
+				{
+					object.destroyed = true;
+					object.fieldVersions[1] = mObjectStateVersion;
+				}
+				if (state.fields & (ReplicationComponent::Hitpoints | ReplicationComponent::Destroyed))
+					mStateHash.set(StateHash::Object, state.identifier, StateHash::hashObject(object.hitpoints, object.destroyed));
+				if (state.fields & ReplicationComponent::Position)
+				{
+					object.position = state.position;
+					object.fieldVersions[2] = mObjectStateVersion;
+				}
+			}
+		} break;
+
+		case Client::Pong:
+		{
+			sf::Uint32 sequence;
+			packet >> sequence;
+			handlePong(receivingPeer, sequence);
+		} break;
+
+		// Four NTP timestamps: the client brackets the exchange, we report when it arrived and when we answered
+		case Client::ClockPing:
+		{
+			sf::Time receiveTime = now();
+			sf::Uint32 sequence;
+			sf::Int64 clientSendUs;
+			packet >> sequence >> clientSendUs;
+
+			sf::Packet pongPacket;
+			beginPacket(pongPacket, Server::ClockPong) << sequence << clientSendUs << receiveTime.asMicroseconds() << now().asMicroseconds();
+			sendToPeer(receivingPeer, pongPacket);
+		} break;
+
+		case Client::ObjectStateAck:
+		{
+			sf::Uint32 version;
+			packet >> version;
+			receivingPeer.objectStateAck = std::max(receivingPeer.objectStateAck, version);
+		} break;
+
+		case Client::FireEvent:
+		{
+			sf::Int32 TankIdentifier;
+			sf::Uint32 tick;
+			sf::Uint32 seed;
+			packet >> TankIdentifier >> tick >> seed;
+
+			// Peers may only fire their own tanks
+			if (std::find(receivingPeer.TankIdentifiers.begin(), receivingPeer.TankIdentifiers.end(), TankIdentifier) == receivingPeer.TankIdentifiers.end())
+				break;
+
+			sf::Packet firePacket;
+			beginPacket(firePacket, Server::FireEvent);
+			firePacket << TankIdentifier << tick << seed;
+			sendToAll(firePacket);
 		} break;
 
 		case Client::GameEvent:
@@ -319,11 +736,11 @@ void GameServer::handleIncomingPacket(sf::Packet& packet, RemotePeer& receivingP
 			packet >> y;
 
 			// Enemy explodes: With certain probability, drop pickup
-			// To avoid multiple messages spawning multiple pickups, only listen to first peer (host)
-			if (action == GameActions::EnemyExplode && randomInt(3) == 0 && &receivingPeer == mPeers[0].get())
+			// To avoid multiple messages spawning multiple pickups, only listen to the authority
+			if (action == GameActions::EnemyExplode && randomInt(3) == 0 && receivingPeer.authority)
 			{
 				sf::Packet packet;
-				packet << static_cast<sf::Int32>(Server::SpawnPickup);
+				beginPacket(packet, Server::SpawnPickup);
 				packet << static_cast<sf::Int32>(randomInt(Pickup::TypeCount));
 				packet << x;
 				packet << y;
@@ -337,134 +754,1011 @@ void GameServer::handleIncomingPacket(sf::Packet& packet, RemotePeer& receivingP
 void GameServer::updateClientState()
 {
 	sf::Packet updateClientStatePacket;
-	updateClientStatePacket << static_cast<sf::Int32>(Server::UpdateClientState);
+	beginPacket(updateClientStatePacket, Server::UpdateClientState);
 	updateClientStatePacket << static_cast<float>(mBattleFieldRect.top + mBattleFieldRect.height);
 	updateClientStatePacket << static_cast<sf::Int32>(mTankInfo.size());
 
 	FOREACH(auto Tank, mTankInfo)
 		updateClientStatePacket << Tank.first << Tank.second.position.x << Tank.second.position.y << Tank.second.rotation;
 
-	sendToAll(updateClientStatePacket);
-}
-
-void GameServer::handleIncomingConnections()
-{
-	if (!mListeningState)
-		return;
+	// Congested peers get whole-pixel positions and 8 bit rotations, about half the size
+	sf::Packet compactPacket;
+	beginPacket(compactPacket, Server::UpdateClientStateCompact);
+	compactPacket << static_cast<float>(mBattleFieldRect.top + mBattleFieldRect.height);
+	compactPacket << static_cast<sf::Int32>(mTankInfo.size());
 
-	if (mListenerSocket.accept(mPeers[mConnectedPlayers]->socket) == sf::TcpListener::Done)
+	FOREACH(auto Tank, mTankInfo)
 	{
-		// order the new client to spawn its own plane ( player 1 )
-		mTankInfo[mTankIdentifierCounter].position = sf::Vector2f(mSpawnPoints[mMaxSpawnPoints].x, mSpawnPoints[mMaxSpawnPoints].y);//sf::Vector2f(mBattleFieldRect.width / 2, mBattleFieldRect.top + mBattleFieldRect.height / 2);
-		mTankInfo[mTankIdentifierCounter].hitpoints = 100;
-		mTankInfo[mTankIdentifierCounter].rotation = 0.f;
+		float rotation = std::fmod(Tank.second.rotation, 360.f);
+		if (rotation < 0.f)
+			rotation += 360.f;
 
-		sf::Packet packet;
-		packet << static_cast<sf::Int32>(Server::SpawnSelf);
-		packet << mTankIdentifierCounter;
-		packet << mTankInfo[mTankIdentifierCounter].position.x;
-		packet << mTankInfo[mTankIdentifierCounter].position.y;
-		
-		mPeers[mConnectedPlayers]->TankIdentifiers.push_back(mTankIdentifierCounter);
-		
-		broadcastMessage("New player!");
-		informWorldState(mPeers[mConnectedPlayers]->socket);
-		notifyPlayerSpawn(mTankIdentifierCounter++);
-
-		mPeers[mConnectedPlayers]->socket.send(packet);
-		mPeers[mConnectedPlayers]->ready = true;
-		mPeers[mConnectedPlayers]->lastPacketTime = now(); // prevent initial timeouts
-		mTankCount++;
-		mConnectedPlayers++;
+		compactPacket << Tank.first;
+		compactPacket << static_cast<sf::Int16>(std::floor(Tank.second.position.x + 0.5f));
+		compactPacket << static_cast<sf::Int16>(std::floor(Tank.second.position.y + 0.5f));
+		compactPacket << static_cast<sf::Uint8>(static_cast<int>(rotation * 256.f / 360.f + 0.5f) & 0xFF);
+	}
 
-		if (mConnectedPlayers >= mMaxConnectedPlayers)
-			setListening(false);
-		else // Add a new waiting peer
-			mPeers.push_back(PeerPtr(new RemotePeer()));
+	FOREACH(PeerPtr& peer, mPeers)
+	{
+		if (!peer->ready || mServerTick < peer->lastSnapshotTick + toTicks(peer->snapshotInterval))
+			continue;
+
+		sendToPeer(*peer, peer->lowPrecision ? compactPacket : updateClientStatePacket, true);
+		peer->lastSnapshotTick = mServerTick;
+	}
 
-		mMaxSpawnPoints++;
+	// The relay serves many viewers and never acks, it always gets full snapshots
+	if (mRelayPeer->ready)
+		sendToPeer(*mRelayPeer, updateClientStatePacket, true);
 
-		if (mMaxSpawnPoints >= mSpawnPoints.size()) {
-			mMaxSpawnPoints = 1;
+	// Record the same state the clients were just sent
+	if (mRecorder)
+	{
+		MatchRecording::Snapshot snapshot;
+		FOREACH(auto& Tank, mTankInfo)
+		{
+			MatchRecording::TankSnapshot tank;
+			tank.identifier = Tank.first;
+			tank.position = Tank.second.position;
+			tank.rotation = Tank.second.rotation;
+			tank.hitpoints = Tank.second.hitpoints;
+			snapshot.push_back(tank);
 		}
+
+		mRecorder->record(now(), mBattleFieldRect.top + mBattleFieldRect.height, snapshot);
 	}
 }
 
-void GameServer::handleDisconnections()
+// Incremental: only tanks whose quantized transform or hitpoints changed touch the hash, objects update as they arrive
+void GameServer::updateStateHash()
 {
-	for (auto itr = mPeers.begin(); itr != mPeers.end(); )
+	std::vector<sf::Int32> tanks;
+	FOREACH(auto& pair, mTankInfo)
 	{
-		if ((*itr)->timedOut)
+		tanks.push_back(pair.first);
+		mStateHash.set(StateHash::TankTransform, pair.first, StateHash::hashTransform(pair.second.position, pair.second.rotation));
+		mStateHash.set(StateHash::TankStatus, pair.first, StateHash::hashTankStatus(pair.second.hitpoints));
+	}
+
+	FOREACH(sf::Int32 identifier, mHashedTanks)
+	{
+		if (mTankInfo.find(identifier) == mTankInfo.end())
 		{
-			// Inform everyone of the disconnection, erase 
-			FOREACH(sf::Int32 identifier, (*itr)->TankIdentifiers)
-			{
-				sendToAll(sf::Packet() << static_cast<sf::Int32>(Server::PlayerDisconnect) << identifier);
+			mStateHash.erase(StateHash::TankTransform, identifier);
+			mStateHash.erase(StateHash::TankStatus, identifier);
+		}
+	}
+	mHashedTanks.swap(tanks);
 
-				mTankInfo.erase(identifier);
-			}
+	TickHash tickHash;
+	tickHash.tick = mServerTick;
+	tickHash.hash = mStateHash;
+	mTickHashes.push_back(tickHash);
 
-			mConnectedPlayers--;
-			mTankCount -= (*itr)->TankIdentifiers.size();
+	if (mTickHashes.size() > StateHashHistory)
+		mTickHashes.pop_front();
+}
 
-			itr = mPeers.erase(itr);
+const GameServer::TickHash* GameServer::findTickHash(sf::Uint32 tick) const
+{
+	FOREACH(const TickHash& tickHash, mTickHashes)
+	{
+		if (tickHash.tick == tick)
+			return &tickHash;
+	}
 
-			// Go back to a listening state if needed
-			if (mConnectedPlayers < mMaxConnectedPlayers)
-			{
-				mPeers.push_back(PeerPtr(new RemotePeer()));
-				setListening(true);
-			}
-				
-			broadcastMessage("A Player has disconnected.");
-		}
-		else
-		{
-			++itr;
-		}
+	return nullptr;
+}
+
+void GameServer::checkStateHash(RemotePeer& peer, sf::Uint32 tick, sf::Uint32 hash)
+{
+	const TickHash* expected = findTickHash(tick);
+	if (!expected)
+		return;
+
+	// Clients don't hash the transforms of their own tanks, they run ahead of what we have
+	if (hash == expected->hash.getValueWithout(StateHash::TankTransform, peer.TankIdentifiers))
+	{
+		peer.desyncMismatch = false;
+		peer.desyncReported = false;
+		return;
+	}
+
+	if (!peer.desyncMismatch)
+	{
+		peer.desyncMismatch = true;
+		peer.desyncSince = now();
+		peer.desyncFirstTick = tick;
+		return;
+	}
+
+	// Persistent: ask for the per entity hashes of the first divergent tick, once per mismatch streak
+	if (!peer.desyncReported && now() >= peer.desyncSince + DesyncPersistTime)
+	{
+		sf::Packet probePacket;
+		beginPacket(probePacket, Server::DesyncProbe) << peer.desyncFirstTick;
+		sendToPeer(peer, probePacket);
+		peer.desyncReported = true;
 	}
 }
 
-// Tell the newly connected peer about how the world is currently
-void GameServer::informWorldState(sf::TcpSocket& socket)
+// Diffs the client's entries against ours and appends the divergent entities to desync.log
+void GameServer::reportDesync(RemotePeer& peer, sf::Uint32 tick, const StateHash::Entries& clientEntries)
 {
-	sf::Packet packet;
-	packet << static_cast<sf::Int32>(Server::InitialState);
-	packet << mWorldHeight << mBattleFieldRect.top + mBattleFieldRect.height;
-	packet << static_cast<sf::Int32>(mTankCount);
+	const TickHash* expected = findTickHash(tick);
+	if (!expected)
+		return;
 
-	for (std::size_t i = 0; i < mConnectedPlayers; ++i)
+	std::ostringstream report;
+	report << "port " << mPort << " tick " << tick << " peer tanks [";
+	for (std::size_t i = 0; i < peer.TankIdentifiers.size(); ++i)
+		report << (i > 0 ? " " : "") << peer.TankIdentifiers[i];
+	report << "]:";
+
+	const StateHash::Entries& serverEntries = expected->hash.getEntries();
+	std::size_t divergent = 0;
+
+	FOREACH(auto& entry, serverEntries)
+	{
+		StateHash::Kind kind = StateHash::getKind(entry.first);
+		sf::Int32 identifier = StateHash::getIdentifier(entry.first);
+
+		if (kind == StateHash::TankTransform && std::find(peer.TankIdentifiers.begin(), peer.TankIdentifiers.end(), identifier) != peer.TankIdentifiers.end())
+			continue;
+
+		auto found = clientEntries.find(entry.first);
+		if (found == clientEntries.end())
+			report << " " << StateHash::getKindName(kind) << " " << identifier << " missing on client;";
+		else if (found->second != entry.second)
+			report << " " << StateHash::getKindName(kind) << " " << identifier << " differs;";
+		else
+			continue;
+
+		++divergent;
+	}
+
+	FOREACH(auto& entry, clientEntries)
 	{
-		if (mPeers[i]->ready)
+		if (serverEntries.find(entry.first) == serverEntries.end())
 		{
-			FOREACH(sf::Int32 identifier, mPeers[i]->TankIdentifiers)
-				packet << identifier << mTankInfo[identifier].position.x << mTankInfo[identifier].position.y << mTankInfo[identifier].hitpoints << mTankInfo[identifier].rotation;
+			report << " " << StateHash::getKindName(StateHash::getKind(entry.first)) << " " << StateHash::getIdentifier(entry.first) << " unknown to server;";
+			++divergent;
 		}
 	}
 
-	socket.send(packet);
+	if (divergent == 0)
+		return;
+
+	std::ofstream log("desync.log", std::ios::app);
+	log << report.str() << std::endl;
+
+	sf::Lock lock(mStatusMutex);
+	++mMetrics.desyncReports;
 }
 
-void GameServer::broadcastMessage(const std::string& message)
+void GameServer::updateObjectStates()
 {
-	for (std::size_t i = 0; i < mConnectedPlayers; ++i)
+	FOREACH(PeerPtr& peerPtr, mPeers)
 	{
-		if (mPeers[i]->ready)
-		{
-			sf::Packet packet;
-			packet << static_cast<sf::Int32>(Server::BroadcastMessage);
-			packet << message;
+		// The authority is where the states come from
+		RemotePeer& peer = *peerPtr;
+		if (!peer.ready || peer.authority)
+			continue;
+
+		// Don't repeat what is still in flight, unless the ack is overdue
+		bool awaitingAck = peer.objectStateSent > peer.objectStateAck && now() < peer.objectStateSendTime + mObjectStateResendTime;
+		sendObjectStates(peer, awaitingAck ? peer.objectStateSent : peer.objectStateAck);
+	}
 
-			mPeers[i]->socket.send(packet);
-		}	
+	// The relay never acks, its stream is reliable so it only needs each change once
+	if (mRelayPeer->ready)
+	{
+		sendObjectStates(*mRelayPeer, mRelayPeer->objectStateSent);
+		mRelayPeer->objectStateAck = mRelayPeer->objectStateSent;
 	}
 }
 
-void GameServer::sendToAll(sf::Packet& packet)
+// Sends every field that changed after baseVersion; a new peer starts at 0 and so gets the full state
+void GameServer::sendObjectStates(RemotePeer& peer, sf::Uint32 baseVersion)
 {
-	FOREACH(PeerPtr& peer, mPeers)
+	if (baseVersion >= mObjectStateVersion)
+		return;
+
+	std::vector<ReplicatedState> states;
+	FOREACH(auto& pair, mObjectStates)
 	{
-		if (peer->ready)
-			peer->socket.send(packet);
+		ReplicatedState state;
+		state.identifier = pair.first;
+		state.hitpoints = pair.second.hitpoints;
+		state.position = pair.second.position;
+
+		for (std::size_t field = 0; field < ReplicationComponent::FieldCount; ++field)
+		{
+			if (pair.second.fieldVersions[field] > baseVersion)
+				state.fields |= static_cast<sf::Uint8>(1 << field);
+		}
+
+		if (state.fields != 0)
+			states.push_back(state);
 	}
+
+	sf::Packet packet;
+	beginPacket(packet, Server::UpdateObjectState);
+	packet << mObjectStateVersion;
+	packet << static_cast<sf::Int32>(states.size());
+	FOREACH(const ReplicatedState& state, states)
+		packet << state;
+
+	sendToPeer(peer, packet);
+	peer.objectStateSent = mObjectStateVersion;
+	peer.objectStateSendTime = now();
+}
+
+void GameServer::handleIncomingConnections()
+{
+	if (!mListeningState || mPendingPeers.size() >= MaxPendingPeers)
+		return;
+
+	// A connection only takes a player slot once its Client::Hello says whether it's new or resuming
+	PeerPtr peer(new RemotePeer());
+	if (mListenerSocket.accept(peer->socket) == sf::TcpListener::Done)
+	{
+		peer->lastPacketTime = now();
+		mPendingPeers.push_back(std::move(peer));
+	}
+}
+
+void GameServer::handlePendingPeers()
+{
+	for (auto itr = mPendingPeers.begin(); itr != mPendingPeers.end(); )
+	{
+		RemotePeer& peer = **itr;
+
+		sf::Packet packet;
+		sf::Socket::Status status;
+		while ((status = peer.socket.receive(packet)) == sf::Socket::Done)
+		{
+			sf::Int32 packetType;
+			packet >> packetType;
+			peer.lastPacketTime = now();
+
+			// The Hello says whether the peer is new or resuming, the manifest lets it check its asset cache first
+			if (packetType == Client::Hello && !peer.helloReceived)
+			{
+				packet >> peer.helloToken >> peer.helloTick >> peer.helloAuthority;
+				peer.helloReceived = true;
+				sendAssetManifest(peer);
+			}
+			else if (packetType == Client::AssetRequest && peer.helloReceived && !peer.assetsRequested)
+			{
+				queueAssets(peer, packet);
+				peer.assetsRequested = true;
+			}
+
+			packet.clear();
+		}
+
+		if (peer.assetsRequested)
+			streamAssets(peer);
+
+		// Everything it asked for is queued ahead of SpawnSelf, in order on the same socket
+		if (peer.assetsRequested && peer.assetQueue.empty() && !peer.timedOut)
+		{
+			sf::Uint64 sessionToken = peer.helloToken;
+			sf::Uint32 lastServerTick = peer.helloTick;
+
+			PeerPtr admitted = std::move(*itr);
+			itr = mPendingPeers.erase(itr);
+			admitPeer(std::move(admitted), sessionToken, lastServerTick);
+			continue;
+		}
+
+		// A peer busy downloading is quiet on purpose, only a closed or overflowing socket ends it
+		bool downloading = peer.assetsRequested && !peer.assetQueue.empty();
+		if (status == sf::Socket::Disconnected || peer.timedOut || (!downloading && now() >= peer.lastPacketTime + mClientTimeoutTime))
+			itr = mPendingPeers.erase(itr);
+		else
+			++itr;
+	}
+}
+
+void GameServer::restoreCheckpoint()
+{
+	MatchCheckpoint::State& state = mCheckpointState;
+	if (!MatchCheckpoint::load(mCheckpointFile, mSessionGracePeriod, state))
+		return;
+
+	// Ticks carry on from the checkpoint plus the downtime, clients ignore stamps older than what they have seen
+	sf::Uint64 downtime = static_cast<sf::Uint64>(std::time(nullptr)) - state.wallClockSeconds;
+	mServerTick = state.serverTick + static_cast<sf::Uint32>(downtime + 1) * ServerTickRate;
+	mRestoredTick = mServerTick;
+
+	mMatchSeed = state.matchSeed;
+	mBattleFieldRect.top = state.battlefieldTop;
+	mTankIdentifierCounter = state.nextTankIdentifier;
+	mMaxSpawnPoints = state.nextSpawnPoint;
+	mObjectStateVersion = state.objectStateVersion;
+
+	// Every session is suspended until its player comes back; tanks nobody can claim are dropped
+	FOREACH(const MatchCheckpoint::Session& session, state.sessions)
+	{
+		SuspendedSession& suspended = mSuspendedSessions[session.token];
+		suspended.TankIdentifiers = session.tanks;
+		suspended.suspendTime = now();
+		suspended.objectStateAck = 0;
+		suspended.authority = session.authority;
+	}
+
+	FOREACH(const MatchCheckpoint::Tank& tank, state.tanks)
+	{
+		bool claimed = false;
+		FOREACH(const MatchCheckpoint::Session& session, state.sessions)
+			claimed = claimed || std::find(session.tanks.begin(), session.tanks.end(), tank.identifier) != session.tanks.end();
+
+		if (!claimed)
+			continue;
+
+		TankInfo& info = mTankInfo[tank.identifier];
+		info.position = tank.position;
+		info.rotation = tank.rotation;
+		info.hitpoints = tank.hitpoints;
+		info.hitpointsTick = mServerTick;
+	}
+	mTankCount = mTankInfo.size();
+
+	FOREACH(const MatchCheckpoint::Object& saved, state.objects)
+	{
+		ObjectState& object = mObjectStates[saved.identifier];
+		object.hitpoints = saved.hitpoints;
+		object.destroyed = saved.destroyed;
+		object.position = saved.position;
+
+		for (std::size_t field = 0; field < ReplicationComponent::FieldCount; ++field)
+			object.fieldVersions[field] = (saved.setFields & (1 << field)) ? mObjectStateVersion : 0;
+	}
+}
+
+void GameServer::writeCheckpoint()
+{
+	MatchCheckpoint::State& state = mCheckpointState;
+	state.serverTick = mServerTick;
+	state.matchSeed = mMatchSeed;
+	state.battlefieldTop = mBattleFieldRect.top;
+	state.nextTankIdentifier = mTankIdentifierCounter;
+	state.nextSpawnPoint = static_cast<sf::Uint32>(mMaxSpawnPoints);
+	state.objectStateVersion = mObjectStateVersion;
+
+	state.tanks.clear();
+	FOREACH(auto& pair, mTankInfo)
+	{
+		MatchCheckpoint::Tank tank;
+		tank.identifier = pair.first;
+		tank.position = pair.second.position;
+		tank.rotation = pair.second.rotation;
+		tank.hitpoints = pair.second.hitpoints;
+		state.tanks.push_back(tank);
+	}
+
+	// Peer assignments: who gets which tanks back when they reconnect
+	std::size_t sessionCount = 0;
+	FOREACH(PeerPtr& peer, mPeers)
+	{
+		if (!peer->ready || peer->quit || peer->sessionToken == 0 || peer->TankIdentifiers.empty())
+			continue;
+
+		if (state.sessions.size() <= sessionCount)
+			state.sessions.resize(sessionCount + 1);
+		state.sessions[sessionCount].token = peer->sessionToken;
+		state.sessions[sessionCount].authority = peer->authority;
+		state.sessions[sessionCount++].tanks = peer->TankIdentifiers;
+	}
+	FOREACH(auto& pair, mSuspendedSessions)
+	{
+		if (state.sessions.size() <= sessionCount)
+			state.sessions.resize(sessionCount + 1);
+		state.sessions[sessionCount].token = pair.first;
+		state.sessions[sessionCount].authority = pair.second.authority;
+		state.sessions[sessionCount++].tanks = pair.second.TankIdentifiers;
+	}
+	state.sessions.resize(sessionCount);
+
+	state.objects.clear();
+	FOREACH(auto& pair, mObjectStates)
+	{
+		MatchCheckpoint::Object object;
+		object.identifier = pair.first;
+		object.hitpoints = pair.second.hitpoints;
+		object.destroyed = pair.second.destroyed;
+		object.position = pair.second.position;
+		object.setFields = 0;
+		for (std::size_t field = 0; field < ReplicationComponent::FieldCount; ++field)
+		{
+			if (pair.second.fieldVersions[field] > 0)
+				object.setFields |= static_cast<sf::Uint8>(1 << field);
+		}
+		state.objects.push_back(object);
+	}
+
+	// Still writing the previous one: skip, the next checkpoint is only a couple of seconds away
+	mCheckpoint->submit(state);
+}
+
+void GameServer::loadAssets()
+{
+	std::vector<ArenaAssetData> table = initializeArenaAssetData();
+	FOREACH(const ArenaAssetData& entry, table)
+	{
+		std::ifstream file(entry.filename.c_str(), std::ios::binary);
+		if (!file)
+			continue;
+
+		Asset asset;
+		asset.name = entry.name;
+		asset.data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		asset.hash = AssetCache::computeHash(asset.data.empty() ? nullptr : &asset.data[0], asset.data.size());
+		mAssets.push_back(asset);
+	}
+}
+
+void GameServer::sendAssetManifest(RemotePeer& peer)
+{
+	sf::Packet packet;
+	beginPacket(packet, Server::AssetManifest);
+	packet << static_cast<sf::Int32>(mAssets.size());
+
+	FOREACH(const Asset& asset, mAssets)
+		packet << asset.name << asset.hash << static_cast<sf::Uint32>(asset.data.size());
+
+	sendToPeer(peer, packet);
+}
+
+void GameServer::queueAssets(RemotePeer& peer, sf::Packet& request)
+{
+	sf::Int32 count;
+	request >> count;
+
+	for (sf::Int32 i = 0; i < count && request; ++i)
+	{
+		sf::Uint64 hash;
+		request >> hash;
+
+		for (std::size_t asset = 0; asset < mAssets.size(); ++asset)
+		{
+			if (mAssets[asset].hash == hash && std::find(peer.assetQueue.begin(), peer.assetQueue.end(), asset) == peer.assetQueue.end())
+				peer.assetQueue.push_back(asset);
+		}
+	}
+
+	peer.assetOffset = 0;
+}
+
+// Chunks are only queued while the peer's outbound queue is short, so a slow download never overflows it
+void GameServer::streamAssets(RemotePeer& peer)
+{
+	flushOutbound(peer);
+
+	while (!peer.assetQueue.empty() && peer.outboundBytes < AssetWindowBytes && !peer.timedOut)
+	{
+		const Asset& asset = mAssets[peer.assetQueue.front()];
+		std::size_t size = std::min(AssetChunkSize, asset.data.size() - peer.assetOffset);
+
+		sf::Packet packet;
+		beginPacket(packet, Server::AssetChunk);
+		packet << asset.hash << static_cast<sf::Uint32>(peer.assetOffset) << static_cast<sf::Uint32>(size);
+		if (size > 0)
+			packet.append(&asset.data[peer.assetOffset], size);
+		sendToPeer(peer, packet);
+
+		peer.assetOffset += size;
+		if (peer.assetOffset >= asset.data.size())
+		{
+			peer.assetQueue.pop_front();
+			peer.assetOffset = 0;
+		}
+	}
+}
+
+void GameServer::admitPeer(PeerPtr peer, sf::Uint64 sessionToken, sf::Uint32 lastServerTick)
+{
+	// Several connections can be pending when the last slot goes
+	if (mConnectedPlayers >= mMaxConnectedPlayers)
+		return;
+
+	mPeers[mConnectedPlayers] = std::move(peer);
+	RemotePeer& admitted = *mPeers[mConnectedPlayers];
+
+	if (!resumeSession(admitted, sessionToken, lastServerTick))
+		joinNewPlayer(admitted);
+
+	admitted.ready = true;
+	admitted.lastPacketTime = now(); // prevent initial timeouts
+
+	{
+		sf::Lock lock(mStatusMutex);
+		mConnectedPlayers++;
+	}
+
+	if (mConnectedPlayers >= mMaxConnectedPlayers)
+		setListening(false);
+	else // Add a new waiting peer
+		mPeers.push_back(PeerPtr(new RemotePeer()));
+}
+
+void GameServer::joinNewPlayer(RemotePeer& peer)
+{
+	// order the new client to spawn its own plane ( player 1 )
+	mTankInfo[mTankIdentifierCounter].position = sf::Vector2f(mSpawnPoints[mMaxSpawnPoints].x, mSpawnPoints[mMaxSpawnPoints].y);//sf::Vector2f(mBattleFieldRect.width / 2, mBattleFieldRect.top + mBattleFieldRect.height / 2);
+	mTankInfo[mTankIdentifierCounter].hitpoints = 100;
+	mTankInfo[mTankIdentifierCounter].rotation = 0.f;
+	mTankInfo[mTankIdentifierCounter].hitpointsTick = mServerTick;
+
+	sf::Packet packet;
+	beginPacket(packet, Server::SpawnSelf);
+	packet << mTankIdentifierCounter;
+	packet << mTankInfo[mTankIdentifierCounter].position.x;
+	packet << mTankInfo[mTankIdentifierCounter].position.y;
+
+	peer.TankIdentifiers.push_back(mTankIdentifierCounter);
+
+	// Only one authority per match; one that dropped keeps the role for when it resumes
+	peer.authority = peer.helloAuthority && !hasAuthority();
+
+	// A resume hands over the player's tanks, so the token must not follow from the match seed, identifiers or server clock.
+	// Never 0, which means "no session".
+	do
+		peer.sessionToken = mSessionTokenEngine();
+	while (peer.sessionToken == 0);
+
+	broadcastMessage("New player!");
+	informWorldState(peer);
+	notifyPlayerSpawn(mTankIdentifierCounter++);
+
+	sendToPeer(peer, packet);
+
+	sf::Packet tokenPacket;
+	beginPacket(tokenPacket, Server::SessionToken) << peer.sessionToken;
+	sendToPeer(peer, tokenPacket);
+
+	mTankCount++;
+	mMaxSpawnPoints++;
+
+	if (mMaxSpawnPoints >= mSpawnPoints.size()) {
+		mMaxSpawnPoints = 1;
+	}
+}
+
+bool GameServer::resumeSession(RemotePeer& peer, sf::Uint64 sessionToken, sf::Uint32 lastServerTick)
+{
+	if (sessionToken == 0)
+		return false;
+
+	auto suspended = mSuspendedSessions.find(sessionToken);
+	if (suspended != mSuspendedSessions.end())
+	{
+		peer.TankIdentifiers = suspended->second.TankIdentifiers;
+		peer.objectStateAck = suspended->second.objectStateAck;
+		peer.authority = suspended->second.authority;
+		mSuspendedSessions.erase(suspended);
+	}
+	else
+	{
+		// The client noticed the drop before we did: take its tanks over from the stale connection
+		RemotePeer* stale = nullptr;
+		FOREACH(PeerPtr& other, mPeers)
+		{
+			if (other.get() != &peer && other->ready && !other->timedOut && other->sessionToken == sessionToken)
+				stale = other.get();
+		}
+
+		if (!stale)
+			return false;
+
+		peer.TankIdentifiers.swap(stale->TankIdentifiers);
+		peer.objectStateAck = stale->objectStateAck;
+		peer.authority = stale->authority;
+		stale->authority = false;
+		stale->quit = true;
+		stale->timedOut = true;
+		mPendingDisconnections = true;
+	}
+
+	peer.sessionToken = sessionToken;
+	sendSessionDelta(peer, lastServerTick);
+	broadcastMessage("A player reconnected.");
+	return true;
+}
+
+// Everything a resuming client missed since lastServerTick; object states catch up through the peer's restored ack
+void GameServer::sendSessionDelta(RemotePeer& peer, sf::Uint32 lastServerTick)
+{
+	bool full = lastServerTick == 0 || lastServerTick + RosterHistoryTicks < mServerTick || lastServerTick <= mRestoredTick;
+
+	std::vector<sf::Int32> joined, left, changed;
+	if (full)
+	{
+		collectTankIdentifiers(joined);
+		FOREACH(sf::Int32 identifier, peer.TankIdentifiers)
+		{
+			if (mTankInfo.find(identifier) != mTankInfo.end())
+				joined.push_back(identifier);
+		}
+	}
+	else
+	{
+		FOREACH(const RosterEvent& event, mRosterEvents)
+		{
+			if (event.tick <= lastServerTick)
+				continue;
+
+			if (!event.joined)
+				left.push_back(event.identifier);
+			else if (mTankInfo.find(event.identifier) != mTankInfo.end())
+				joined.push_back(event.identifier);
+		}
+
+		FOREACH(auto& pair, mTankInfo)
+		{
+			if (pair.second.hitpointsTick > lastServerTick && std::find(joined.begin(), joined.end(), pair.first) == joined.end())
+				changed.push_back(pair.first);
+		}
+	}
+
+	sf::Packet packet;
+	beginPacket(packet, Server::SessionResumed);
+	packet << peer.sessionToken << full << mBattleFieldRect.top + mBattleFieldRect.height;
+
+	packet << static_cast<sf::Int32>(joined.size());
+	FOREACH(sf::Int32 identifier, joined)
+	{
+		const TankInfo& tank = mTankInfo[identifier];
+		packet << identifier << tank.position.x << tank.position.y << tank.hitpoints << tank.rotation;
+	}
+
+	packet << static_cast<sf::Int32>(left.size());
+	FOREACH(sf::Int32 identifier, left)
+		packet << identifier;
+
+	packet << static_cast<sf::Int32>(changed.size());
+	FOREACH(sf::Int32 identifier, changed)
+		packet << identifier << mTankInfo[identifier].hitpoints;
+
+	sendToPeer(peer, packet);
+}
+
+void GameServer::handleDisconnections()
+{
+	for (auto itr = mPeers.begin(); itr != mPeers.end(); )
+	{
+		if ((*itr)->timedOut)
+		{
+			RemotePeer& peer = **itr;
+
+			// A dropped connection keeps its tanks for a while in case the player comes back, quitting doesn't.
+			// A connection taken over by a resume has no tanks left and goes quietly.
+			if (!peer.quit && peer.sessionToken != 0 && !peer.TankIdentifiers.empty())
+			{
+				suspendSession(peer);
+			}
+			else if (!peer.TankIdentifiers.empty())
+			{
+				removeTanks(peer.TankIdentifiers);
+				broadcastMessage("A Player has disconnected.");
+			}
+
+			{
+				sf::Lock lock(mStatusMutex);
+				mConnectedPlayers--;
+			}
+
+			itr = mPeers.erase(itr);
+
+			// Go back to a listening state if needed
+			if (mConnectedPlayers < mMaxConnectedPlayers)
+			{
+				mPeers.push_back(PeerPtr(new RemotePeer()));
+				setListening(true);
+			}
+		}
+		else
+		{
+			++itr;
+		}
+	}
+}
+
+void GameServer::suspendSession(RemotePeer& peer)
+{
+	SuspendedSession& session = mSuspendedSessions[peer.sessionToken];
+	session.TankIdentifiers = peer.TankIdentifiers;
+	session.suspendTime = now();
+	session.objectStateAck = peer.objectStateAck;
+	session.authority = peer.authority;
+
+	// Release whatever the player was holding down, or the parked tanks keep driving on everyone else's screen
+	FOREACH(sf::Int32 identifier, peer.TankIdentifiers)
+	{
+		auto tank = mTankInfo.find(identifier);
+		if (tank == mTankInfo.end())
+			continue;
+
+		FOREACH(auto& action, tank->second.realtimeActions)
+		{
+			if (action.second)
+			{
+				action.second = false;
+				notifyPlayerRealtimeChange(identifier, action.first, false);
+			}
+		}
+	}
+
+	broadcastMessage("A Player lost connection...");
+}
+
+void GameServer::expireSuspendedSessions()
+{
+	for (auto itr = mSuspendedSessions.begin(); itr != mSuspendedSessions.end(); )
+	{
+		if (now() >= itr->second.suspendTime + mSessionGracePeriod)
+		{
+			removeTanks(itr->second.TankIdentifiers);
+			broadcastMessage("A Player has disconnected.");
+			itr = mSuspendedSessions.erase(itr);
+		}
+		else
+		{
+			++itr;
+		}
+	}
+
+	while (!mRosterEvents.empty() && mRosterEvents.front().tick + RosterHistoryTicks < mServerTick)
+		mRosterEvents.pop_front();
+}
+
+// Inform everyone of the removal, erase
+void GameServer::removeTanks(const std::vector<sf::Int32>& identifiers)
+{
+	FOREACH(sf::Int32 identifier, identifiers)
+	{
+		sf::Packet disconnectPacket;
+		beginPacket(disconnectPacket, Server::PlayerDisconnect) << identifier;
+		sendToAll(disconnectPacket);
+
+		mTankInfo.erase(identifier);
+		recordRosterEvent(identifier, false);
+	}
+
+	mTankCount -= identifiers.size();
+}
+
+void GameServer::recordRosterEvent(sf::Int32 identifier, bool joined)
+{
+	RosterEvent event;
+	event.tick = mServerTick;
+	event.identifier = identifier;
+	event.joined = joined;
+	mRosterEvents.push_back(event);
+}
+
+// Tanks of connected peers and of suspended sessions, which stay in the world until they expire
+void GameServer::collectTankIdentifiers(std::vector<sf::Int32>& identifiers) const
+{
+	FOREACH(const PeerPtr& peer, mPeers)
+	{
+		if (!peer->ready)
+			continue;
+
+		FOREACH(sf::Int32 identifier, peer->TankIdentifiers)
+		{
+			if (mTankInfo.find(identifier) != mTankInfo.end())
+				identifiers.push_back(identifier);
+		}
+	}
+
+	FOREACH(auto& session, mSuspendedSessions)
+	{
+		FOREACH(sf::Int32 identifier, session.second.TankIdentifiers)
+		{
+			if (mTankInfo.find(identifier) != mTankInfo.end())
+				identifiers.push_back(identifier);
+		}
+	}
+}
+
+bool GameServer::hasAuthority() const
+{
+	FOREACH(const PeerPtr& peer, mPeers)
+	{
+		if (peer->ready && !peer->timedOut && peer->authority)
+			return true;
+	}
+
+	FOREACH(auto& session, mSuspendedSessions)
+	{
+		if (session.second.authority)
+			return true;
+	}
+
+	return false;
+}
+
+// Tell the newly connected peer about how the world is currently
+void GameServer::informWorldState(RemotePeer& peer)
+{
+	sf::Packet packet;
+	beginPacket(packet, Server::InitialState);
+	packet << mWorldHeight << mBattleFieldRect.top + mBattleFieldRect.height;
+
+	// Suspended players' tanks are still in the world, so newcomers have to see them too
+	std::vector<sf::Int32> identifiers;
+	collectTankIdentifiers(identifiers);
+	packet << static_cast<sf::Int32>(identifiers.size());
+
+	FOREACH(sf::Int32 identifier, identifiers)
+		packet << identifier << mTankInfo[identifier].position.x << mTankInfo[identifier].position.y << mTankInfo[identifier].hitpoints << mTankInfo[identifier].rotation;
+
+	sendToPeer(peer, packet);
+
+	sf::Packet seedPacket;
+	beginPacket(seedPacket, Server::MatchSeed) << mMatchSeed;
+	sendToPeer(peer, seedPacket);
+}
+
+void GameServer::broadcastMessage(const std::string& message)
+{
+	sf::Packet packet;
+	beginPacket(packet, Server::BroadcastMessage);
+	packet << message;
+
+	sendToAll(packet);
+}
+
+void GameServer::sendToAll(sf::Packet& packet)
+{
+	FOREACH(PeerPtr& peer, mPeers)
+	{
+		if (peer->ready)
+			sendToPeer(*peer, packet);
+	}
+
+	if (mRelayPeer->ready)
+		sendToPeer(*mRelayPeer, packet);
+}
+
+// All traffic to a peer goes through its queue, so a partially written packet is finished before the next one starts
+void GameServer::sendToPeer(RemotePeer& peer, sf::Packet& packet, bool snapshot)
+{
+	if (peer.timedOut)
+		return;
+
+	std::size_t size = packet.getDataSize() + sizeof(sf::Uint32);
+
+	// A newer snapshot makes a queued one pointless; replace it in place to keep its position in the stream
+	if (snapshot)
+	{
+		for (std::size_t i = peer.sendInProgress ? 1 : 0; i < peer.outbound.size(); ++i)
+		{
+			OutboundPacket& queued = peer.outbound[i];
+			if (queued.snapshot)
+			{
+				peer.outboundBytes -= queued.packet.getDataSize() + sizeof(sf::Uint32);
+				peer.outboundBytes += size;
+				queued.packet = packet;
+				flushOutbound(peer);
+				return;
+			}
+		}
+	}
+
+	OutboundPacket outbound;
+	outbound.packet = packet;
+	outbound.snapshot = snapshot;
+	peer.outbound.push_back(outbound);
+	peer.outboundBytes += size;
+
+	// Never buffer without bound for one slow client
+	if (peer.outboundBytes > MaxOutboundBytes)
+	{
+		peer.outbound.clear();
+		peer.outboundBytes = 0;
+		peer.timedOut = true;
+		mPendingDisconnections = true;
+		return;
+	}
+
+	flushOutbound(peer);
+}
+
+void GameServer::flushOutbound(RemotePeer& peer)
+{
+	while (!peer.outbound.empty())
+	{
+		OutboundPacket& front = peer.outbound.front();
+		std::size_t size = front.packet.getDataSize() + sizeof(sf::Uint32);
+
+		sf::Socket::Status status = peer.socket.send(front.packet);
+		if (status == sf::Socket::Partial)
+		{
+			peer.sendInProgress = true;
+			return;
+		}
+
+		// NotReady: socket buffer full, try again next loop. Errors are picked up by the receive side.
+		if (status != sf::Socket::Done)
+			return;
+
+		peer.outboundBytes -= size;
+		peer.outbound.pop_front();
+		peer.sendInProgress = false;
+	}
+}
+
+// Runs every tick: probes RTT and adapts each peer's snapshot interval. Multiplicative back-off on
+// congestion (at most once per RTT), slow additive recovery once the queue and RTT settle again.
+void GameServer::updateSendRates()
+{
+	FOREACH(PeerPtr& peer, mPeers)
+	{
+		if (!peer->ready)
+			continue;
+
+		if (!peer->pingOutstanding && now() >= peer->pingSendTime + PingInterval)
+		{
+			sf::Packet pingPacket;
+			beginPacket(pingPacket, Server::Ping) << ++peer->pingSequence;
+			sendToPeer(*peer, pingPacket);
+
+			peer->pingSendTime = now();
+			peer->pingOutstanding = true;
+		}
+
+		// RTT growth over the path's base RTT is queueing somewhere; an unanswered ping counts as a sample too
+		sf::Time rtt = peer->smoothedRtt;
+		if (peer->pingOutstanding)
+			rtt = std::max(rtt, now() - peer->pingSendTime);
+
+		bool rttGrowing = peer->hasRtt && rtt > peer->minRtt * 2.f + sf::milliseconds(50);
+		bool congested = rttGrowing || peer->outboundBytes > CongestedQueueBytes;
+
+		if (congested && now() >= peer->lastRateChange + std::max(peer->smoothedRtt, MinSnapshotInterval * 2.f))
+		{
+			peer->snapshotInterval = std::min(peer->snapshotInterval * 2.f, MaxSnapshotInterval);
+			peer->lowPrecision = true;
+			peer->lastRateChange = now();
+		}
+		else if (!congested && peer->snapshotInterval > MinSnapshotInterval && now() >= peer->lastRateChange + sf::seconds(1.f))
+		{
+			peer->snapshotInterval = std::max(peer->snapshotInterval - sf::milliseconds(25), MinSnapshotInterval);
+			peer->lowPrecision = peer->snapshotInterval > MinSnapshotInterval;
+			peer->lastRateChange = now();
+		}
+	}
+}
+
+void GameServer::handlePong(RemotePeer& peer, sf::Uint32 sequence)
+{
+	if (!peer.pingOutstanding || sequence != peer.pingSequence)
+		return;
+
+	sf::Time sample = now() - peer.pingSendTime;
+	peer.pingOutstanding = false;
+
+	if (!peer.hasRtt)
+	{
+		peer.smoothedRtt = sample;
+		peer.minRtt = sample;
+		peer.hasRtt = true;
+		return;
+	}
+
+	peer.smoothedRtt += (sample - peer.smoothedRtt) / 8.f;
+
+	// Let the base RTT creep up slowly so a route change doesn't look like permanent congestion
+	peer.minRtt = std::min(peer.minRtt + sf::milliseconds(1), sample);
+}
+
+sf::Packet& GameServer::beginPacket(sf::Packet& packet, Server::PacketType type) const
+{
+	packet << static_cast<sf::Int32>(type) << mServerTick;
+	return packet;
 }
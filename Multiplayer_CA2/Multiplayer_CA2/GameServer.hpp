@@ -1,41 +1,132 @@
 #ifndef BOOK_GAMESERVER_HPP
 #define BOOK_GAMESERVER_HPP
 
+#include "MatchRecorder.hpp"
+#include "MatchCheckpoint.hpp"
+#include "ReplicationComponent.hpp"
+#include "NetworkProtocol.hpp"
+#include "StateHash.hpp"
+
 #include <SFML/System/Vector2.hpp>
 #include <SFML/System/Thread.hpp>
 #include <SFML/System/Clock.hpp>
 #include <SFML/System/Sleep.hpp>
+#include <SFML/System/Mutex.hpp>
+#include <SFML/System/Lock.hpp>
 #include <SFML/Graphics/Rect.hpp>
 #include <SFML/Network/TcpListener.hpp>
 #include <SFML/Network/TcpSocket.hpp>
 
+#include <SFML/Network/Packet.hpp>
+
 #include <vector>
+#include <deque>
 #include <memory>
 #include <map>
+#include <random>
 
 
 class GameServer
 {
 	public:
-		explicit							GameServer(sf::Vector2f battlefieldSize);
+		// Inbound overload counters, see handleIncomingPackets
+		struct Metrics
+		{
+												Metrics();
+
+			sf::Uint64							packetsHandled;
+			sf::Uint64							throttledReads;		// A peer's bucket ran dry with packets possibly still waiting
+			sf::Uint64							budgetExhaustions;	// Loop iterations that hit the shared packet budget
+			sf::Uint64							overloadDisconnects;
+			sf::Uint64							desyncReports;
+		};
+
+
+	public:
+		explicit							GameServer(sf::Vector2f battlefieldSize, const std::string& recordingFile = "", unsigned short port = ServerPort);
 											~GameServer();
 
+		// Safe to call from other threads, e.g. the lobby deciding where to place players
+		std::size_t							getConnectedPlayers() const;
+		Metrics								getMetrics() const;
+		std::size_t							getMaxPlayers() const;
+		unsigned short						getPort() const;
+
 		void								notifyPlayerSpawn(sf::Int32 TankIdentifier);
 		void								notifyPlayerRealtimeChange(sf::Int32 TankIdentifier, sf::Int32 action, bool actionEnabled);
 		void								notifyPlayerEvent(sf::Int32 TankIdentifier, sf::Int32 action);
 
 
 	private:
+		struct OutboundPacket
+		{
+			sf::Packet				packet;
+			bool					snapshot;		// Superseded by the next snapshot if still waiting
+		};
+
 		// A GameServerRemotePeer refers to one instance of the game, may it be local or from another computer
 		struct RemotePeer
 		{
 									RemotePeer();
 
 			sf::TcpSocket			socket;
+			std::deque<OutboundPacket>	outbound;
+			std::size_t				outboundBytes;
+			bool					sendInProgress;	// Front packet was partially written
 			sf::Time				lastPacketTime;
 			std::vector<sf::Int32>	TankIdentifiers;
 			bool					ready;
 			bool					timedOut;
+			bool					quit;			// Left on purpose, no session to keep
+			bool					authority;		// Its world owns obstacles and pickups, the only source of object states
+
+			// Inbound token bucket, one token per packet
+			float					receiveTokens;
+			sf::Time				tokenRefillTime;
+			bool					drained;		// Socket had nothing left this loop
+			bool					throttled;
+			sf::Time				throttledSince;
+			sf::Uint64				sessionToken;
+
+			sf::Uint32				objectStateAck;		// Newest object state version the peer confirmed
+			sf::Uint32				objectStateSent;	// Newest object state version sent to the peer
+			sf::Time				objectStateSendTime;
+
+			// Congestion control: snapshot rate and precision follow RTT growth and queue depth
+			sf::Time				snapshotInterval;
+			sf::Uint32				lastSnapshotTick;
+			sf::Time				lastRateChange;
+			bool					lowPrecision;
+
+			sf::Uint32				pingSequence;
+			sf::Time				pingSendTime;
+			bool					pingOutstanding;
+			bool					hasRtt;
+			sf::Time				smoothedRtt;
+			sf::Time				minRtt;
+
+			// Join handshake: Hello, then the asset manifest and the blobs the client doesn't have cached
+			bool					helloReceived;
+			sf::Uint64				helloToken;
+			sf::Uint32				helloTick;
+			bool					helloAuthority;		// Asked for authority: the host's own client, or the lobby's pick
+			bool					assetsRequested;
+			std::deque<std::size_t>	assetQueue;			// Indices into mAssets
+			std::size_t				assetOffset;		// Bytes of the front asset already queued
+
+			// Desync detection: a mismatch has to persist before the peer is probed for details
+			bool					desyncMismatch;
+			sf::Time				desyncSince;
+			sf::Uint32				desyncFirstTick;
+			bool					desyncReported;
+		};
+
+		// Arena file clients need before joining, advertised by content hash
+		struct Asset
+		{
+			std::string					name;
+			sf::Uint64					hash;
+			std::vector<char>			data;
 		};
 
 		// Structure to store information about current Tank state
@@ -45,6 +136,42 @@ class GameServer
 			sf::Int32					hitpoints;
 			float						rotation;
 			std::map<sf::Int32, bool>	realtimeActions;
+			sf::Uint32					hitpointsTick;	// Server tick of the last hitpoint change
+		};
+
+		// Tanks of a peer that dropped without quitting, kept until it resumes or the grace period runs out
+		struct SuspendedSession
+		{
+			std::vector<sf::Int32>		TankIdentifiers;
+			sf::Time					suspendTime;
+			sf::Uint32					objectStateAck;
+			bool						authority;
+		};
+
+		// Tank joins and removals, so a resuming peer only hears about what it missed
+		struct RosterEvent
+		{
+			sf::Uint32					tick;
+			sf::Int32					identifier;
+			bool						joined;
+		};
+
+		// Last known state of a replicated obstacle or pickup, with the version each field last changed in
+		struct ObjectState
+		{
+										ObjectState();
+
+			sf::Int32					hitpoints;
+			bool						destroyed;
+			sf::Vector2f				position;
+			sf::Uint32					fieldVersions[ReplicationComponent::FieldCount];
+		};
+
+		// State hash of the tick a snapshot was built in, kept until clients report theirs for it
+		struct TickHash
+		{
+			sf::Uint32					tick;
+			StateHash					hash;
 		};
 
 		// Unique pointer to remote peers
@@ -53,31 +180,68 @@ class GameServer
 
 	private:
 		void								setListening(bool enable);
+		void								handleRelayConnection();
 		void								executionThread();
 		void								tick();
 		sf::Time							now() const;
 
 		void								handleIncomingPackets();
 		void								handleIncomingPacket(sf::Packet& packet, RemotePeer& receivingPeer, bool& detectedTimeout);
+		void								refillReceiveTokens(RemotePeer& peer);
+		void								checkOverload(RemotePeer& peer, bool& detectedTimeout);
 
 		void								handleIncomingConnections();
+		void								handlePendingPeers();
+		void								admitPeer(PeerPtr peer, sf::Uint64 sessionToken, sf::Uint32 lastServerTick);
+		void								loadAssets();
+		void								restoreCheckpoint();
+		void								writeCheckpoint();
+		void								sendAssetManifest(RemotePeer& peer);
+		void								queueAssets(RemotePeer& peer, sf::Packet& request);
+		void								streamAssets(RemotePeer& peer);
+		void								joinNewPlayer(RemotePeer& peer);
+		bool								resumeSession(RemotePeer& peer, sf::Uint64 sessionToken, sf::Uint32 lastServerTick);
+		void								sendSessionDelta(RemotePeer& peer, sf::Uint32 lastServerTick);
 		void								handleDisconnections();
+		void								suspendSession(RemotePeer& peer);
+		void								expireSuspendedSessions();
+		void								removeTanks(const std::vector<sf::Int32>& identifiers);
+		void								recordRosterEvent(sf::Int32 identifier, bool joined);
+		void								collectTankIdentifiers(std::vector<sf::Int32>& identifiers) const;
+		bool								hasAuthority() const;
 
-		void								informWorldState(sf::TcpSocket& socket);
+		void								informWorldState(RemotePeer& peer);
 		void								broadcastMessage(const std::string& message);
 		void								sendToAll(sf::Packet& packet);
+		void								sendToPeer(RemotePeer& peer, sf::Packet& packet, bool snapshot = false);
+		void								flushOutbound(RemotePeer& peer);
+		void								updateSendRates();
+		void								handlePong(RemotePeer& peer, sf::Uint32 sequence);
+		sf::Packet&							beginPacket(sf::Packet& packet, Server::PacketType type) const;
 		void								updateClientState();
+		void								updateObjectStates();
+		void								sendObjectStates(RemotePeer& peer, sf::Uint32 baseVersion);
+		void								updateStateHash();
+		const TickHash*						findTickHash(sf::Uint32 tick) const;
+		void								checkStateHash(RemotePeer& peer, sf::Uint32 tick, sf::Uint32 hash);
+		void								reportDesync(RemotePeer& peer, sf::Uint32 tick, const StateHash::Entries& clientEntries);
 
 
 	private:
 		sf::Thread							mThread;
 		sf::Clock							mClock;
+		unsigned short						mPort;
 		sf::TcpListener						mListenerSocket;
 		bool								mListeningState;
+		sf::TcpListener						mRelayListenerSocket;
+		PeerPtr								mRelayPeer;
 		sf::Time							mClientTimeoutTime;
 
 		std::size_t							mMaxConnectedPlayers;
 		std::size_t							mConnectedPlayers;
+		mutable sf::Mutex					mStatusMutex;		// Guards mConnectedPlayers and mMetrics for other threads
+		Metrics								mMetrics;
+		std::size_t							mReceiveCursor;		// Peer the next round robin pass starts at
 		std::size_t							mMaxSpawnPoints;
 
 		float								mWorldHeight;
@@ -89,11 +253,37 @@ class GameServer
 		std::map<sf::Int32, TankInfo>		mTankInfo;
 
 		std::vector<PeerPtr>				mPeers;
+		std::vector<PeerPtr>				mPendingPeers;		// Accepted, not admitted until Hello and asset transfer are done
+		std::vector<Asset>					mAssets;
 		sf::Int32							mTankIdentifierCounter;
 		bool								mWaitingThreadEnd;
 		
 		sf::Time							mLastSpawnTime;
 		sf::Time							mTimeForNextSpawn;
+
+		std::unique_ptr<MatchRecorder>		mRecorder;
+
+		std::map<sf::Int32, ObjectState>	mObjectStates;
+		sf::Uint32							mObjectStateVersion;
+		sf::Time							mObjectStateResendTime;
+
+		sf::Uint64							mMatchSeed;
+		bool								mPendingDisconnections;
+		sf::Uint32							mServerTick;
+
+		std::map<sf::Uint64, SuspendedSession>	mSuspendedSessions;
+		sf::Time							mSessionGracePeriod;
+		std::mt19937_64						mSessionTokenEngine;	// Seeded from std::random_device, nothing clients see goes into a token
+		std::deque<RosterEvent>				mRosterEvents;
+
+		StateHash							mStateHash;
+		std::vector<sf::Int32>				mHashedTanks;
+		std::deque<TickHash>				mTickHashes;
+
+		std::string							mCheckpointFile;
+		std::unique_ptr<MatchCheckpoint>	mCheckpoint;
+		MatchCheckpoint::State				mCheckpointState;	// Reused to avoid reallocating after warm-up
+		sf::Uint32							mRestoredTick;		// Resumes from before this tick get the full state, the roster log was lost
 };
 
 #endif // BOOK_GAMESERVER_HPP
@@ -8,7 +8,7 @@
 
 GameState::GameState(StateStack& stack, Context context)
 : State(stack, context)
-, mWorld(*context.window, *context.fonts, *context.sounds, false)
+, mWorld(*context.window, *context.fonts, *context.sounds, *context.jobs, false)
 , mPlayer(nullptr, 1, context.keys1)
 {
 	mWorld.addTank(1);
@@ -0,0 +1,154 @@
+//D00137655 - Jason Lynch
+//D00194504 - Dylan
+#include "JobSystem.hpp"
+#include "Foreach.hpp"
+
+
+namespace
+{
+	std::size_t getDefaultWorkerCount()
+	{
+		// Zero when the hardware thread count isn't known, the calling thread then does all the work
+		unsigned int threads = std::thread::hardware_concurrency();
+		return threads > 1 ? threads - 1 : 0;
+	}
+}
+
+JobSystem::JobSystem()
+: JobSystem(getDefaultWorkerCount())
+{
+}
+
+JobSystem::JobSystem(std::size_t workerCount)
+: mQueues()
+, mThreads()
+, mQueuedJobs(0)
+, mWakeMutex()
+, mWake()
+, mStopping(false)
+{
+	for (std::size_t i = 0; i <= workerCount; ++i)
+		mQueues.push_back(std::unique_ptr<Queue>(new Queue()));
+
+	for (std::size_t i = 0; i < workerCount; ++i)
+		mThreads.push_back(std::thread(&JobSystem::workerThread, this, i));
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(mWakeMutex);
+		mStopping = true;
+	}
+
+	mWake.notify_all();
+	FOREACH(std::thread& thread, mThreads)
+		thread.join();
+}
+
+std::size_t JobSystem::getThreadCount() const
+{
+	return mQueues.size();
+}
+
+void JobSystem::run(Batch& batch, std::size_t count)
+{
+	if (count == 0)
+		return;
+
+	// Nothing to share the work with
+	if (mThreads.empty() || count == 1)
+	{
+		for (std::size_t i = 0; i < count; ++i)
+			batch.invoke(batch.function, i);
+		return;
+	}
+
+	batch.remaining = count;
+
+	// Counted first, so a worker never sees a job before the count that wakes it up
+	mQueuedJobs += count;
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		Queue& queue = *mQueues[i % mQueues.size()];
+		Job job = { &batch, i };
+
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(job);
+	}
+
+	// Taking the lock orders the count before any worker's check of it, no wake up gets lost
+	{
+		std::lock_guard<std::mutex> lock(mWakeMutex);
+	}
+	mWake.notify_all();
+
+	Job job;
+	std::size_t self = mQueues.size() - 1;
+	while (batch.remaining.load(std::memory_order_acquire) != 0)
+	{
+		if (takeJob(self, job))
+			execute(job);
+		else
+			std::this_thread::yield();
+	}
+}
+
+void JobSystem::workerThread(std::size_t self)
+{
+	Job job;
+	for (;;)
+	{
+		if (takeJob(self, job))
+		{
+			execute(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(mWakeMutex);
+		mWake.wait(lock, [this] () { return mStopping || mQueuedJobs.load() != 0; });
+
+		if (mStopping)
+			return;
+	}
+}
+
+bool JobSystem::takeJob(std::size_t self, Job& job)
+{
+	// Own queue from the back, the most recently pushed job
+	{
+		Queue& own = *mQueues[self];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.jobs.empty())
+		{
+			job = own.jobs.back();
+			own.jobs.pop_back();
+			--mQueuedJobs;
+			return true;
+		}
+	}
+
+	// Then steal from the front of the others', starting with the next one so thieves spread out
+	for (std::size_t offset = 1; offset < mQueues.size(); ++offset)
+	{
+		Queue& victim = *mQueues[(self + offset) % mQueues.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.jobs.empty())
+		{
+			job = victim.jobs.front();
+			victim.jobs.pop_front();
+			--mQueuedJobs;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void JobSystem::execute(const Job& job)
+{
+	job.batch->invoke(job.batch->function, job.index);
+
+	// Last access to the batch, the thread waiting in run() may destroy it right after
+	job.batch->remaining.fetch_sub(1, std::memory_order_acq_rel);
+}
@@ -0,0 +1,79 @@
+#ifndef BOOK_JOBSYSTEM_HPP
+#define BOOK_JOBSYSTEM_HPP
+
+#include <SFML/System/NonCopyable.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// Worker threads that take jobs from their own queue and steal from the others' once it runs dry, so an
+// uneven batch (one crowded collision cell, one tank with many emitters) doesn't leave the rest idle.
+// The thread calling parallelFor() works through the jobs as well and returns when all of them are done.
+// SFML has no condition variable or atomics, hence the standard library threads.
+class JobSystem : private sf::NonCopyable
+{
+	public:
+		// One worker per hardware thread besides the calling one
+										JobSystem();
+		explicit						JobSystem(std::size_t workerCount);
+										~JobSystem();
+
+		// Calls function(i) once for every i in [0, count), in no particular order and possibly concurrently.
+		// Callers that need a deterministic result write to storage per index and merge it afterwards.
+		template <typename Function>
+		void							parallelFor(std::size_t count, const Function& function);
+
+		// Workers plus the calling thread
+		std::size_t						getThreadCount() const;
+
+
+	private:
+		struct Batch
+		{
+			void						(*invoke)(const void* function, std::size_t index);
+			const void*					function;
+			std::atomic<std::size_t>	remaining;
+		};
+
+		struct Job
+		{
+			Batch*						batch;
+			std::size_t					index;
+		};
+
+		struct Queue
+		{
+			std::mutex					mutex;
+			std::deque<Job>				jobs;
+		};
+
+
+	private:
+		void							run(Batch& batch, std::size_t count);
+		void							workerThread(std::size_t self);
+		bool							takeJob(std::size_t self, Job& job);
+		static void						execute(const Job& job);
+
+		template <typename Function>
+		static void						invoke(const void* function, std::size_t index);
+
+
+	private:
+		// One per worker, the calling thread's last
+		std::vector<std::unique_ptr<Queue>>	mQueues;
+		std::vector<std::thread>		mThreads;
+
+		std::atomic<std::size_t>		mQueuedJobs;
+		std::mutex						mWakeMutex;
+		std::condition_variable			mWake;
+		bool							mStopping;		// Guarded by mWakeMutex
+};
+
+#include "JobSystem.inl"
+#endif // BOOK_JOBSYSTEM_HPP
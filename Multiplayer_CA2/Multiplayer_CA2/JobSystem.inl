@@ -0,0 +1,16 @@
+
+template <typename Function>
+void JobSystem::parallelFor(std::size_t count, const Function& function)
+{
+	// The function stays on the caller's stack, run() doesn't return before the last job is done
+	Batch batch;
+	batch.invoke = &JobSystem::invoke<Function>;
+	batch.function = &function;
+	run(batch, count);
+}
+
+template <typename Function>
+void JobSystem::invoke(const void* function, std::size_t index)
+{
+	(*static_cast<const Function*>(function))(index);
+}
@@ -44,8 +44,31 @@ JoinIpEntryState::JoinIpEntryState(StateStack& stack, Context context)
 			requestStackPush(States::JoinGame);
 		});
 
+	auto spectateButton = std::make_shared<GUI::Button>(context);
+	spectateButton->setPosition(100, 400);
+	spectateButton->setText("Spectate");
+	spectateButton->setCallback([this]()
+		{
+			JoinIpAddress = mIpAddress;
+
+			requestStackPop();
+			requestStackPush(States::SpectateGame);
+		});
+
+	// Queue through the matchmaking lobby instead, the address field names the lobby (empty for this machine)
+	auto findMatchButton = std::make_shared<GUI::Button>(context);
+	findMatchButton->setPosition(100, 450);
+	findMatchButton->setText("Find Match");
+	findMatchButton->setCallback([this]()
+		{
+			JoinIpAddress = mIpAddress;
+
+			requestStackPop();
+			requestStackPush(States::Lobby);
+		});
+
 	auto backButton = std::make_shared<GUI::Button>(context);
-	backButton->setPosition(100, 400);
+	backButton->setPosition(100, 500);
 	backButton->setText("Back");
 	backButton->setCallback([this]()
 		{
@@ -84,6 +107,8 @@ JoinIpEntryState::JoinIpEntryState(StateStack& stack, Context context)
 	//mGUIContainer.pack(mBindingButtons[0]);
 	mGUIContainer.pack(mBindingButtons[1]);
 	mGUIContainer.pack(connectButton);
+	mGUIContainer.pack(spectateButton);
+	mGUIContainer.pack(findMatchButton);
 	mGUIContainer.pack(backButton);
 
 	// Play menu theme
@@ -0,0 +1,110 @@
+//D00137655 - Jason Lynch
+//D00194504 - Dylan
+#include "LabelBatch.hpp"
+#include "Foreach.hpp"
+
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/Texture.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+
+namespace
+{
+	// sf::Text pads every glyph quad by a texel, so smoothing doesn't cut off its edges
+	const float GlyphPadding = 1.f;
+
+	void addQuad(std::vector<sf::Vertex>& vertices, float left, float top, float right, float bottom, const sf::FloatRect& texture, sf::Color color)
+	{
+		float textureRight = texture.left + texture.width;
+		float textureBottom = texture.top + texture.height;
+
+		vertices.push_back(sf::Vertex(sf::Vector2f(left, top), color, sf::Vector2f(texture.left, texture.top)));
+		vertices.push_back(sf::Vertex(sf::Vector2f(right, top), color, sf::Vector2f(textureRight, texture.top)));
+		vertices.push_back(sf::Vertex(sf::Vector2f(right, bottom), color, sf::Vector2f(textureRight, textureBottom)));
+		vertices.push_back(sf::Vertex(sf::Vector2f(left, bottom), color, sf::Vector2f(texture.left, textureBottom)));
+	}
+}
+
+LabelBatch::LabelBatch(const sf::Font& font, unsigned int characterSize)
+: SceneNode()
+, mFont(font)
+, mCharacterSize(characterSize)
+, mVertexArray(sf::Quads)
+{
+}
+
+void LabelBatch::setText(Label& label, const std::string& text, sf::Color color) const
+{
+	label.vertices.clear();
+
+	float minX = std::numeric_limits<float>::max();
+	float minY = std::numeric_limits<float>::max();
+	float maxX = -std::numeric_limits<float>::max();
+	float maxY = -std::numeric_limits<float>::max();
+
+	// Pen position on the baseline
+	float x = 0.f;
+	sf::Uint32 previous = 0;
+	for (std::size_t i = 0; i < text.size(); ++i)
+	{
+		sf::Uint32 character = static_cast<unsigned char>(text[i]);
+		x += mFont.getKerning(previous, character, mCharacterSize);
+		previous = character;
+
+		const sf::Glyph& glyph = mFont.getGlyph(character, mCharacterSize, false);
+		if (glyph.bounds.width > 0.f && glyph.bounds.height > 0.f)
+		{
+			float left = x + glyph.bounds.left;
+			float top = glyph.bounds.top;
+			float right = left + glyph.bounds.width;
+			float bottom = top + glyph.bounds.height;
+
+			sf::FloatRect texture(static_cast<float>(glyph.textureRect.left) - GlyphPadding, static_cast<float>(glyph.textureRect.top) - GlyphPadding,
+				static_cast<float>(glyph.textureRect.width) + 2.f * GlyphPadding, static_cast<float>(glyph.textureRect.height) + 2.f * GlyphPadding);
+			addQuad(label.vertices, left - GlyphPadding, top - GlyphPadding, right + GlyphPadding, bottom + GlyphPadding, texture, color);
+
+			minX = std::min(minX, left);
+			minY = std::min(minY, top);
+			maxX = std::max(maxX, right);
+			maxY = std::max(maxY, bottom);
+		}
+
+		x += glyph.advance;
+	}
+
+	if (label.vertices.empty())
+		return;
+
+	// Same rounding as centerOrigin(), so glyphs stay on whole pixels
+	sf::Vector2f center(std::floor((minX + maxX) / 2.f), std::floor((minY + maxY) / 2.f));
+	FOREACH(sf::Vertex& vertex, label.vertices)
+		vertex.position -= center;
+}
+
+void LabelBatch::clear()
+{
+	// Keeps the vertex storage of earlier frames
+	mVertexArray.clear();
+}
+
+void LabelBatch::append(const Label& label, sf::Vector2f position, float scale)
+{
+	FOREACH(const sf::Vertex& vertex, label.vertices)
+	{
+		sf::Vertex placed = vertex;
+		placed.position = position + vertex.position * scale;
+		mVertexArray.append(placed);
+	}
+}
+
+void LabelBatch::drawCurrent(sf::RenderTarget& target, sf::RenderStates states) const
+{
+	if (mVertexArray.getVertexCount() == 0)
+		return;
+
+	states.texture = &mFont.getTexture(mCharacterSize);
+	target.draw(mVertexArray, states);
+}
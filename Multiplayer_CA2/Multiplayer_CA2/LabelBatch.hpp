@@ -0,0 +1,49 @@
+#ifndef BOOK_LABELBATCH_HPP
+#define BOOK_LABELBATCH_HPP
+
+#include "SceneNode.hpp"
+
+#include <SFML/Graphics/Font.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+#include <SFML/Graphics/VertexArray.hpp>
+
+#include <string>
+#include <vector>
+
+
+// Small labels (tank hitpoints) drawn with one vertex array from a single font size, so they share that size's
+// glyph page and cost one draw call together. A label's glyph quads are laid out only when its text changes;
+// every frame its owner appends them at the label's current position.
+class LabelBatch : public SceneNode
+{
+	public:
+		// Owned by whoever shows the label
+		struct Label
+		{
+			std::vector<sf::Vertex>	vertices;		// Quads around the label's centre, unscaled
+		};
+
+
+	public:
+								LabelBatch(const sf::Font& font, unsigned int characterSize);
+
+		// Lays the text out the way sf::Text would, centred like centerOrigin() does; main thread only,
+		// as it may add glyphs to the font
+		void					setText(Label& label, const std::string& text, sf::Color color) const;
+
+		// The frame's labels: cleared, then appended with the position of their centre in world coordinates
+		void					clear();
+		void					append(const Label& label, sf::Vector2f position, float scale);
+
+
+	private:
+		virtual void			drawCurrent(sf::RenderTarget& target, sf::RenderStates states) const;
+
+
+	private:
+		const sf::Font&			mFont;
+		unsigned int			mCharacterSize;
+		sf::VertexArray			mVertexArray;
+};
+
+#endif // BOOK_LABELBATCH_HPP
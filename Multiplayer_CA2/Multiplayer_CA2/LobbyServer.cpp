@@ -0,0 +1,291 @@
+//D00137655 - Jason Lynch
+//D00194504 - Dylan
+#include "LobbyServer.hpp"
+#include "NetworkProtocol.hpp"
+#include "Foreach.hpp"
+
+#include <SFML/System/Sleep.hpp>
+
+#include <algorithm>
+#include <iostream>
+
+
+namespace
+{
+	// A partial group is started once its oldest player has waited this long
+	const sf::Time MaxQueueWait = sf::seconds(5.f);
+
+	// Handed off players count against a server until they connect or this runs out
+	const sf::Time ReservationTimeout = sf::seconds(5.f);
+
+	const sf::Time IdleServerTimeout = sf::seconds(30.f);
+	const sf::Time StatusInterval = sf::seconds(1.f);
+
+	const sf::Vector2f BattlefieldSize(1024.f, 768.f);
+}
+
+LobbyServer::QueuedClient::QueuedClient()
+: queued(false)
+, queueTime(sf::Time::Zero)
+, handoffPending(false)
+{
+	socket.setBlocking(false);
+}
+
+LobbyServer::LobbyServer(std::size_t playersPerMatch, std::size_t maxServers, const std::string& advertisedAddress)
+: mListenerSocket()
+, mClients()
+, mServers()
+, mPlayersPerMatch(std::max<std::size_t>(playersPerMatch, 1))
+, mMaxServers(std::max<std::size_t>(maxServers, 1))
+, mAdvertisedAddress(advertisedAddress)
+, mLastStatusTime(sf::Time::Zero)
+{
+	mListenerSocket.setBlocking(false);
+}
+
+void LobbyServer::run()
+{
+	if (mListenerSocket.listen(LobbyPort) != sf::TcpListener::Done)
+	{
+		std::cout << "Lobby: could not listen on port " << LobbyPort << std::endl;
+		return;
+	}
+
+	std::cout << "Lobby: matching groups of " << mPlayersPerMatch << " on port " << LobbyPort
+		<< ", up to " << mMaxServers << " match servers" << std::endl;
+
+	for (;;)
+	{
+		handleIncomingClients();
+		handleClientPackets();
+		formMatches();
+		sendHandoffs();
+		shutDownIdleServers();
+
+		if (now() >= mLastStatusTime + StatusInterval)
+		{
+			sendQueueStatus();
+			mLastStatusTime = now();
+		}
+
+		sf::sleep(sf::milliseconds(50));
+	}
+}
+
+void LobbyServer::handleIncomingClients()
+{
+	ClientPtr client(new QueuedClient());
+	while (mListenerSocket.accept(client->socket) == sf::TcpListener::Done)
+	{
+		mClients.push_back(std::move(client));
+		client.reset(new QueuedClient());
+	}
+}
+
+void LobbyServer::handleClientPackets()
+{
+	for (auto itr = mClients.begin(); itr != mClients.end(); )
+	{
+		QueuedClient& client = **itr;
+
+		sf::Packet packet;
+		sf::Socket::Status status;
+		while ((status = client.socket.receive(packet)) == sf::Socket::Done)
+		{
+			sf::Int32 packetType;
+			packet >> packetType;
+
+			if (packetType == Lobby::JoinQueue && !client.queued && !client.handoffPending)
+			{
+				client.queued = true;
+				client.queueTime = now();
+			}
+
+			packet.clear();
+		}
+
+		// Clients hang up once they have their match, or when they give up waiting
+		if (status == sf::Socket::Disconnected)
+			itr = mClients.erase(itr);
+		else
+			++itr;
+	}
+}
+
+void LobbyServer::formMatches()
+{
+	std::vector<QueuedClient*> queue;
+	FOREACH(ClientPtr& client, mClients)
+	{
+		if (client->queued)
+			queue.push_back(client.get());
+	}
+
+	std::stable_sort(queue.begin(), queue.end(), [] (QueuedClient* lhs, QueuedClient* rhs)
+	{
+		return lhs->queueTime < rhs->queueTime;
+	});
+
+	std::size_t first = 0;
+	while (first < queue.size())
+	{
+		std::size_t waiting = queue.size() - first;
+		std::size_t groupSize;
+
+		if (waiting >= mPlayersPerMatch)
+			groupSize = mPlayersPerMatch;
+		else if (now() >= queue[first]->queueTime + MaxQueueWait)
+			groupSize = waiting;
+		else
+			break;
+
+		MatchServer* match = findServer(groupSize);
+		if (!match)
+			match = startServer();
+
+		// Every server is full, keep everyone queued until a slot frees up
+		if (!match)
+			break;
+
+		// An empty server has nobody simulating obstacles and pickups yet, the first player of the group takes that role
+		bool needsAuthority = match->server->getConnectedPlayers() == 0 && match->reservations.empty();
+
+		for (std::size_t i = 0; i < groupSize; ++i)
+		{
+			QueuedClient& client = *queue[first + i];
+			bool authority = needsAuthority && i == 0;
+
+			client.handoff.clear();
+			client.handoff << static_cast<sf::Int32>(Lobby::MatchFound);
+			client.handoff << mAdvertisedAddress << match->server->getPort() << authority;
+			client.handoffPending = true;
+			client.queued = false;
+
+			match->reservations.push_back(now());
+		}
+
+		match->lastUsedTime = now();
+		std::cout << "Lobby: " << groupSize << " player(s) to match server on port " << match->server->getPort() << std::endl;
+
+		first += groupSize;
+	}
+}
+
+void LobbyServer::sendHandoffs()
+{
+	FOREACH(ClientPtr& client, mClients)
+	{
+		if (client->handoffPending)
+		{
+			client->socket.send(client->handoff);
+			client->handoffPending = false;
+		}
+	}
+}
+
+void LobbyServer::sendQueueStatus()
+{
+	std::vector<QueuedClient*> queue;
+	FOREACH(ClientPtr& client, mClients)
+	{
+		if (client->queued)
+			queue.push_back(client.get());
+	}
+
+	std::stable_sort(queue.begin(), queue.end(), [] (QueuedClient* lhs, QueuedClient* rhs)
+	{
+		return lhs->queueTime < rhs->queueTime;
+	});
+
+	for (std::size_t i = 0; i < queue.size(); ++i)
+	{
+		sf::Packet packet;
+		packet << static_cast<sf::Int32>(Lobby::QueueStatus);
+		packet << static_cast<sf::Int32>(i + 1) << static_cast<sf::Int32>(queue.size()) << static_cast<sf::Int32>(mServers.size());
+		queue[i]->socket.send(packet);
+	}
+}
+
+void LobbyServer::shutDownIdleServers()
+{
+	for (auto itr = mServers.begin(); itr != mServers.end(); )
+	{
+		MatchServer& match = **itr;
+		if (getLoad(match) == 0 && now() >= match.lastUsedTime + IdleServerTimeout)
+		{
+			std::cout << "Lobby: shutting down idle match server on port " << match.server->getPort() << std::endl;
+			itr = mServers.erase(itr);
+		}
+		else
+		{
+			if (match.server->getConnectedPlayers() > 0)
+				match.lastUsedTime = now();
+			++itr;
+		}
+	}
+}
+
+// Best fit: the fullest server that still has room for the whole group, so servers are packed densely
+LobbyServer::MatchServer* LobbyServer::findServer(std::size_t groupSize)
+{
+	MatchServer* best = nullptr;
+	std::size_t bestLoad = 0;
+
+	FOREACH(ServerPtr& match, mServers)
+	{
+		std::size_t load = getLoad(*match);
+		if (load + groupSize > match->server->getMaxPlayers())
+			continue;
+
+		if (!best || load > bestLoad)
+		{
+			best = match.get();
+			bestLoad = load;
+		}
+	}
+
+	return best;
+}
+
+LobbyServer::MatchServer* LobbyServer::startServer()
+{
+	if (mServers.size() >= mMaxServers)
+		return nullptr;
+
+	ServerPtr match(new MatchServer());
+	match->server.reset(new GameServer(BattlefieldSize, "", nextFreePort()));
+	match->lastUsedTime = now();
+
+	std::cout << "Lobby: started match server on port " << match->server->getPort() << std::endl;
+
+	mServers.push_back(std::move(match));
+	return mServers.back().get();
+}
+
+std::size_t LobbyServer::getLoad(MatchServer& match) const
+{
+	while (!match.reservations.empty() && now() >= match.reservations.front() + ReservationTimeout)
+		match.reservations.pop_front();
+
+	// Reserved players may already be connected and counted twice, which only errs on the side of not overfilling
+	return match.server->getConnectedPlayers() + match.reservations.size();
+}
+
+unsigned short LobbyServer::nextFreePort() const
+{
+	for (unsigned short port = MatchServerBasePort; ; port += 2)
+	{
+		bool used = false;
+		FOREACH(const ServerPtr& match, mServers)
+			used = used || match->server->getPort() == port;
+
+		if (!used)
+			return port;
+	}
+}
+
+sf::Time LobbyServer::now() const
+{
+	return mClock.getElapsedTime();
+}
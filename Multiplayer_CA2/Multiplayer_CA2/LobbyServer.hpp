@@ -0,0 +1,81 @@
+#ifndef BOOK_LOBBYSERVER_HPP
+#define BOOK_LOBBYSERVER_HPP
+
+#include "GameServer.hpp"
+
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/Time.hpp>
+#include <SFML/Network/TcpListener.hpp>
+#include <SFML/Network/TcpSocket.hpp>
+#include <SFML/Network/Packet.hpp>
+
+#include <deque>
+#include <vector>
+#include <memory>
+#include <string>
+
+
+// Matchmaking lobby: queues clients, groups them into matches and hands each group the endpoint of a
+// GameServer with room for it. Match servers run inside the lobby process and are started on demand.
+class LobbyServer
+{
+	public:
+												LobbyServer(std::size_t playersPerMatch, std::size_t maxServers, const std::string& advertisedAddress);
+
+		// Blocks forever, the lobby is a standalone process
+		void									run();
+
+
+	private:
+		struct QueuedClient
+		{
+										QueuedClient();
+
+			sf::TcpSocket				socket;
+			bool						queued;
+			sf::Time					queueTime;
+
+			sf::Packet					handoff;		// MatchFound, the client passes its authority bit on in Client::Hello
+			bool						handoffPending;
+		};
+
+		struct MatchServer
+		{
+			std::unique_ptr<GameServer>	server;
+			std::deque<sf::Time>		reservations;	// Handed off players that may not have connected yet
+			sf::Time					lastUsedTime;
+		};
+
+		typedef std::unique_ptr<QueuedClient> ClientPtr;
+		typedef std::unique_ptr<MatchServer> ServerPtr;
+
+
+	private:
+		void									handleIncomingClients();
+		void									handleClientPackets();
+		void									formMatches();
+		void									sendHandoffs();
+		void									sendQueueStatus();
+		void									shutDownIdleServers();
+
+		MatchServer*							findServer(std::size_t groupSize);
+		MatchServer*							startServer();
+		std::size_t								getLoad(MatchServer& server) const;
+		unsigned short							nextFreePort() const;
+		sf::Time								now() const;
+
+
+	private:
+		sf::TcpListener							mListenerSocket;
+		std::vector<ClientPtr>					mClients;
+		std::vector<ServerPtr>					mServers;
+
+		std::size_t								mPlayersPerMatch;
+		std::size_t								mMaxServers;
+		std::string								mAdvertisedAddress;
+
+		sf::Clock								mClock;
+		sf::Time								mLastStatusTime;
+};
+
+#endif // BOOK_LOBBYSERVER_HPP
@@ -0,0 +1,177 @@
+//D00137655 - Jason Lynch
+//D00194504 - Dylan
+#include "LobbyState.hpp"
+#include "NetworkProtocol.hpp"
+#include "Utility.hpp"
+#include "ResourceHolder.hpp"
+
+#include <SFML/Graphics/RenderWindow.hpp>
+#include <SFML/Network/Packet.hpp>
+
+#include <cstdlib>
+#include <sstream>
+
+extern std::string JoinIpAddress;
+
+
+LobbyState::LobbyState(StateStack& stack, Context context)
+: State(stack, context)
+, mConnector(mSocket)
+, mConnected(false)
+, mElapsedTime(sf::Time::Zero)
+{
+	mBackgroundSprite.setTexture(context.textures->get(Textures::TitleScreen));
+
+	mStatusText.setFont(context.fonts->get(Fonts::Main));
+	mStatusText.setCharacterSize(35);
+	mStatusText.setFillColor(sf::Color::White);
+
+	// The join screen's address names the lobby here; leave it empty to use a lobby running on this machine
+	std::string address = JoinIpAddress.empty() ? "127.0.0.1" : JoinIpAddress;
+	unsigned short port = LobbyPort;
+
+	std::string::size_type colon = address.find(':');
+	if (colon != std::string::npos)
+	{
+		port = static_cast<unsigned short>(std::atoi(address.substr(colon + 1).c_str()));
+		address = address.substr(0, colon);
+	}
+
+	mLobbyAddress = sf::IpAddress(address);
+
+	mConnector.start(mLobbyAddress, port, sf::seconds(5.f));
+	setStatus("Connecting to the lobby...");
+}
+
+void LobbyState::draw()
+{
+	sf::RenderWindow& window = *getContext().window;
+	window.setView(window.getDefaultView());
+
+	window.draw(mBackgroundSprite);
+	window.draw(mStatusText);
+}
+
+bool LobbyState::update(sf::Time dt)
+{
+	mElapsedTime += dt;
+
+	if (mConnector.getStatus() == AsyncConnector::Connecting)
+	{
+		switch (mConnector.update())
+		{
+			case AsyncConnector::Connected:
+			{
+				sf::Packet packet;
+				packet << static_cast<sf::Int32>(Lobby::JoinQueue);
+				mSocket.send(packet);
+
+				mConnected = true;
+				setStatus("Searching for a match...");
+			} break;
+
+			case AsyncConnector::Failed:
+			{
+				mElapsedTime = sf::Time::Zero;
+				setStatus("Could not reach the lobby!");
+			} break;
+
+			default:
+				return true;
+		}
+	}
+
+	if (!mConnected)
+	{
+		// Same grace period as a failed connection in game before returning to the menu
+		if (mElapsedTime >= sf::seconds(5.f))
+		{
+			requestStackPop();
+			requestStackPush(States::Menu);
+		}
+		return true;
+	}
+
+	sf::Packet packet;
+	sf::Socket::Status status;
+	while ((status = mSocket.receive(packet)) == sf::Socket::Done)
+	{
+		handlePacket(packet);
+		packet.clear();
+
+		if (!mConnected)
+			return true;
+	}
+
+	if (status == sf::Socket::Disconnected)
+	{
+		mConnected = false;
+		mElapsedTime = sf::Time::Zero;
+		setStatus("Lost connection to the lobby");
+	}
+
+	return true;
+}
+
+bool LobbyState::handleEvent(const sf::Event& event)
+{
+	if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Escape)
+	{
+		mConnector.cancel();
+		mSocket.disconnect();
+		requestStackPop();
+		requestStackPush(States::Menu);
+	}
+
+	return true;
+}
+
+void LobbyState::handlePacket(sf::Packet& packet)
+{
+	sf::Int32 packetType;
+	packet >> packetType;
+
+	switch (packetType)
+	{
+		case Lobby::QueueStatus:
+		{
+			sf::Int32 position, queued, servers;
+			packet >> position >> queued >> servers;
+
+			std::ostringstream status;
+			status << "Searching for a match... " << position << " of " << queued << " in queue";
+			setStatus(status.str());
+		} break;
+
+		case Lobby::MatchFound:
+		{
+			std::string address;
+			sf::Uint16 port;
+			bool authority;
+			packet >> address >> port >> authority;
+
+			// An empty address means the match server runs next to the lobby
+			if (address.empty())
+				address = mLobbyAddress.toString();
+
+			std::ostringstream endpoint;
+			endpoint << address << ":" << port;
+			JoinIpAddress = endpoint.str();
+
+			mSocket.disconnect();
+			mConnected = false;
+
+			requestStackPop();
+			requestStackPush(authority ? States::MatchAuthorityGame : States::JoinGame);
+		} break;
+	}
+}
+
+void LobbyState::setStatus(const std::string& status)
+{
+	sf::RenderWindow& window = *getContext().window;
+
+	mStatusText.setString(status);
+	centerOrigin(mStatusText);
+	mStatusText.setPosition(window.getSize().x / 2.f, window.getSize().y / 2.f);
+}
@@ -0,0 +1,39 @@
+#ifndef BOOK_LOBBYSTATE_HPP
+#define BOOK_LOBBYSTATE_HPP
+
+#include "State.hpp"
+#include "AsyncConnector.hpp"
+
+#include <SFML/Graphics/Sprite.hpp>
+#include <SFML/Graphics/Text.hpp>
+#include <SFML/Network/TcpSocket.hpp>
+#include <SFML/Network/IpAddress.hpp>
+
+
+// Waits in the matchmaking lobby queue, then hands off to the match server it assigns; Escape leaves the queue
+class LobbyState : public State
+{
+	public:
+							LobbyState(StateStack& stack, Context context);
+
+		virtual void		draw();
+		virtual bool		update(sf::Time dt);
+		virtual bool		handleEvent(const sf::Event& event);
+
+
+	private:
+		void				handlePacket(sf::Packet& packet);
+		void				setStatus(const std::string& status);
+
+
+	private:
+		sf::Sprite			mBackgroundSprite;
+		sf::Text			mStatusText;
+		sf::TcpSocket		mSocket;
+		AsyncConnector		mConnector;
+		sf::IpAddress		mLobbyAddress;
+		bool				mConnected;
+		sf::Time			mElapsedTime;
+};
+
+#endif // BOOK_LOBBYSTATE_HPP
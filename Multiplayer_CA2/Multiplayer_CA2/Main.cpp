@@ -1,14 +1,52 @@
 //D00137655 - Jason Lynch
 //D00194504 - Dylan
 #include "Application.hpp"
+#include "SpectatorRelay.hpp"
+#include "NetworkSimulator.hpp"
+#include "LobbyServer.hpp"
+
 #include <stdexcept>
 #include <iostream>
+#include <string>
+#include <cstdlib>
 
 
-int main()
+int main(int argc, char* argv[])
 {
 	try
 	{
+		// Relay mode: Multiplayer_CA2 --relay <server ip> [delay in seconds]
+		if (argc >= 3 && std::string(argv[1]) == "--relay")
+		{
+			float delay = (argc >= 4) ? static_cast<float>(std::atof(argv[3])) : 2.f;
+
+			SpectatorRelay relay(sf::IpAddress(argv[2]), sf::seconds(delay));
+			relay.run();
+			return 0;
+		}
+
+		// Network simulator mode: Multiplayer_CA2 --netsim <server ip> [config file]
+		if (argc >= 3 && std::string(argv[1]) == "--netsim")
+		{
+			std::string config = (argc >= 4) ? argv[3] : "netsim.txt";
+
+			NetworkSimulator simulator(sf::IpAddress(argv[2]), config);
+			simulator.run();
+			return 0;
+		}
+
+		// Lobby mode: Multiplayer_CA2 --lobby [players per match] [max match servers] [advertised address]
+		if (argc >= 2 && std::string(argv[1]) == "--lobby")
+		{
+			std::size_t playersPerMatch = (argc >= 3) ? static_cast<std::size_t>(std::atoi(argv[2])) : 4;
+			std::size_t maxServers = (argc >= 4) ? static_cast<std::size_t>(std::atoi(argv[3])) : 8;
+			std::string advertisedAddress = (argc >= 5) ? argv[4] : "";
+
+			LobbyServer lobby(playersPerMatch, maxServers, advertisedAddress);
+			lobby.run();
+			return 0;
+		}
+
 		Application app;
 		app.run();
 	}
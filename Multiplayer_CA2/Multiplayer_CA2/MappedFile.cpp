@@ -0,0 +1,140 @@
+//D00137655 - Jason Lynch
+//D00194504 - Dylan
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+
+MappedFile::MappedFile()
+: mData(nullptr)
+, mSize(0)
+#ifdef _WIN32
+, mFileHandle(INVALID_HANDLE_VALUE)
+, mMappingHandle(nullptr)
+#else
+, mFileDescriptor(-1)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& filename)
+{
+	close();
+
+	mFileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (mFileHandle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(mFileHandle, &fileSize) || fileSize.QuadPart == 0)
+	{
+		close();
+		return false;
+	}
+
+	mMappingHandle = CreateFileMappingA(mFileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mMappingHandle)
+	{
+		close();
+		return false;
+	}
+
+	mData = static_cast<const unsigned char*>(MapViewOfFile(mMappingHandle, FILE_MAP_READ, 0, 0, 0));
+	if (!mData)
+	{
+		close();
+		return false;
+	}
+
+	mSize = static_cast<std::size_t>(fileSize.QuadPart);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (mData)
+		UnmapViewOfFile(mData);
+	if (mMappingHandle)
+		CloseHandle(mMappingHandle);
+	if (mFileHandle != INVALID_HANDLE_VALUE)
+		CloseHandle(mFileHandle);
+
+	mData = nullptr;
+	mSize = 0;
+	mMappingHandle = nullptr;
+	mFileHandle = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+bool MappedFile::open(const std::string& filename)
+{
+	close();
+
+	mFileDescriptor = ::open(filename.c_str(), O_RDONLY);
+	if (mFileDescriptor < 0)
+		return false;
+
+	struct stat fileInfo;
+	if (fstat(mFileDescriptor, &fileInfo) != 0 || fileInfo.st_size == 0)
+	{
+		close();
+		return false;
+	}
+
+	void* mapping = mmap(nullptr, static_cast<std::size_t>(fileInfo.st_size), PROT_READ, MAP_PRIVATE, mFileDescriptor, 0);
+	if (mapping == MAP_FAILED)
+	{
+		close();
+		return false;
+	}
+
+	mData = static_cast<const unsigned char*>(mapping);
+	mSize = static_cast<std::size_t>(fileInfo.st_size);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (mData)
+		munmap(const_cast<unsigned char*>(mData), mSize);
+	if (mFileDescriptor >= 0)
+		::close(mFileDescriptor);
+
+	mData = nullptr;
+	mSize = 0;
+	mFileDescriptor = -1;
+}
+
+#endif
+
+bool MappedFile::isOpen() const
+{
+	return mData != nullptr;
+}
+
+const unsigned char* MappedFile::data() const
+{
+	return mData;
+}
+
+std::size_t MappedFile::size() const
+{
+	return mSize;
+}
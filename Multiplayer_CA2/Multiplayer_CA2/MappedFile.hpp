@@ -0,0 +1,37 @@
+#ifndef BOOK_MAPPEDFILE_HPP
+#define BOOK_MAPPEDFILE_HPP
+
+#include <SFML/System/NonCopyable.hpp>
+
+#include <string>
+#include <cstddef>
+
+
+// Read-only memory mapping of a whole file, so large recordings can be seeked without loading them
+class MappedFile : private sf::NonCopyable
+{
+	public:
+											MappedFile();
+											~MappedFile();
+
+		bool								open(const std::string& filename);
+		void								close();
+
+		bool								isOpen() const;
+		const unsigned char*				data() const;
+		std::size_t							size() const;
+
+
+	private:
+		const unsigned char*				mData;
+		std::size_t							mSize;
+
+#ifdef _WIN32
+		void*								mFileHandle;
+		void*								mMappingHandle;
+#else
+		int									mFileDescriptor;
+#endif
+};
+
+#endif // BOOK_MAPPEDFILE_HPP
@@ -0,0 +1,313 @@
+//D00137655 - Jason Lynch
+//D00194504 - Dylan
+#include "MatchCheckpoint.hpp"
+#include "Foreach.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+
+
+namespace
+{
+	const sf::Uint32 Version = 2;
+
+	// Byte by byte like the match recording, so checkpoints are portable regardless of host endianness
+	void writeBits(std::vector<char>& out, sf::Uint64 bits, std::size_t count)
+	{
+		for (std::size_t i = 0; i < count; ++i)
+			out.push_back(static_cast<char>((bits >> (8 * i)) & 0xFF));
+	}
+
+	void writeUint8(std::vector<char>& out, sf::Uint8 value)		{ writeBits(out, value, 1); }
+	void writeUint32(std::vector<char>& out, sf::Uint32 value)		{ writeBits(out, value, 4); }
+	void writeInt32(std::vector<char>& out, sf::Int32 value)		{ writeBits(out, static_cast<sf::Uint32>(value), 4); }
+	void writeUint64(std::vector<char>& out, sf::Uint64 value)		{ writeBits(out, value, 8); }
+
+	void writeFloat(std::vector<char>& out, float value)
+	{
+		sf::Uint32 bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		writeBits(out, bits, 4);
+	}
+
+	// Bounds checked reads, a truncated file just fails to load
+	struct Reader
+	{
+		const std::vector<char>&	data;
+		std::size_t					offset;
+		bool						valid;
+
+		sf::Uint64 readBits(std::size_t count)
+		{
+			if (!valid || offset + count > data.size())
+			{
+				valid = false;
+				return 0;
+			}
+
+			sf::Uint64 bits = 0;
+			for (std::size_t i = 0; i < count; ++i)
+				bits |= static_cast<sf::Uint64>(static_cast<unsigned char>(data[offset + i])) << (8 * i);
+
+			offset += count;
+			return bits;
+		}
+
+		sf::Uint8	readUint8()		{ return static_cast<sf::Uint8>(readBits(1)); }
+		sf::Uint32	readUint32()	{ return static_cast<sf::Uint32>(readBits(4)); }
+		sf::Int32	readInt32()		{ return static_cast<sf::Int32>(static_cast<sf::Uint32>(readBits(4))); }
+		sf::Uint64	readUint64()	{ return readBits(8); }
+
+		float readFloat()
+		{
+			sf::Uint32 bits = readUint32();
+			float value;
+			std::memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+
+		// Counts come from the file, never trust them to size an allocation beyond what is left of it
+		bool checkCount(sf::Uint32 count, std::size_t minimumEntrySize)
+		{
+			valid = valid && count <= (data.size() - offset) / minimumEntrySize;
+			return valid;
+		}
+	};
+}
+
+MatchCheckpoint::State::State()
+: wallClockSeconds(0)
+, serverTick(0)
+, matchSeed(0)
+, battlefieldTop(0.f)
+, nextTankIdentifier(1)
+, nextSpawnPoint(0)
+, objectStateVersion(0)
+, tanks()
+, sessions()
+, objects()
+{
+}
+
+MatchCheckpoint::MatchCheckpoint(const std::string& filename)
+: mFilename(filename)
+, mThread(&MatchCheckpoint::writerThread, this)
+, mMutex()
+, mWake()
+, mFront(0)
+, mBackPending(false)
+, mStopping(false)
+, mDiscarded(false)
+{
+	mThread.launch();
+}
+
+MatchCheckpoint::~MatchCheckpoint()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStopping = true;
+	}
+
+	mWake.notify_one();
+	mThread.wait();
+}
+
+bool MatchCheckpoint::submit(const State& state)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (mBackPending)
+			return false;
+	}
+
+	// Serializing happens outside the lock, the writer never touches the front buffer
+	std::vector<char>& front = mBuffers[mFront];
+	front.clear();
+	serialize(state, front);
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mFront = 1 - mFront;
+		mBackPending = true;
+	}
+
+	mWake.notify_one();
+	return true;
+}
+
+void MatchCheckpoint::discard()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mDiscarded = true;
+	std::remove(mFilename.c_str());
+}
+
+void MatchCheckpoint::writerThread()
+{
+	for (;;)
+	{
+		std::size_t backIndex;
+		{
+			// A checkpoint submitted before shutdown is still written
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWake.wait(lock, [this] () { return mBackPending || mStopping; });
+			if (!mBackPending)
+				return;
+
+			backIndex = 1 - mFront;
+		}
+
+		// The tick thread leaves the back buffer alone until mBackPending is cleared
+		const std::vector<char>& back = mBuffers[backIndex];
+
+		// Written aside and swapped in, so a crash mid-write still leaves the previous checkpoint intact
+		std::string temporary = mFilename + ".part";
+		bool written;
+		{
+			std::ofstream file(temporary.c_str(), std::ios::binary | std::ios::trunc);
+			file.write(back.data(), back.size());
+			written = static_cast<bool>(file);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (written && !mDiscarded)
+			{
+				std::remove(mFilename.c_str());
+				std::rename(temporary.c_str(), mFilename.c_str());
+			}
+			else
+			{
+				std::remove(temporary.c_str());
+			}
+
+			mBackPending = false;
+		}
+	}
+}
+
+void MatchCheckpoint::serialize(const State& state, std::vector<char>& out)
+{
+	out.insert(out.end(), "TKCP", "TKCP" + 4);
+	writeUint32(out, Version);
+	writeUint64(out, static_cast<sf::Uint64>(std::time(nullptr)));
+
+	writeUint32(out, state.serverTick);
+	writeUint64(out, state.matchSeed);
+	writeFloat(out, state.battlefieldTop);
+	writeInt32(out, state.nextTankIdentifier);
+	writeUint32(out, state.nextSpawnPoint);
+	writeUint32(out, state.objectStateVersion);
+
+	writeUint32(out, static_cast<sf::Uint32>(state.tanks.size()));
+	FOREACH(const Tank& tank, state.tanks)
+	{
+		writeInt32(out, tank.identifier);
+		writeFloat(out, tank.position.x);
+		writeFloat(out, tank.position.y);
+		writeFloat(out, tank.rotation);
+		writeInt32(out, tank.hitpoints);
+	}
+
+	writeUint32(out, static_cast<sf::Uint32>(state.sessions.size()));
+	FOREACH(const Session& session, state.sessions)
+	{
+		writeUint64(out, session.token);
+		writeUint8(out, session.authority ? 1 : 0);
+		writeUint32(out, static_cast<sf::Uint32>(session.tanks.size()));
+		FOREACH(sf::Int32 identifier, session.tanks)
+			writeInt32(out, identifier);
+	}
+
+	writeUint32(out, static_cast<sf::Uint32>(state.objects.size()));
+	FOREACH(const Object& object, state.objects)
+	{
+		writeInt32(out, object.identifier);
+		writeInt32(out, object.hitpoints);
+		writeUint8(out, object.destroyed ? 1 : 0);
+		writeFloat(out, object.position.x);
+		writeFloat(out, object.position.y);
+		writeUint8(out, object.setFields);
+	}
+}
+
+bool MatchCheckpoint::load(const std::string& filename, sf::Time maxAge, State& state)
+{
+	std::ifstream file(filename.c_str(), std::ios::binary);
+	if (!file)
+		return false;
+
+	std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if (data.size() < 4 || std::memcmp(&data[0], "TKCP", 4) != 0)
+		return false;
+
+	Reader reader = { data, 4, true };
+	if (reader.readUint32() != Version)
+		return false;
+
+	// Clients give up on a dropped session after a while, an older checkpoint has nobody left to resume it
+	state.wallClockSeconds = reader.readUint64();
+	sf::Uint64 nowSeconds = static_cast<sf::Uint64>(std::time(nullptr));
+	if (nowSeconds < state.wallClockSeconds || sf::seconds(static_cast<float>(nowSeconds - state.wallClockSeconds)) > maxAge)
+		return false;
+
+	state.serverTick = reader.readUint32();
+	state.matchSeed = reader.readUint64();
+	state.battlefieldTop = reader.readFloat();
+	state.nextTankIdentifier = reader.readInt32();
+	state.nextSpawnPoint = reader.readUint32();
+	state.objectStateVersion = reader.readUint32();
+
+	sf::Uint32 tankCount = reader.readUint32();
+	if (!reader.checkCount(tankCount, 20))
+		return false;
+
+	state.tanks.resize(tankCount);
+	FOREACH(Tank& tank, state.tanks)
+	{
+		tank.identifier = reader.readInt32();
+		tank.position.x = reader.readFloat();
+		tank.position.y = reader.readFloat();
+		tank.rotation = reader.readFloat();
+		tank.hitpoints = reader.readInt32();
+	}
+
+	sf::Uint32 sessionCount = reader.readUint32();
+	if (!reader.checkCount(sessionCount, 13))
+		return false;
+
+	state.sessions.resize(sessionCount);
+	FOREACH(Session& session, state.sessions)
+	{
+		session.token = reader.readUint64();
+		session.authority = reader.readUint8() != 0;
+		sf::Uint32 count = reader.readUint32();
+		if (!reader.checkCount(count, 4))
+			return false;
+
+		session.tanks.resize(count);
+		FOREACH(sf::Int32& identifier, session.tanks)
+			identifier = reader.readInt32();
+	}
+
+	sf::Uint32 objectCount = reader.readUint32();
+	if (!reader.checkCount(objectCount, 18))
+		return false;
+
+	state.objects.resize(objectCount);
+	FOREACH(Object& object, state.objects)
+	{
+		object.identifier = reader.readInt32();
+		object.hitpoints = reader.readInt32();
+		object.destroyed = reader.readUint8() != 0;
+		object.position.x = reader.readFloat();
+		object.position.y = reader.readFloat();
+		object.setFields = reader.readUint8();
+	}
+
+	return reader.valid;
+}
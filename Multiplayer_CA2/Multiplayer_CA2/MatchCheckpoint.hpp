@@ -0,0 +1,100 @@
+#ifndef BOOK_MATCHCHECKPOINT_HPP
+#define BOOK_MATCHCHECKPOINT_HPP
+
+#include <SFML/Config.hpp>
+#include <SFML/System/NonCopyable.hpp>
+#include <SFML/System/Thread.hpp>
+#include <SFML/System/Time.hpp>
+#include <SFML/System/Vector2.hpp>
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+// Periodic snapshot of everything a restarted GameServer needs to carry on a match. All values are little endian.
+//
+// header:		[char[4]:"TKCP"] [Uint32:version] [Uint64:wallClockSeconds]
+// match:		[Uint32:serverTick] [Uint64:matchSeed] [float:battlefieldTop] [Int32:nextTankIdentifier] [Uint32:nextSpawnPoint] [Uint32:objectStateVersion]
+// tanks:		[Uint32:count] ([Int32:id] [float:x] [float:y] [float:rotation] [Int32:hitpoints])...
+// sessions:	[Uint32:count] ([Uint64:token] [Uint8:authority] [Uint32:tankCount] [Int32:id]...)...
+// objects:		[Uint32:count] ([Int32:id] [Int32:hitpoints] [Uint8:destroyed] [float:x] [float:y] [Uint8:setFields])...
+//
+// The tick thread serializes into one buffer while a writer thread puts the other one on disk, so a slow
+// disk never holds up a tick; a checkpoint that comes due while the previous one is still being written is skipped.
+class MatchCheckpoint : private sf::NonCopyable
+{
+	public:
+		struct Tank
+		{
+			sf::Int32					identifier;
+			sf::Vector2f				position;
+			float						rotation;
+			sf::Int32					hitpoints;
+		};
+
+		struct Session
+		{
+			sf::Uint64					token;
+			bool						authority;
+			std::vector<sf::Int32>		tanks;
+		};
+
+		struct Object
+		{
+			sf::Int32					identifier;
+			sf::Int32					hitpoints;
+			bool						destroyed;
+			sf::Vector2f				position;
+			sf::Uint8					setFields;		// ReplicationComponent fields the server has a value for
+		};
+
+		struct State
+		{
+										State();
+
+			sf::Uint64					wallClockSeconds;
+			sf::Uint32					serverTick;
+			sf::Uint64					matchSeed;
+			float						battlefieldTop;
+			sf::Int32					nextTankIdentifier;
+			sf::Uint32					nextSpawnPoint;
+			sf::Uint32					objectStateVersion;
+			std::vector<Tank>			tanks;
+			std::vector<Session>		sessions;
+			std::vector<Object>			objects;
+		};
+
+
+	public:
+		explicit						MatchCheckpoint(const std::string& filename);
+										~MatchCheckpoint();
+
+		// False if the previous checkpoint is still being written
+		bool							submit(const State& state);
+		void							discard();
+
+		// False when there is no checkpoint, it doesn't parse, or it is older than maxAge
+		static bool						load(const std::string& filename, sf::Time maxAge, State& state);
+
+
+	private:
+		void							writerThread();
+		static void						serialize(const State& state, std::vector<char>& out);
+
+
+	private:
+		std::string						mFilename;
+		sf::Thread						mThread;
+		std::mutex						mMutex;
+		std::condition_variable			mWake;			// Signalled when a buffer is submitted and on shutdown
+
+		std::vector<char>				mBuffers[2];
+		std::size_t						mFront;			// Owned by the tick thread, the other one by the writer
+		bool							mBackPending;
+		bool							mStopping;
+		bool							mDiscarded;		// Match ended cleanly, nothing to resume
+};
+
+#endif // BOOK_MATCHCHECKPOINT_HPP
@@ -0,0 +1,289 @@
+//D00137655 - Jason Lynch
+//D00194504 - Dylan
+#include "MatchPlayback.hpp"
+#include "Foreach.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+
+namespace
+{
+	const std::size_t HeaderSize = 12;
+	const std::size_t FooterSize = 8;
+}
+
+// Bounds-checked little endian cursor over the mapped file
+struct MatchPlayback::Reader
+{
+	Reader(const unsigned char* data, std::size_t size, std::size_t offset)
+	: data(data)
+	, size(size)
+	, offset(offset)
+	, valid(offset <= size)
+	{
+	}
+
+	sf::Uint32 readBits(std::size_t count)
+	{
+		if (!valid || offset + count > size)
+		{
+			valid = false;
+			return 0;
+		}
+
+		sf::Uint32 bits = 0;
+		for (std::size_t i = 0; i < count; ++i)
+			bits |= static_cast<sf::Uint32>(data[offset + i]) << (8 * i);
+
+		offset += count;
+		return bits;
+	}
+
+	sf::Uint8 readUint8()		{ return static_cast<sf::Uint8>(readBits(1)); }
+	sf::Uint16 readUint16()		{ return static_cast<sf::Uint16>(readBits(2)); }
+	sf::Int16 readInt16()		{ return static_cast<sf::Int16>(readBits(2)); }
+	sf::Uint32 readUint32()		{ return readBits(4); }
+
+	float readFloat()
+	{
+		sf::Uint32 bits = readBits(4);
+		float value;
+		std::memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	const unsigned char*	data;
+	std::size_t				size;
+	std::size_t				offset;
+	bool					valid;
+};
+
+MatchPlayback::MatchPlayback()
+: mFile()
+, mIndex()
+, mFramesEnd(0)
+, mWorldHeight(768.f)
+, mDurationMs(0)
+, mKeyframe(0)
+, mCursor(0)
+, mCursorTimeMs(0)
+, mBattleFieldPosition(768.f)
+, mTanks()
+{
+}
+
+bool MatchPlayback::open(const std::string& filename)
+{
+	mIndex.clear();
+	mTanks.clear();
+
+	if (!mFile.open(filename) || mFile.size() < HeaderSize || std::memcmp(mFile.data(), "TKRC", 4) != 0)
+	{
+		mFile.close();
+		return false;
+	}
+
+	Reader header(mFile.data(), mFile.size(), 4);
+	if (header.readUint32() != MatchRecording::Version)
+	{
+		mFile.close();
+		return false;
+	}
+	mWorldHeight = header.readFloat();
+
+	// A recording cut short (crash, killed process) has no index yet; recover it by walking the frames once
+	if (!readIndex() && !rebuildIndex())
+	{
+		mFile.close();
+		return false;
+	}
+
+	// Duration is the time of the last frame, found by walking forward from the last keyframe
+	Reader reader(mFile.data(), mFramesEnd, mIndex.back().offset);
+	while (reader.offset < mFramesEnd)
+	{
+		Reader peek = reader;
+		peek.readUint8();
+		sf::Uint32 timeMs = peek.readUint32();
+		if (!applyFrame(reader))
+			break;
+
+		mDurationMs = timeMs;
+	}
+
+	seekToKeyframe(0);
+	return true;
+}
+
+bool MatchPlayback::isOpen() const
+{
+	return mFile.isOpen();
+}
+
+sf::Time MatchPlayback::getDuration() const
+{
+	return sf::milliseconds(static_cast<sf::Int32>(mDurationMs));
+}
+
+float MatchPlayback::getWorldHeight() const
+{
+	return mWorldHeight;
+}
+
+bool MatchPlayback::sample(sf::Time time, MatchRecording::Snapshot& snapshot, float& battlefieldPosition)
+{
+	if (!isOpen())
+		return false;
+
+	sf::Uint32 timeMs = static_cast<sf::Uint32>(std::max(0, time.asMilliseconds()));
+
+	// Last keyframe at or before the requested time
+	auto next = std::upper_bound(mIndex.begin(), mIndex.end(), timeMs, [] (sf::Uint32 value, const IndexEntry& entry)
+	{
+		return value < entry.timeMs;
+	});
+	std::size_t keyframe = (next == mIndex.begin()) ? 0 : static_cast<std::size_t>(next - mIndex.begin()) - 1;
+
+	if (keyframe != mKeyframe || timeMs < mCursorTimeMs)
+		seekToKeyframe(keyframe);
+
+	Reader reader(mFile.data(), mFramesEnd, mCursor);
+	while (reader.offset < mFramesEnd)
+	{
+		Reader peek = reader;
+		peek.readUint8();
+		sf::Uint32 frameTime = peek.readUint32();
+		if (!peek.valid || frameTime > timeMs)
+			break;
+
+		if (!applyFrame(reader))
+			break;
+
+		mCursor = reader.offset;
+		mCursorTimeMs = frameTime;
+	}
+
+	snapshot.clear();
+	FOREACH(auto& pair, mTanks)
+		snapshot.push_back(pair.second);
+
+	battlefieldPosition = mBattleFieldPosition;
+	return true;
+}
+
+bool MatchPlayback::readIndex()
+{
+	if (mFile.size() < HeaderSize + FooterSize || std::memcmp(mFile.data() + mFile.size() - 4, "TKIX", 4) != 0)
+		return false;
+
+	Reader footer(mFile.data(), mFile.size(), mFile.size() - FooterSize);
+	sf::Uint32 indexOffset = footer.readUint32();
+	if (indexOffset < HeaderSize || indexOffset > mFile.size() - FooterSize)
+		return false;
+
+	Reader reader(mFile.data(), mFile.size() - FooterSize, indexOffset);
+	sf::Uint32 count = reader.readUint32();
+	for (sf::Uint32 i = 0; i < count && reader.valid; ++i)
+	{
+		IndexEntry entry;
+		entry.timeMs = reader.readUint32();
+		entry.offset = reader.readUint32();
+		if (entry.offset < HeaderSize || entry.offset >= indexOffset)
+			reader.valid = false;
+		else
+			mIndex.push_back(entry);
+	}
+
+	if (!reader.valid || mIndex.empty())
+	{
+		mIndex.clear();
+		return false;
+	}
+
+	mFramesEnd = indexOffset;
+	return true;
+}
+
+bool MatchPlayback::rebuildIndex()
+{
+	mFramesEnd = mFile.size();
+
+	Reader reader(mFile.data(), mFramesEnd, HeaderSize);
+	while (reader.offset < mFramesEnd)
+	{
+		std::size_t offset = reader.offset;
+		Reader peek = reader;
+		sf::Uint8 type = peek.readUint8();
+		sf::Uint32 timeMs = peek.readUint32();
+
+		if (!applyFrame(reader))
+		{
+			// Drop the partially written tail
+			mFramesEnd = offset;
+			break;
+		}
+
+		if (type == MatchRecording::Keyframe)
+		{
+			IndexEntry entry;
+			entry.timeMs = timeMs;
+			entry.offset = static_cast<sf::Uint32>(offset);
+			mIndex.push_back(entry);
+		}
+	}
+
+	return !mIndex.empty();
+}
+
+bool MatchPlayback::applyFrame(Reader& reader)
+{
+	sf::Uint8 type = reader.readUint8();
+	reader.readUint32();
+	float battlefieldPosition = reader.readFloat();
+	sf::Uint16 count = reader.readUint16();
+
+	if (!reader.valid || (type != MatchRecording::Keyframe && type != MatchRecording::Delta))
+		return false;
+
+	if (type == MatchRecording::Keyframe)
+		mTanks.clear();
+
+	for (sf::Uint16 i = 0; i < count && reader.valid; ++i)
+	{
+		sf::Uint16 identifier = reader.readUint16();
+		sf::Uint8 fields = (type == MatchRecording::Keyframe)
+			? static_cast<sf::Uint8>(MatchRecording::Position | MatchRecording::Rotation | MatchRecording::Hitpoints)
+			: reader.readUint8();
+
+		if (fields & MatchRecording::Removed)
+		{
+			mTanks.erase(identifier);
+			continue;
+		}
+
+		MatchRecording::TankSnapshot& tank = mTanks[identifier];
+		tank.identifier = identifier;
+
+		if (fields & MatchRecording::Position)
+		{
+			tank.position.x = reader.readInt16() / MatchRecording::PositionScale;
+			tank.position.y = reader.readInt16() / MatchRecording::PositionScale;
+		}
+		if (fields & MatchRecording::Rotation)
+			tank.rotation = reader.readUint16() / MatchRecording::RotationScale;
+		if (fields & MatchRecording::Hitpoints)
+			tank.hitpoints = reader.readInt16();
+	}
+
+	mBattleFieldPosition = battlefieldPosition;
+	return reader.valid;
+}
+
+void MatchPlayback::seekToKeyframe(std::size_t keyframe)
+{
+	mKeyframe = keyframe;
+	mCursor = mIndex[keyframe].offset;
+	mCursorTimeMs = mIndex[keyframe].timeMs;
+	mTanks.clear();
+}
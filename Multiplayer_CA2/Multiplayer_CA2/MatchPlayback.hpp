@@ -0,0 +1,63 @@
+#ifndef BOOK_MATCHPLAYBACK_HPP
+#define BOOK_MATCHPLAYBACK_HPP
+
+#include "MatchRecording.hpp"
+#include "MappedFile.hpp"
+
+#include <SFML/System/NonCopyable.hpp>
+#include <SFML/System/Time.hpp>
+
+#include <string>
+#include <vector>
+#include <map>
+
+
+// Memory-maps a MatchRecorder file and reconstructs the world snapshot at any point in time
+class MatchPlayback : private sf::NonCopyable
+{
+	public:
+											MatchPlayback();
+
+		bool								open(const std::string& filename);
+		bool								isOpen() const;
+
+		sf::Time							getDuration() const;
+		float								getWorldHeight() const;
+
+		// Binary searches the keyframe index, then applies the deltas up to the requested time.
+		// Playing forward continues from the last sampled frame instead of seeking again.
+		bool								sample(sf::Time time, MatchRecording::Snapshot& snapshot, float& battlefieldPosition);
+
+
+	private:
+		struct IndexEntry
+		{
+			sf::Uint32						timeMs;
+			sf::Uint32						offset;
+		};
+
+		struct Reader;
+
+
+	private:
+		bool								readIndex();
+		bool								rebuildIndex();
+		bool								applyFrame(Reader& reader);
+		void								seekToKeyframe(std::size_t keyframe);
+
+
+	private:
+		MappedFile							mFile;
+		std::vector<IndexEntry>				mIndex;
+		std::size_t							mFramesEnd;
+		float								mWorldHeight;
+		sf::Uint32							mDurationMs;
+
+		std::size_t							mKeyframe;
+		std::size_t							mCursor;
+		sf::Uint32							mCursorTimeMs;
+		float								mBattleFieldPosition;
+		std::map<sf::Uint16, MatchRecording::TankSnapshot>	mTanks;
+};
+
+#endif // BOOK_MATCHPLAYBACK_HPP
@@ -0,0 +1,218 @@
+//D00137655 - Jason Lynch
+//D00194504 - Dylan
+#include "MatchRecorder.hpp"
+#include "Foreach.hpp"
+
+#include <algorithm>
+#include <type_traits>
+#include <cmath>
+#include <cstring>
+
+
+namespace
+{
+	sf::Int16 quantizePosition(float value)
+	{
+		float scaled = std::floor(value * MatchRecording::PositionScale + 0.5f);
+		scaled = std::max(-32768.f, std::min(32767.f, scaled));
+		return static_cast<sf::Int16>(scaled);
+	}
+
+	sf::Uint16 quantizeRotation(float degrees)
+	{
+		float wrapped = std::fmod(degrees, 360.f);
+		if (wrapped < 0.f)
+			wrapped += 360.f;
+
+		return static_cast<sf::Uint16>(static_cast<sf::Uint32>(wrapped * MatchRecording::RotationScale + 0.5f) & 0xFFFF);
+	}
+
+	// Serialize byte by byte so recordings are portable regardless of host endianness
+	void writeBytes(std::ofstream& file, sf::Uint32 bits, std::size_t count)
+	{
+		char bytes[4];
+		for (std::size_t i = 0; i < count; ++i)
+			bytes[i] = static_cast<char>((bits >> (8 * i)) & 0xFF);
+
+		file.write(bytes, count);
+	}
+}
+
+template <typename T>
+void MatchRecorder::write(T value)
+{
+	typedef typename std::make_unsigned<T>::type Unsigned;
+	writeBytes(mFile, static_cast<sf::Uint32>(static_cast<Unsigned>(value)), sizeof(T));
+}
+
+template <>
+void MatchRecorder::write<float>(float value)
+{
+	sf::Uint32 bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	writeBytes(mFile, bits, sizeof(bits));
+}
+
+MatchRecorder::MatchRecorder(const std::string& filename, float worldHeight)
+: mFile(filename.c_str(), std::ios::binary | std::ios::trunc)
+, mIndex()
+, mPreviousTanks()
+, mLastKeyframeTime(0)
+, mHasKeyframe(false)
+{
+	if (!mFile)
+		return;
+
+	mFile.write("TKRC", 4);
+	write<sf::Uint32>(MatchRecording::Version);
+	write<float>(worldHeight);
+}
+
+MatchRecorder::~MatchRecorder()
+{
+	close();
+}
+
+bool MatchRecorder::isOpen() const
+{
+	return mFile.is_open() && mFile.good();
+}
+
+void MatchRecorder::record(sf::Time time, float battlefieldPosition, const MatchRecording::Snapshot& snapshot)
+{
+	if (!isOpen())
+		return;
+
+	std::map<sf::Uint16, QuantizedTank> tanks;
+	FOREACH(const MatchRecording::TankSnapshot& tank, snapshot)
+	{
+		QuantizedTank& quantized = tanks[static_cast<sf::Uint16>(tank.identifier)];
+		quantized.x = quantizePosition(tank.position.x);
+		quantized.y = quantizePosition(tank.position.y);
+		quantized.rotation = quantizeRotation(tank.rotation);
+		quantized.hitpoints = static_cast<sf::Int16>(std::max(-32768, std::min(32767, static_cast<int>(tank.hitpoints))));
+	}
+
+	sf::Uint32 timeMs = static_cast<sf::Uint32>(time.asMilliseconds());
+
+	if (!mHasKeyframe || timeMs >= mLastKeyframeTime + MatchRecording::KeyframeIntervalMs)
+		writeKeyframe(timeMs, battlefieldPosition, tanks);
+	else
+		writeDelta(timeMs, battlefieldPosition, tanks);
+
+	mPreviousTanks.swap(tanks);
+}
+
+void MatchRecorder::close()
+{
+	if (!isOpen())
+		return;
+
+	// Seek index: the keyframe table sits at the end so recording never has to rewrite earlier data
+	sf::Uint32 indexOffset = static_cast<sf::Uint32>(mFile.tellp());
+	write<sf::Uint32>(static_cast<sf::Uint32>(mIndex.size()));
+	FOREACH(const IndexEntry& entry, mIndex)
+	{
+		write<sf::Uint32>(entry.timeMs);
+		write<sf::Uint32>(entry.offset);
+	}
+
+	write<sf::Uint32>(indexOffset);
+	mFile.write("TKIX", 4);
+	mFile.close();
+}
+
+void MatchRecorder::writeKeyframe(sf::Uint32 timeMs, float battlefieldPosition, const std::map<sf::Uint16, QuantizedTank>& tanks)
+{
+	IndexEntry entry;
+	entry.timeMs = timeMs;
+	entry.offset = static_cast<sf::Uint32>(mFile.tellp());
+	mIndex.push_back(entry);
+
+	write<sf::Uint8>(MatchRecording::Keyframe);
+	write<sf::Uint32>(timeMs);
+	write<float>(battlefieldPosition);
+	write<sf::Uint16>(static_cast<sf::Uint16>(tanks.size()));
+
+	FOREACH(auto& pair, tanks)
+	{
+		write<sf::Uint16>(pair.first);
+		write<sf::Int16>(pair.second.x);
+		write<sf::Int16>(pair.second.y);
+		write<sf::Uint16>(pair.second.rotation);
+		write<sf::Int16>(pair.second.hitpoints);
+	}
+
+	mLastKeyframeTime = timeMs;
+	mHasKeyframe = true;
+}
+
+void MatchRecorder::writeDelta(sf::Uint32 timeMs, float battlefieldPosition, const std::map<sf::Uint16, QuantizedTank>& tanks)
+{
+	struct Change
+	{
+		sf::Uint16		identifier;
+		sf::Uint8		fields;
+		QuantizedTank	tank;
+	};
+
+	std::vector<Change> changes;
+
+	FOREACH(auto& pair, tanks)
+	{
+		Change change;
+		change.identifier = pair.first;
+		change.tank = pair.second;
+		change.fields = 0;
+
+		auto previous = mPreviousTanks.find(pair.first);
+		if (previous == mPreviousTanks.end())
+		{
+			change.fields = MatchRecording::Position | MatchRecording::Rotation | MatchRecording::Hitpoints;
+		}
+		else
+		{
+			if (previous->second.x != pair.second.x || previous->second.y != pair.second.y)
+				change.fields |= MatchRecording::Position;
+			if (previous->second.rotation != pair.second.rotation)
+				change.fields |= MatchRecording::Rotation;
+			if (previous->second.hitpoints != pair.second.hitpoints)
+				change.fields |= MatchRecording::Hitpoints;
+		}
+
+		if (change.fields != 0)
+			changes.push_back(change);
+	}
+
+	FOREACH(auto& pair, mPreviousTanks)
+	{
+		if (tanks.find(pair.first) == tanks.end())
+		{
+			Change change;
+			change.identifier = pair.first;
+			change.fields = MatchRecording::Removed;
+			changes.push_back(change);
+		}
+	}
+
+	write<sf::Uint8>(MatchRecording::Delta);
+	write<sf::Uint32>(timeMs);
+	write<float>(battlefieldPosition);
+	write<sf::Uint16>(static_cast<sf::Uint16>(changes.size()));
+
+	FOREACH(const Change& change, changes)
+	{
+		write<sf::Uint16>(change.identifier);
+		write<sf::Uint8>(change.fields);
+
+		if (change.fields & MatchRecording::Position)
+		{
+			write<sf::Int16>(change.tank.x);
+			write<sf::Int16>(change.tank.y);
+		}
+		if (change.fields & MatchRecording::Rotation)
+			write<sf::Uint16>(change.tank.rotation);
+		if (change.fields & MatchRecording::Hitpoints)
+			write<sf::Int16>(change.tank.hitpoints);
+	}
+}
@@ -0,0 +1,59 @@
+#ifndef BOOK_MATCHRECORDER_HPP
+#define BOOK_MATCHRECORDER_HPP
+
+#include "MatchRecording.hpp"
+
+#include <SFML/System/NonCopyable.hpp>
+#include <SFML/System/Time.hpp>
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+
+
+// Writes server snapshots as periodic keyframes plus deltas, with a seek index appended on close
+class MatchRecorder : private sf::NonCopyable
+{
+	public:
+		explicit							MatchRecorder(const std::string& filename, float worldHeight);
+											~MatchRecorder();
+
+		bool								isOpen() const;
+		void								record(sf::Time time, float battlefieldPosition, const MatchRecording::Snapshot& snapshot);
+		void								close();
+
+
+	private:
+		struct QuantizedTank
+		{
+			sf::Int16						x;
+			sf::Int16						y;
+			sf::Uint16						rotation;
+			sf::Int16						hitpoints;
+		};
+
+		struct IndexEntry
+		{
+			sf::Uint32						timeMs;
+			sf::Uint32						offset;
+		};
+
+
+	private:
+		void								writeKeyframe(sf::Uint32 timeMs, float battlefieldPosition, const std::map<sf::Uint16, QuantizedTank>& tanks);
+		void								writeDelta(sf::Uint32 timeMs, float battlefieldPosition, const std::map<sf::Uint16, QuantizedTank>& tanks);
+
+		template <typename T>
+		void								write(T value);
+
+
+	private:
+		std::ofstream						mFile;
+		std::vector<IndexEntry>				mIndex;
+		std::map<sf::Uint16, QuantizedTank>	mPreviousTanks;
+		sf::Uint32							mLastKeyframeTime;
+		bool								mHasKeyframe;
+};
+
+#endif // BOOK_MATCHRECORDER_HPP
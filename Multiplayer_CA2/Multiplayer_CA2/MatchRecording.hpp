@@ -0,0 +1,57 @@
+#ifndef BOOK_MATCHRECORDING_HPP
+#define BOOK_MATCHRECORDING_HPP
+
+#include <SFML/Config.hpp>
+#include <SFML/System/Vector2.hpp>
+
+#include <vector>
+
+
+// On-disk layout shared by MatchRecorder and MatchPlayback. All values are little endian.
+//
+// header:		[char[4]:"TKRC"] [Uint32:version] [float:worldHeight]
+// frame:		[Uint8:frameType] [Uint32:timeMs] [float:battlefieldPosition] [Uint16:entryCount] entries...
+//   keyframe entry:	[Uint16:id] [Int16:x] [Int16:y] [Uint16:rotation] [Int16:hitpoints]
+//   delta entry:		[Uint16:id] [Uint8:changedFields] changed fields in keyframe order
+// index:		[Uint32:keyframeCount] ([Uint32:timeMs] [Uint32:fileOffset])...
+// footer:		[Uint32:indexOffset] [char[4]:"TKIX"]
+//
+// Positions are stored in 1/8 pixel steps and rotations in 1/65536 turns, which keeps a 20 minute match at a few MB.
+namespace MatchRecording
+{
+	const sf::Uint32		Version = 1;
+	const float				PositionScale = 8.f;
+	const float				RotationScale = 65536.f / 360.f;
+
+	// Hosts record every match here, the replay menu plays it back
+	const char* const		Filename = "match.rec";
+
+	// A keyframe is forced at this interval so seeking never replays more than a handful of deltas
+	const sf::Uint32		KeyframeIntervalMs = 5000;
+
+	enum FrameType
+	{
+		Keyframe,
+		Delta
+	};
+
+	enum ChangedField
+	{
+		Position	= 1 << 0,
+		Rotation	= 1 << 1,
+		Hitpoints	= 1 << 2,
+		Removed		= 1 << 3
+	};
+
+	struct TankSnapshot
+	{
+		sf::Int32			identifier;
+		sf::Vector2f		position;
+		float				rotation;
+		sf::Int32			hitpoints;
+	};
+
+	typedef std::vector<TankSnapshot> Snapshot;
+}
+
+#endif // BOOK_MATCHRECORDING_HPP
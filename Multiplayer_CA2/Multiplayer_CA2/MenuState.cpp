@@ -55,9 +55,18 @@ MenuState::MenuState(StateStack& stack, Context context)
 			requestStackPush(States::JoinIpEntry);
 		});
 
+	auto replayButton = std::make_shared<GUI::Button>(context);
+	replayButton->setPosition(100, 450);
+	replayButton->setText("Replay");
+	replayButton->setCallback([this]()
+		{
+			requestStackPop();
+			requestStackPush(States::Playback);
+		});
+
 	//Pushes new state - Jason Lynch
 	auto howToPlayButton = std::make_shared<GUI::Button>(context);
-	howToPlayButton->setPosition(100, 450);
+	howToPlayButton->setPosition(100, 500);
 	howToPlayButton->setText("How To Play");
 	howToPlayButton->setCallback([this]()
 		{
@@ -66,7 +75,7 @@ MenuState::MenuState(StateStack& stack, Context context)
 
 	//Pushes new state - Jason Lynch
 	auto settingsButton = std::make_shared<GUI::Button>(context);
-	settingsButton->setPosition(100, 500);
+	settingsButton->setPosition(100, 550);
 	settingsButton->setText("Settings");
 	settingsButton->setCallback([this]()
 		{
@@ -74,7 +83,7 @@ MenuState::MenuState(StateStack& stack, Context context)
 		});
 
 	auto exitButton = std::make_shared<GUI::Button>(context);
-	exitButton->setPosition(100, 550);
+	exitButton->setPosition(100, 600);
 	exitButton->setText("Exit");
 	exitButton->setCallback([this]()
 		{
@@ -84,6 +93,7 @@ MenuState::MenuState(StateStack& stack, Context context)
 	mGUIContainer.pack(playButton);
 	mGUIContainer.pack(hostPlayButton);
 	mGUIContainer.pack(joinPlayButton);
+	mGUIContainer.pack(replayButton);
 	mGUIContainer.pack(howToPlayButton);
 	mGUIContainer.pack(settingsButton);
 	mGUIContainer.pack(exitButton);
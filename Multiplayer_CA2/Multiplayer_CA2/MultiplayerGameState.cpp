@@ -9,10 +9,23 @@
 #include <SFML/Network/IpAddress.hpp>
 
 #include <fstream>
+#include <cstdlib>
+#include <set>
+#include <sstream>
 
 extern std::string HostIpAddress;
 extern std::string JoinIpAddress;
 
+namespace
+{
+	// A little less than the server keeps our tanks, so a late resume doesn't land on an expired session
+	const sf::Time ReconnectGracePeriod = sf::seconds(15.f);
+	const sf::Time ReconnectAttemptInterval = sf::seconds(0.5f);
+
+	// Matches the server's history, older probes can't be answered by either side
+	const std::size_t StateHashHistory = 64;
+}
+
 sf::IpAddress getAddressFromFile()
 {
 	{ // Try to open existing file (RAII block)
@@ -29,20 +42,45 @@ sf::IpAddress getAddressFromFile()
 	return localAddress;
 }
 
-MultiplayerGameState::MultiplayerGameState(StateStack& stack, Context context, bool isHost, const std::string* ipAddress)
+MultiplayerGameState::MultiplayerGameState(StateStack& stack, Context context, bool isHost, const std::string* ipAddress, bool isSpectator, bool isAuthority)
 	: State(stack, context)
-	, mWorld(*context.window, *context.fonts, *context.sounds, true)
+	, mWorld(*context.window, *context.fonts, *context.sounds, *context.jobs, true)
 	, mWindow(*context.window)
 	, mTextureHolder(*context.textures)
+	, mConnector(mSocket)
 	, mConnected(false)
+	, mHandshakeDone(false)
+	, mServerPort(ServerPort)
+	, mSessionToken(0)
+	, mReconnecting(false)
 	, mGameServer(nullptr)
+	, mAssetCache("cache")
+	, mPendingAssets()
+	, mAssetBytesTotal(0)
+	, mAssetBytesReceived(0)
+	, mDiagnostics(context.fonts->get(Fonts::Main))
+	, mInterpolationBacklog(0.f)
+	, mPredictionError(0.f)
+	, mRemoteTankCount(0)
+	, mLocalTankCount(0)
 	, mActiveState(true)
 	, mHasFocus(true)
 	, mHost(isHost)
+	, mAuthority(isHost || isAuthority)
+	, mSpectator(isSpectator)
 	, mGameStarted(false)
 	, mClientTimeout(sf::seconds(2.f))
 	, mTimeSinceLastPacket(sf::seconds(0.f))
+	, mReplicatedStates()
+	, mStateHashHistory()
+	, mLastHashTick(0)
+	, mLastHash(0)
 {
+	// The host's world decides what happens to obstacles and pickups
+	mWorld.setReplicationAuthority(mAuthority);
+	// Every client simulates the same commands to the same bits, which keeps state hashes comparable
+	mWorld.setDeterministic(true);
+
 	mBroadcastText.setFont(context.fonts->get(Fonts::Main));
 	mBroadcastText.setPosition(1024.f / 2, 100.f);
 
@@ -52,41 +90,43 @@ MultiplayerGameState::MultiplayerGameState(StateStack& stack, Context context, b
 	mPlayerInvitationText.setString("");//Press Enter to spawn player 2
 	mPlayerInvitationText.setPosition(1000 - mPlayerInvitationText.getLocalBounds().width, 760 - mPlayerInvitationText.getLocalBounds().height);
 
-	// We reuse this text for "Attempt to connect" and "Failed to connect" messages
+	// We reuse this text for the connection progress and "Failed to connect" messages
 	mFailedConnectionText.setFont(context.fonts->get(Fonts::Main));
-	mFailedConnectionText.setString("Attempting to connect...");
 	mFailedConnectionText.setCharacterSize(35);
 	mFailedConnectionText.setFillColor(sf::Color::White);
-	centerOrigin(mFailedConnectionText);
 	mFailedConnectionText.setPosition(mWindow.getSize().x / 2.f, mWindow.getSize().y / 2.f);
+	setConnectionText("Attempting to connect...");
 
-	// Render a "establishing connection" frame for user feedback
-	mWindow.clear(sf::Color::Black);
-	mWindow.draw(mFailedConnectionText);
-	mWindow.display();
-	mFailedConnectionText.setString("Could not connect to the remote server!");
-	centerOrigin(mFailedConnectionText);
-
-	sf::IpAddress ip;
+	std::string address;
 	if (isHost)
 	{
-		mGameServer.reset(new GameServer(sf::Vector2f(mWindow.getSize())));
-		ip = HostIpAddress;
+		mGameServer.reset(new GameServer(sf::Vector2f(mWindow.getSize()), MatchRecording::Filename));
+		address = HostIpAddress;
 		//ip = "127.0.0.1";
 		
 	}
 	else
 	{
 		/*ip = getAddressFromFile();*/
-		ip = JoinIpAddress;
+		address = JoinIpAddress;
 	}
 
-	if (mSocket.connect(ip, ServerPort, sf::seconds(5.f)) == sf::TcpSocket::Done)
-		mConnected = true;
-	else
-		mFailedConnectionClock.restart();
+	// Spectators watch through a relay, which serves the match stream on its own port
+	unsigned short port = mSpectator ? SpectatorPort : ServerPort;
+
+	// "ip:port" overrides the port, e.g. to go through the network simulator on NetSimPort
+	std::string::size_type colon = address.find(':');
+	if (colon != std::string::npos)
+	{
+		port = static_cast<unsigned short>(std::atoi(address.substr(colon + 1).c_str()));
+		address = address.substr(0, colon);
+	}
+
+	mServerAddress = sf::IpAddress(address);
+	mServerPort = port;
 
-	mSocket.setBlocking(false);
+	// Polled every frame from update(), the Hello goes out once the socket is connected
+	mConnector.start(mServerAddress, mServerPort, sf::seconds(5.f));
 
 	// Play game theme
 	//context.music->play(Music::MissionTheme);
@@ -107,6 +147,12 @@ void MultiplayerGameState::draw()
 
 		if (mLocalPlayerIdentifiers.size() < 2 && mPlayerInvitationTime < sf::seconds(0.5f))
 			mWindow.draw(mPlayerInvitationText);
+
+		mWindow.draw(mDiagnostics);
+
+		// Connected but not in the match yet: waiting on the server's answer, then on our tank and the world
+		if (!mGameStarted && !mSpectator)
+			mWindow.draw(mFailedConnectionText);
 	}
 	else
 	{
@@ -126,7 +172,7 @@ void MultiplayerGameState::onDestroy()
 		// Inform server this client is dying
 		sf::Packet packet;
 		packet << static_cast<sf::Int32>(Client::Quit);
-		mSocket.send(packet);
+		sendToServer(packet);
 	}
 }
 
@@ -136,6 +182,15 @@ bool MultiplayerGameState::update(sf::Time dt)
 	if (mConnected)
 	{
 		mWorld.update(dt);
+		mDiagnostics.update(dt, mServerClock.getRoundTripTime());
+
+		if (!mGameStarted && !mSpectator)
+		{
+			if (!mPendingAssets.empty())
+				setConnectionText("Downloading arena... " + toString(mAssetBytesReceived * 100 / std::max<sf::Uint64>(mAssetBytesTotal, 1)) + "%");
+			else
+				setConnectionText(mHandshakeDone ? "Receiving world..." : "Joining match...");
+		}
 		
 		// Remove players whose Tanks were destroyed
 		bool foundLocalPlane = false;
@@ -179,14 +234,25 @@ bool MultiplayerGameState::update(sf::Time dt)
 		FOREACH(auto & pair, mPlayers)
 			pair.second->handleRealtimeNetworkInput(commands);
 
-		// Handle messages from server that may have arrived
+		// Handle all messages from server that may have arrived, one per frame falls behind a 20 Hz stream with extra packets
 		sf::Packet packet;
-		if (mSocket.receive(packet) == sf::Socket::Done)
+		bool receivedPacket = false;
+		while (mSocket.receive(packet) == sf::Socket::Done)
 		{
-			mTimeSinceLastPacket = sf::seconds(0.f);
+			receivedPacket = true;
 			sf::Int32 packetType;
-			packet >> packetType;
+			sf::Uint32 serverTick;
+			packet >> packetType >> serverTick;
+			mServerClock.observeTick(serverTick);
+			mHandshakeDone = true;
+			mDiagnostics.recordPacket(NetworkDiagnostics::Incoming, packetType, packet.getDataSize());
 			handlePacket(packetType, packet);
+			packet.clear();
+		}
+
+		if (receivedPacket)
+		{
+			mTimeSinceLastPacket = sf::seconds(0.f);
 		}
 		else
 		{
@@ -195,7 +261,18 @@ bool MultiplayerGameState::update(sf::Time dt)
 			{
 				mConnected = false;
 
-				mFailedConnectionText.setString("Lost connection to server");
+				// With a session the server keeps our tanks for a while, so try to get back into the same match
+				if (mSessionToken != 0 && !mHost)
+				{
+					mReconnecting = true;
+					mReconnectClock.restart();
+					mSocket.disconnect();
+					mFailedConnectionText.setString("Connection lost, reconnecting...");
+				}
+				else
+				{
+					mFailedConnectionText.setString("Lost connection to server");
+				}
 				centerOrigin(mFailedConnectionText);
 
 				mFailedConnectionClock.restart();
@@ -213,13 +290,30 @@ bool MultiplayerGameState::update(sf::Time dt)
 		GameActions::Action gameAction;
 		while (mWorld.pollGameAction(gameAction))
 		{
+			if (gameAction.type == GameActions::TankFired)
+			{
+				sf::Packet firePacket;
+				firePacket << static_cast<sf::Int32>(Client::FireEvent);
+				firePacket << gameAction.identifier << gameAction.tick << gameAction.seed;
+				sendToServer(firePacket);
+				continue;
+			}
+
 			sf::Packet packet;
 			packet << static_cast<sf::Int32>(Client::GameEvent);
 			packet << static_cast<sf::Int32>(gameAction.type);
 			packet << gameAction.position.x;
 			packet << gameAction.position.y;
 
-			mSocket.send(packet);
+			sendToServer(packet);
+		}
+
+		// Clock synchronization pings, fast at first and then a slow refresh
+		if (mServerClock.shouldSendPing())
+		{
+			sf::Packet clockPacket;
+			mServerClock.writePing(clockPacket);
+			sendToServer(clockPacket);
 		}
 
 		// Regular position updates
@@ -236,18 +330,50 @@ bool MultiplayerGameState::update(sf::Time dt)
 					positionUpdatePacket << identifier << tank->getPosition().x << tank->getPosition().y << static_cast<sf::Int32>(tank->getHitpoints()) << tank->getRotation();
 			}
 
-			mSocket.send(positionUpdatePacket);
+			// State hash as of the last snapshot we applied, the server compares it against its own for that tick
+			positionUpdatePacket << mLastHashTick << mLastHash;
+
+			sendToServer(positionUpdatePacket);
+
+			// Obstacle and pickup fields that changed on the host since the last tick
+			if (mAuthority)
+			{
+				mWorld.pollReplicatedStates(mReplicatedStates);
+				if (!mReplicatedStates.empty())
+				{
+					sf::Packet objectStatePacket;
+					objectStatePacket << static_cast<sf::Int32>(Client::ObjectStateUpdate);
+					objectStatePacket << static_cast<sf::Int32>(mReplicatedStates.size());
+					FOREACH(const ReplicatedState& state, mReplicatedStates)
+						objectStatePacket << state;
+
+					sendToServer(objectStatePacket);
+				}
+			}
+
 			mTickClock.restart();
 		}
 
 		mTimeSinceLastPacket += dt;
 	}
 
-	// Failed to connect and waited for more than 5 seconds: Back to menu
-	else if (mFailedConnectionClock.getElapsedTime() >= sf::seconds(5.f))
+	// Connection setup is polled here, so the window keeps rendering while we connect
+	else
 	{
-		requestStateClear();
-		requestStackPush(States::Menu);
+		if (mConnector.getStatus() == AsyncConnector::Connecting)
+			updateConnector();
+
+		if (mReconnecting)
+		{
+			attemptReconnect();
+		}
+
+		// Failed to connect and waited for more than 5 seconds: Back to menu
+		else if (!mConnected && mConnector.getStatus() != AsyncConnector::Connecting && mFailedConnectionClock.getElapsedTime() >= sf::seconds(5.f))
+		{
+			requestStateClear();
+			requestStackPush(States::Menu);
+		}
 	}
 
 	return true;
@@ -278,7 +404,25 @@ bool MultiplayerGameState::handleEvent(const sf::Event& event)
 			/*sf::Packet packet;
 			packet << static_cast<sf::Int32>(Client::RequestCoopPartner);
 
-			mSocket.send(packet);*/
+			sendToServer(packet);*/
+		}
+
+		// F3 toggles the network diagnostics overlay
+		else if (event.key.code == sf::Keyboard::F3)
+		{
+			mDiagnostics.toggle();
+		}
+
+		// Still connecting or failed to: Escape cancels, Enter retries a failed attempt
+		else if (!mConnected && event.key.code == sf::Keyboard::Escape)
+		{
+			mConnector.cancel();
+			requestStateClear();
+			requestStackPush(States::Menu);
+		}
+		else if (!mConnected && !mReconnecting && event.key.code == sf::Keyboard::Return && mConnector.getStatus() == AsyncConnector::Failed)
+		{
+			mConnector.retry();
 		}
 
 		// Escape pressed, trigger the pause screen
@@ -351,6 +495,7 @@ void MultiplayerGameState::handlePacket(sf::Int32 packetType, sf::Packet& packet
 
 		Tank* tank = mWorld.addTank(TankIdentifier);
 		tank->setPosition(TankPosition);
+		tank->setNetworkFired(false);
 
 		mPlayers[TankIdentifier].reset(new Player(&mSocket, TankIdentifier, getContext().keys1));
 		mLocalPlayerIdentifiers.push_back(TankIdentifier);
@@ -415,7 +560,8 @@ void MultiplayerGameState::handlePacket(sf::Int32 packetType, sf::Packet& packet
 		sf::Int32 TankIdentifier;
 		packet >> TankIdentifier;
 
-		mWorld.addTank(TankIdentifier);
+		Tank* tank = mWorld.addTank(TankIdentifier);
+		tank->setNetworkFired(false);
 		mPlayers[TankIdentifier].reset(new Player(&mSocket, TankIdentifier, getContext().keys2));
 		mLocalPlayerIdentifiers.push_back(TankIdentifier);
 	} break;
@@ -467,6 +613,7 @@ void MultiplayerGameState::handlePacket(sf::Int32 packetType, sf::Packet& packet
 		float currentWorldPosition;
 		sf::Int32 TankCount;
 		packet >> currentWorldPosition >> TankCount;
+		resetSnapshotDiagnostics();
 
 		float currentViewPosition = mWorld.getViewBounds().top + mWorld.getViewBounds().height;
 
@@ -477,15 +624,390 @@ void MultiplayerGameState::handlePacket(sf::Int32 packetType, sf::Packet& packet
 			float TankRotation;
 			packet >> TankIdentifier >> TankPosition.x >> TankPosition.y >> TankRotation;
 
-			Tank* Tank = mWorld.getTank(TankIdentifier);
-			bool isLocalPlane = std::find(mLocalPlayerIdentifiers.begin(), mLocalPlayerIdentifiers.end(), TankIdentifier) != mLocalPlayerIdentifiers.end();
-			if (Tank && !isLocalPlane)
+			updateRemoteTank(TankIdentifier, TankPosition, TankRotation);
+		}
+
+		recordStateHash();
+		recordSnapshotDiagnostics();
+	} break;
+
+	// Same as UpdateClientState, at reduced precision while our link is congested
+	case Server::UpdateClientStateCompact:
+	{
+		float currentWorldPosition;
+		sf::Int32 TankCount;
+		packet >> currentWorldPosition >> TankCount;
+		resetSnapshotDiagnostics();
+
+		for (sf::Int32 i = 0; i < TankCount; ++i)
+		{
+			sf::Int32 TankIdentifier;
+			sf::Int16 x, y;
+			sf::Uint8 rotation;
+			packet >> TankIdentifier >> x >> y >> rotation;
+
+			updateRemoteTank(TankIdentifier, sf::Vector2f(x, y), rotation * 360.f / 256.f);
+		}
+
+		recordStateHash();
+		recordSnapshotDiagnostics();
+	} break;
+
+	// Arena files the match uses; whatever is cached already is used straight away, the rest is requested
+	case Server::AssetManifest:
+	{
+		sf::Int32 count;
+		packet >> count;
+
+		std::vector<sf::Uint64> missing;
+		mPendingAssets.clear();
+		mAssetBytesTotal = 0;
+		mAssetBytesReceived = 0;
+
+		for (sf::Int32 i = 0; i < count; ++i)
+		{
+			std::string name;
+			sf::Uint64 hash;
+			sf::Uint32 size;
+			packet >> name >> hash >> size;
+
+			if (mAssetCache.contains(hash))
+			{
+				mWorld.loadArenaAsset(name, mAssetCache.getPath(hash));
+			}
+			else
+			{
+				mAssetCache.beginDownload(hash, size);
+				mPendingAssets[hash] = name;
+				mAssetBytesTotal += size;
+				missing.push_back(hash);
+			}
+		}
+
+		sf::Packet requestPacket;
+		requestPacket << static_cast<sf::Int32>(Client::AssetRequest) << static_cast<sf::Int32>(missing.size());
+		FOREACH(sf::Uint64 hash, missing)
+			requestPacket << hash;
+		sendToServer(requestPacket);
+	} break;
+
+	case Server::AssetChunk:
+	{
+		sf::Uint64 hash;
+		sf::Uint32 offset, size;
+		packet >> hash >> offset >> size;
+		if (!packet || size > packet.getDataSize())
+			break;
+
+		// The chunk bytes are the rest of the packet
+		const char* data = static_cast<const char*>(packet.getData()) + packet.getDataSize() - size;
+		mAssetBytesReceived += size;
+
+		auto pending = mPendingAssets.find(hash);
+		if (pending != mPendingAssets.end() && mAssetCache.receiveChunk(hash, offset, data, size))
+		{
+			mWorld.loadArenaAsset(pending->second, mAssetCache.getPath(hash));
+			mPendingAssets.erase(pending);
+		}
+	} break;
+
+	// The server saw our hash diverge; send the per entity hashes of that tick so it can tell which entity
+	case Server::DesyncProbe:
+	{
+		sf::Uint32 tick;
+		packet >> tick;
+
+		FOREACH(auto& recorded, mStateHashHistory)
+		{
+			if (recorded.first != tick)
+				continue;
+
+			sf::Packet detailPacket;
+			detailPacket << static_cast<sf::Int32>(Client::DesyncDetail) << tick << static_cast<sf::Int32>(recorded.second.size());
+			FOREACH(auto& entry, recorded.second)
+				detailPacket << entry.first << entry.second;
+
+			sendToServer(detailPacket);
+			break;
+		}
+	} break;
+
+	case Server::Ping:
+	{
+		sf::Uint32 sequence;
+		packet >> sequence;
+
+		sf::Packet pongPacket;
+		pongPacket << static_cast<sf::Int32>(Client::Pong) << sequence;
+		sendToServer(pongPacket);
+	} break;
+
+	case Server::ClockPong:
+	{
+		mServerClock.handlePong(packet);
+	} break;
+
+	case Server::SessionToken:
+	{
+		packet >> mSessionToken;
+	} break;
+
+	// Back in the match after a drop: apply only what changed while we were away
+	case Server::SessionResumed:
+	{
+		sf::Uint64 sessionToken;
+		bool full;
+		float currentScroll;
+		packet >> sessionToken >> full >> currentScroll;
+		mWorld.setCurrentBattleFieldPosition(currentScroll);
+
+		std::set<sf::Int32> present;
+		sf::Int32 count;
+		packet >> count;
+		for (sf::Int32 i = 0; i < count; ++i)
+		{
+			sf::Int32 TankIdentifier;
+			sf::Int32 hitpoints;
+			sf::Vector2f TankPosition;
+			float rotation;
+			packet >> TankIdentifier >> TankPosition.x >> TankPosition.y >> hitpoints >> rotation;
+
+			Tank* tank = mWorld.getTank(TankIdentifier);
+			if (!tank)
 			{
-				sf::Vector2f interpolatedPosition = Tank->getPosition() + (TankPosition - Tank->getPosition()) * 0.1f;
-				Tank->setPosition(interpolatedPosition);
-				Tank->setRotation(TankRotation);
+				tank = mWorld.addTank(TankIdentifier);
+				mPlayers[TankIdentifier].reset(new Player(&mSocket, TankIdentifier, nullptr));
 			}
+
+			tank->setPosition(TankPosition);
+			tank->setHitpoints(hitpoints);
+			tank->setRotation(rotation);
+			present.insert(TankIdentifier);
+		}
+
+		// A full roster replaces ours, anything missing from it is gone
+		if (full)
+		{
+			for (auto itr = mPlayers.begin(); itr != mPlayers.end(); )
+			{
+				if (present.find(itr->first) == present.end())
+				{
+					mWorld.removeTank(itr->first);
+					itr = mPlayers.erase(itr);
+				}
+				else
+				{
+					++itr;
+				}
+			}
+		}
+
+		packet >> count;
+		for (sf::Int32 i = 0; i < count; ++i)
+		{
+			sf::Int32 TankIdentifier;
+			packet >> TankIdentifier;
+
+			mWorld.removeTank(TankIdentifier);
+			mPlayers.erase(TankIdentifier);
+		}
+
+		packet >> count;
+		for (sf::Int32 i = 0; i < count; ++i)
+		{
+			sf::Int32 TankIdentifier;
+			sf::Int32 hitpoints;
+			packet >> TankIdentifier >> hitpoints;
+
+			if (Tank* tank = mWorld.getTank(TankIdentifier))
+				tank->setHitpoints(hitpoints);
+		}
+	} break;
+
+	case Server::MatchSeed:
+	{
+		sf::Uint64 seed;
+		packet >> seed;
+		mWorld.setRandomSeed(seed);
+	} break;
+
+	// Another client's tank fired: spawn the same shot locally
+	case Server::FireEvent:
+	{
+		sf::Int32 TankIdentifier;
+		sf::Uint32 tick;
+		sf::Uint32 seed;
+		packet >> TankIdentifier >> tick >> seed;
+
+		Tank* tank = mWorld.getTank(TankIdentifier);
+		if (tank && tank->isNetworkFired())
+			tank->fireFromNetwork(tick, seed);
+	} break;
+
+	case Server::UpdateObjectState:
+	{
+		sf::Uint32 version;
+		sf::Int32 count;
+		packet >> version >> count;
+
+		for (sf::Int32 i = 0; i < count; ++i)
+		{
+			ReplicatedState state;
+			packet >> state;
+			mWorld.applyReplicatedState(state);
 		}
+
+		sf::Packet ackPacket;
+		ackPacket << static_cast<sf::Int32>(Client::ObjectStateAck);
+		ackPacket << version;
+		sendToServer(ackPacket);
 	} break;
 	}
-}
\ No newline at end of file
+}
+
+void MultiplayerGameState::updateRemoteTank(sf::Int32 identifier, sf::Vector2f position, float rotation)
+{
+	Tank* tank = mWorld.getTank(identifier);
+	bool isLocalPlane = std::find(mLocalPlayerIdentifiers.begin(), mLocalPlayerIdentifiers.end(), identifier) != mLocalPlayerIdentifiers.end();
+	if (tank && isLocalPlane)
+	{
+		// Our own tanks are predicted locally, the snapshot holds the server's (older) copy
+		mPredictionError += length(position - tank->getPosition());
+		++mLocalTankCount;
+	}
+
+	if (tank && !isLocalPlane)
+	{
+		// Hashed at the snapshot value, the interpolated position only converges to it
+		mWorld.getStateHash().set(StateHash::TankTransform, identifier, StateHash::hashTransform(position, rotation));
+
+		sf::Vector2f interpolatedPosition = tank->getPosition() + (position - tank->getPosition()) * 0.1f;
+		tank->setPosition(interpolatedPosition);
+		tank->setRotation(rotation);
+
+		mInterpolationBacklog += length(position - interpolatedPosition);
+		++mRemoteTankCount;
+	}
+}
+
+void MultiplayerGameState::resetSnapshotDiagnostics()
+{
+	mInterpolationBacklog = 0.f;
+	mPredictionError = 0.f;
+	mRemoteTankCount = 0;
+	mLocalTankCount = 0;
+}
+
+void MultiplayerGameState::recordSnapshotDiagnostics()
+{
+	mDiagnostics.recordSnapshot();
+	mDiagnostics.recordInterpolation(mRemoteTankCount > 0 ? mInterpolationBacklog / mRemoteTankCount : 0.f,
+		mLocalTankCount > 0 ? mPredictionError / mLocalTankCount : 0.f);
+}
+
+void MultiplayerGameState::sendToServer(sf::Packet& packet)
+{
+	if (packet.getDataSize() >= sizeof(sf::Int32))
+	{
+		// The packet type is the first field, stored big endian
+		const sf::Uint8* data = static_cast<const sf::Uint8*>(packet.getData());
+		sf::Int32 packetType = static_cast<sf::Int32>((data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3]);
+		mDiagnostics.recordPacket(NetworkDiagnostics::Outgoing, packetType, packet.getDataSize());
+	}
+
+	mSocket.send(packet);
+}
+
+void MultiplayerGameState::recordStateHash()
+{
+	StateHash& stateHash = mWorld.getStateHash();
+	mWorld.refreshTankHashes();
+
+	mLastHashTick = mServerClock.getLastServerTick();
+	mLastHash = stateHash.getValue();
+
+	mStateHashHistory.push_back(std::make_pair(mLastHashTick, stateHash.getEntries()));
+	if (mStateHashHistory.size() > StateHashHistory)
+		mStateHashHistory.pop_front();
+}
+
+// First packet on every connection; a session token asks the server for our old tanks back
+void MultiplayerGameState::sendHello()
+{
+	sf::Packet packet;
+	packet << static_cast<sf::Int32>(Client::Hello) << mSessionToken << mServerClock.getLastServerTick() << mAuthority;
+	sendToServer(packet);
+}
+
+void MultiplayerGameState::attemptReconnect()
+{
+	if (mReconnectClock.getElapsedTime() >= ReconnectGracePeriod)
+	{
+		mReconnecting = false;
+		mConnector.cancel();
+
+		mFailedConnectionText.setString("Lost connection to server");
+		centerOrigin(mFailedConnectionText);
+
+		mFailedConnectionClock.restart();
+		return;
+	}
+
+	// One attempt at a time, the next one starts a little after the previous one gave up
+	if (mConnector.getStatus() == AsyncConnector::Connecting || mReconnectAttemptClock.getElapsedTime() < ReconnectAttemptInterval)
+		return;
+
+	mConnector.start(mServerAddress, mServerPort, sf::seconds(1.f));
+}
+
+void MultiplayerGameState::updateConnector()
+{
+	switch (mConnector.update())
+	{
+		case AsyncConnector::Connected:
+		{
+			mConnected = true;
+			mReconnecting = false;
+			mHandshakeDone = false;
+			mTimeSinceLastPacket = sf::Time::Zero;
+
+			// The server only hands out a slot after hearing whether we're new or resuming; the relay ignores it
+			if (!mSpectator)
+				sendHello();
+		} break;
+
+		case AsyncConnector::Failed:
+		{
+			mReconnectAttemptClock.restart();
+			if (!mReconnecting)
+			{
+				setConnectionText("Could not connect to the remote server!\nEnter to retry, Escape for the menu");
+				mFailedConnectionClock.restart();
+			}
+		} break;
+
+		case AsyncConnector::Connecting:
+		{
+			if (!mReconnecting)
+			{
+				std::ostringstream text;
+				text << "Connecting to " << mConnector.getAddress() << ":" << mConnector.getPort() << "... " << static_cast<int>(mConnector.getElapsedTime().asSeconds()) << "s";
+				if (mConnector.getAttemptCount() > 1)
+					text << " (attempt " << mConnector.getAttemptCount() << ")";
+				setConnectionText(text.str());
+			}
+		} break;
+
+		default:
+			break;
+	}
+}
+
+void MultiplayerGameState::setConnectionText(const std::string& text)
+{
+	if (mFailedConnectionText.getString() == text)
+		return;
+
+	mFailedConnectionText.setString(text);
+	centerOrigin(mFailedConnectionText);
+}
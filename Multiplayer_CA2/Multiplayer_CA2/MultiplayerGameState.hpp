@@ -6,17 +6,23 @@
 #include "Player.hpp"
 #include "GameServer.hpp"
 #include "NetworkProtocol.hpp"
+#include "ServerClock.hpp"
+#include "NetworkDiagnostics.hpp"
+#include "AsyncConnector.hpp"
+#include "AssetCache.hpp"
 
 #include <SFML/System/Clock.hpp>
 #include <SFML/Graphics/Text.hpp>
 #include <SFML/Network/TcpSocket.hpp>
+#include <SFML/Network/IpAddress.hpp>
 #include <SFML/Network/Packet.hpp>
 
+#include <deque>
 
 class MultiplayerGameState : public State
 {
 	public:
-									MultiplayerGameState(StateStack& stack, Context context, bool isHost, const std::string* ip);
+									MultiplayerGameState(StateStack& stack, Context context, bool isHost, const std::string* ip, bool isSpectator = false, bool isAuthority = false);
 
 		virtual void				draw();
 		virtual bool				update(sf::Time dt);
@@ -30,6 +36,15 @@ class MultiplayerGameState : public State
 	private:
 		void						updateBroadcastMessage(sf::Time elapsedTime);
 		void						handlePacket(sf::Int32 packetType, sf::Packet& packet);
+		void						updateRemoteTank(sf::Int32 identifier, sf::Vector2f position, float rotation);
+		void						sendHello();
+		void						attemptReconnect();
+		void						updateConnector();
+		void						setConnectionText(const std::string& text);
+		void						recordStateHash();
+		void						sendToServer(sf::Packet& packet);
+		void						resetSnapshotDiagnostics();
+		void						recordSnapshotDiagnostics();
 
 
 	private:
@@ -44,9 +59,29 @@ class MultiplayerGameState : public State
 		std::map<int, PlayerPtr>	mPlayers;
 		std::vector<sf::Int8>		mLocalPlayerIdentifiers;
 		sf::TcpSocket				mSocket;
+		AsyncConnector				mConnector;
 		bool						mConnected;
+		bool						mHandshakeDone;		// The server answered our Hello
+		sf::IpAddress				mServerAddress;
+		unsigned short				mServerPort;
+		sf::Uint64					mSessionToken;
+		bool						mReconnecting;
+		sf::Clock					mReconnectClock;
+		sf::Clock					mReconnectAttemptClock;
 		std::unique_ptr<GameServer> mGameServer;
 		sf::Clock					mTickClock;
+		ServerClock					mServerClock;
+
+		AssetCache					mAssetCache;
+		std::map<sf::Uint64, std::string>	mPendingAssets;		// Blobs being downloaded, by hash, with their asset name
+		sf::Uint64					mAssetBytesTotal;
+		sf::Uint64					mAssetBytesReceived;
+
+		NetworkDiagnostics			mDiagnostics;
+		float						mInterpolationBacklog;	// Summed over the tanks of the snapshot being applied
+		float						mPredictionError;
+		std::size_t					mRemoteTankCount;
+		std::size_t					mLocalTankCount;
 
 		std::vector<std::string>	mBroadcasts;
 		sf::Text					mBroadcastText;
@@ -61,9 +96,17 @@ class MultiplayerGameState : public State
 		bool						mActiveState;
 		bool						mHasFocus;
 		bool						mHost;
+		bool						mAuthority;		// Our world owns obstacles and pickups: the host, or the player a lobby picked
+		bool						mSpectator;
 		bool						mGameStarted;
 		sf::Time					mClientTimeout;
 		sf::Time					mTimeSinceLastPacket;
+		std::vector<ReplicatedState>	mReplicatedStates;
+
+		// Per entity hashes of recent snapshot ticks, so a desync probe can be answered after the fact
+		std::deque<std::pair<sf::Uint32, StateHash::Entries>>	mStateHashHistory;
+		sf::Uint32					mLastHashTick;
+		sf::Uint32					mLastHash;
 };
 
 #endif // BOOK_MULTIPLAYERGAMESTATE_HPP
@@ -0,0 +1,282 @@
+//D00137655 - Jason Lynch
+//D00194504 - Dylan
+#include "NetworkDiagnostics.hpp"
+#include "Utility.hpp"
+#include "Foreach.hpp"
+
+#include <SFML/Graphics/RenderTarget.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace
+{
+	const sf::Time		SampleInterval = sf::milliseconds(100);
+	const std::size_t	SampleCount = 100;		// 10 seconds of history
+	const std::size_t	LegendEntries = 3;
+
+	const unsigned int	CharacterSize = 10;
+	const float			Left = 5.f;
+	const float			Top = 20.f;
+	const float			BarWidth = 2.f;
+	const float			GraphWidth = BarWidth * SampleCount;
+
+	// Each panel is a title line followed by a graph three lines high
+	const std::size_t	PanelLines = 4;
+	const std::size_t	GraphLines = 3;
+
+	const char*			GraphNames[] = { "rtt", "jitter", "snapshot interval", "interp backlog", "prediction error" };
+	const char*			GraphUnits[] = { "ms", "ms", "ms", "px", "px" };
+	const float			GraphMinScale[] = { 100.f, 20.f, 100.f, 20.f, 20.f };
+	const sf::Color		GraphColors[] = { sf::Color(80, 200, 255), sf::Color(255, 200, 80), sf::Color(120, 255, 120), sf::Color(200, 120, 255), sf::Color(255, 100, 100) };
+
+	const char*			DirectionNames[] = { "in", "out" };
+	const float			TrafficMinScale = 1024.f;
+	const sf::Color		TrafficColors[] = { sf::Color(230, 25, 75), sf::Color(60, 180, 75), sf::Color(255, 225, 25), sf::Color(0, 130, 200),
+											sf::Color(245, 130, 48), sf::Color(145, 30, 180), sf::Color(70, 240, 240), sf::Color(240, 50, 230) };
+
+	const sf::Color		PanelColor(0, 0, 0, 150);
+
+	const char*			ServerPacketNames[] = { "BroadcastMessage", "SpawnSelf", "InitialState", "PlayerEvent", "PlayerRealtimeChange",
+											"PlayerConnect", "PlayerDisconnect", "AcceptCoopPartner", "SpawnEnemy", "SpawnPickup",
+											"UpdateClientState", "MissionSuccess", "UpdateObjectState", "MatchSeed", "FireEvent", "Ping",
+											"UpdateClientStateCompact", "ClockPong", "SessionToken", "SessionResumed", "DesyncProbe",
+											"AssetManifest", "AssetChunk" };
+	const char*			ClientPacketNames[] = { "PlayerEvent", "PlayerRealtimeChange", "RequestCoopPartner", "PositionUpdate", "GameEvent",
+											"Quit", "Heartbeat", "ObjectStateUpdate", "ObjectStateAck", "FireEvent", "Pong", "ClockPing",
+											"Hello", "DesyncDetail", "AssetRequest" };
+
+	const sf::Color& getTrafficColor(sf::Int32 packetType)
+	{
+		return TrafficColors[static_cast<std::size_t>(packetType) % (sizeof(TrafficColors) / sizeof(TrafficColors[0]))];
+	}
+}
+
+NetworkDiagnostics::NetworkDiagnostics(const sf::Font& font)
+: mVisible(false)
+, mSampleTime(sf::Time::Zero)
+, mSnapshotClock()
+, mHasSnapshot(false)
+, mLastInterArrival(0.f)
+, mWorstInterArrival(0.f)
+, mTitles("", font, CharacterSize)
+, mLegend("", font, CharacterSize)
+, mLineSpacing(font.getLineSpacing(CharacterSize))
+, mVertexArray(sf::Quads)
+, mNeedsVertexUpdate(true)
+{
+	std::fill(mLatest, mLatest + GraphCount, 0.f);
+
+	mTitles.setPosition(Left, Top);
+	mLegend.setPosition(Left + GraphWidth + 18.f, Top);
+}
+
+void NetworkDiagnostics::toggle()
+{
+	mVisible = !mVisible;
+	mNeedsVertexUpdate = true;
+}
+
+bool NetworkDiagnostics::isVisible() const
+{
+	return mVisible;
+}
+
+void NetworkDiagnostics::recordPacket(Direction direction, sf::Int32 packetType, std::size_t bytes)
+{
+	// sf::Packet puts a 32 bit size in front of every packet on a TCP socket
+	mTrafficWindow[direction][packetType] += bytes + sizeof(sf::Uint32);
+}
+
+void NetworkDiagnostics::recordSnapshot()
+{
+	float interArrival = mSnapshotClock.restart().asSeconds() * 1000.f;
+	if (!mHasSnapshot)
+	{
+		mHasSnapshot = true;
+		return;
+	}
+
+	// RFC 3550 style: smoothed difference between consecutive inter-arrival times, independent of the snapshot rate
+	mLatest[Jitter] += (std::abs(interArrival - mLastInterArrival) - mLatest[Jitter]) / 16.f;
+	mLastInterArrival = interArrival;
+	mWorstInterArrival = std::max(mWorstInterArrival, interArrival);
+}
+
+void NetworkDiagnostics::recordInterpolation(float backlog, float predictionError)
+{
+	mLatest[InterpolationBacklog] = backlog;
+	mLatest[PredictionError] = predictionError;
+}
+
+void NetworkDiagnostics::update(sf::Time dt, sf::Time roundTripTime)
+{
+	mLatest[RoundTrip] = roundTripTime.asSeconds() * 1000.f;
+
+	mSampleTime += dt;
+	while (mSampleTime >= SampleInterval)
+	{
+		mSampleTime -= SampleInterval;
+		takeSample();
+	}
+}
+
+void NetworkDiagnostics::takeSample()
+{
+	// A stalled stream shows up as a growing interval rather than a flat line at the last arrival
+	float sinceLast = mHasSnapshot ? mSnapshotClock.getElapsedTime().asSeconds() * 1000.f : 0.f;
+	mLatest[SnapshotInterval] = std::max(mWorstInterArrival, sinceLast);
+	mWorstInterArrival = 0.f;
+
+	for (std::size_t graph = 0; graph < GraphCount; ++graph)
+	{
+		mSamples[graph].push_back(mLatest[graph]);
+		if (mSamples[graph].size() > SampleCount)
+			mSamples[graph].pop_front();
+	}
+
+	float perSecond = 1.f / SampleInterval.asSeconds();
+	for (std::size_t direction = 0; direction < DirectionCount; ++direction)
+	{
+		TrafficSample sample;
+		FOREACH(auto& pair, mTrafficWindow[direction])
+			sample.push_back(std::make_pair(pair.first, pair.second * perSecond));
+
+		mTrafficWindow[direction].clear();
+		mTraffic[direction].push_back(sample);
+		if (mTraffic[direction].size() > SampleCount)
+			mTraffic[direction].pop_front();
+	}
+
+	mNeedsVertexUpdate = true;
+}
+
+void NetworkDiagnostics::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
+	if (!mVisible)
+		return;
+
+	if (mNeedsVertexUpdate)
+	{
+		computeVertices();
+		mNeedsVertexUpdate = false;
+	}
+
+	target.draw(mVertexArray, states);
+	target.draw(mTitles, states);
+	target.draw(mLegend, states);
+}
+
+void NetworkDiagnostics::computeVertices() const
+{
+	mVertexArray.clear();
+
+	std::string titles;
+	std::string legend;
+	float graphHeight = GraphLines * mLineSpacing;
+
+	for (std::size_t graph = 0; graph < GraphCount; ++graph)
+	{
+		const std::deque<float>& samples = mSamples[graph];
+		float top = Top + (graph * PanelLines + 1) * mLineSpacing;
+
+		float scale = GraphMinScale[graph];
+		FOREACH(float value, samples)
+			scale = std::max(scale, value);
+
+		addQuad(Left, top, GraphWidth, graphHeight, PanelColor);
+		for (std::size_t i = 0; i < samples.size(); ++i)
+		{
+			float height = graphHeight * samples[i] / scale;
+			addQuad(Left + i * BarWidth, top + graphHeight - height, BarWidth, height, GraphColors[graph]);
+		}
+
+		float latest = samples.empty() ? 0.f : samples.back();
+		titles += std::string(GraphNames[graph]) + " " + toString(static_cast<int>(latest + 0.5f)) + " " + GraphUnits[graph]
+			+ " (max " + toString(static_cast<int>(scale + 0.5f)) + ")\n\n\n\n";
+		legend += "\n\n\n\n";
+	}
+
+	for (std::size_t direction = 0; direction < DirectionCount; ++direction)
+	{
+		const std::deque<TrafficSample>& traffic = mTraffic[direction];
+		std::size_t panel = GraphCount + direction;
+		float top = Top + (panel * PanelLines + 1) * mLineSpacing;
+
+		// Per type totals of the last second, for the legend
+		std::map<sf::Int32, float> recent;
+		std::size_t recentCount = std::min<std::size_t>(traffic.size(), static_cast<std::size_t>(1.f / SampleInterval.asSeconds()));
+		for (std::size_t i = traffic.size() - recentCount; i < traffic.size(); ++i)
+		{
+			FOREACH(auto& pair, traffic[i])
+				recent[pair.first] += pair.second / recentCount;
+		}
+
+		float scale = TrafficMinScale;
+		FOREACH(const TrafficSample& sample, traffic)
+		{
+			float total = 0.f;
+			FOREACH(auto& pair, sample)
+				total += pair.second;
+			scale = std::max(scale, total);
+		}
+
+		// Stacked bars, one segment per message type
+		addQuad(Left, top, GraphWidth, graphHeight, PanelColor);
+		for (std::size_t i = 0; i < traffic.size(); ++i)
+		{
+			float bottom = top + graphHeight;
+			FOREACH(auto& pair, traffic[i])
+			{
+				float height = graphHeight * pair.second / scale;
+				addQuad(Left + i * BarWidth, bottom - height, BarWidth, height, getTrafficColor(pair.first));
+				bottom -= height;
+			}
+		}
+
+		float total = 0.f;
+		std::vector<std::pair<float, sf::Int32>> ranked;
+		FOREACH(auto& pair, recent)
+		{
+			total += pair.second;
+			ranked.push_back(std::make_pair(pair.second, pair.first));
+		}
+		std::sort(ranked.rbegin(), ranked.rend());
+
+		titles += std::string("bytes ") + DirectionNames[direction] + " " + toString(static_cast<int>(total + 0.5f)) + " B/s\n\n\n\n";
+
+		legend += "\n";
+		for (std::size_t i = 0; i < LegendEntries; ++i)
+		{
+			if (i < ranked.size())
+			{
+				addQuad(Left + GraphWidth + 6.f, top + i * mLineSpacing + 2.f, 8.f, mLineSpacing - 4.f, getTrafficColor(ranked[i].second));
+				legend += getPacketName(static_cast<Direction>(direction), ranked[i].second) + " " + toString(static_cast<int>(ranked[i].first + 0.5f));
+			}
+			legend += "\n";
+		}
+	}
+
+	mTitles.setString(titles);
+	mLegend.setString(legend);
+}
+
+void NetworkDiagnostics::addQuad(float left, float top, float width, float height, const sf::Color& color) const
+{
+	mVertexArray.append(sf::Vertex(sf::Vector2f(left, top), color));
+	mVertexArray.append(sf::Vertex(sf::Vector2f(left + width, top), color));
+	mVertexArray.append(sf::Vertex(sf::Vector2f(left + width, top + height), color));
+	mVertexArray.append(sf::Vertex(sf::Vector2f(left, top + height), color));
+}
+
+std::string NetworkDiagnostics::getPacketName(Direction direction, sf::Int32 packetType) const
+{
+	const char** names = (direction == Incoming) ? ServerPacketNames : ClientPacketNames;
+	std::size_t count = (direction == Incoming) ? sizeof(ServerPacketNames) / sizeof(ServerPacketNames[0]) : sizeof(ClientPacketNames) / sizeof(ClientPacketNames[0]);
+
+	if (packetType >= 0 && static_cast<std::size_t>(packetType) < count)
+		return names[packetType];
+
+	return "#" + toString(packetType);
+}
@@ -0,0 +1,89 @@
+#ifndef BOOK_NETWORKDIAGNOSTICS_HPP
+#define BOOK_NETWORKDIAGNOSTICS_HPP
+
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/Time.hpp>
+#include <SFML/System/NonCopyable.hpp>
+#include <SFML/Graphics/Drawable.hpp>
+#include <SFML/Graphics/VertexArray.hpp>
+#include <SFML/Graphics/Text.hpp>
+#include <SFML/Graphics/Font.hpp>
+
+#include <deque>
+#include <map>
+#include <vector>
+
+
+// Toggleable overlay with rolling graphs of the client's connection. All graphs go into one vertex array
+// that is only rebuilt when a new sample comes in, titles and legends are two texts: three draw calls in total.
+class NetworkDiagnostics : public sf::Drawable, private sf::NonCopyable
+{
+	public:
+		enum Graph
+		{
+			RoundTrip,
+			Jitter,
+			SnapshotInterval,
+			InterpolationBacklog,
+			PredictionError,
+			GraphCount
+		};
+
+		enum Direction
+		{
+			Incoming,
+			Outgoing,
+			DirectionCount
+		};
+
+
+	public:
+		explicit					NetworkDiagnostics(const sf::Font& font);
+
+		void						toggle();
+		bool						isVisible() const;
+
+		void						recordPacket(Direction direction, sf::Int32 packetType, std::size_t bytes);
+		void						recordSnapshot();
+		// Average distance remote tanks still have to go to their snapshot, and how far our own tanks are from the server's copy
+		void						recordInterpolation(float backlog, float predictionError);
+		void						update(sf::Time dt, sf::Time roundTripTime);
+
+
+	private:
+		typedef std::vector<std::pair<sf::Int32, float>> TrafficSample;
+
+
+	private:
+		virtual void				draw(sf::RenderTarget& target, sf::RenderStates states) const;
+
+		void						takeSample();
+		void						computeVertices() const;
+		void						addQuad(float left, float top, float width, float height, const sf::Color& color) const;
+		std::string					getPacketName(Direction direction, sf::Int32 packetType) const;
+
+
+	private:
+		bool						mVisible;
+		sf::Time					mSampleTime;
+
+		std::deque<float>			mSamples[GraphCount];
+		float						mLatest[GraphCount];
+
+		sf::Clock					mSnapshotClock;
+		bool						mHasSnapshot;
+		float						mLastInterArrival;
+		float						mWorstInterArrival;
+
+		std::map<sf::Int32, std::size_t>	mTrafficWindow[DirectionCount];
+		std::deque<TrafficSample>	mTraffic[DirectionCount];
+
+		mutable sf::Text			mTitles;
+		mutable sf::Text			mLegend;
+		float						mLineSpacing;
+
+		mutable sf::VertexArray		mVertexArray;
+		mutable bool				mNeedsVertexUpdate;
+};
+
+#endif // BOOK_NETWORKDIAGNOSTICS_HPP
@@ -7,6 +7,7 @@
 NetworkNode::NetworkNode()
 : SceneNode()
 , mPendingActions()
+, mCurrentTick(0)
 {
 }
 
@@ -17,7 +18,19 @@ unsigned int NetworkNode::getCategory() const
 
 void NetworkNode::notifyGameAction(GameActions::Type type, sf::Vector2f position)
 {
-	mPendingActions.push(GameActions::Action(type, position));
+	notifyGameAction(GameActions::Action(type, position));
+}
+
+// Actions are stamped with the world tick they happened in
+void NetworkNode::notifyGameAction(GameActions::Action action)
+{
+	action.tick = mCurrentTick;
+	mPendingActions.push(action);
+}
+
+void NetworkNode::setCurrentTick(sf::Uint32 tick)
+{
+	mCurrentTick = tick;
 }
 
 bool NetworkNode::pollGameAction(GameActions::Action& out)
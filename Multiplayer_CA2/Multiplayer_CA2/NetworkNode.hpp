@@ -13,13 +13,16 @@ class NetworkNode : public SceneNode
 								NetworkNode();
 
 		void					notifyGameAction(GameActions::Type type, sf::Vector2f position);
+		void					notifyGameAction(GameActions::Action action);
 		bool					pollGameAction(GameActions::Action& out);
+		void					setCurrentTick(sf::Uint32 tick);
 
 		virtual unsigned int	getCategory() const;
 
 
 	private:
 		std::queue<GameActions::Action>	mPendingActions;
+		sf::Uint32						mCurrentTick;
 };
 
 #endif // BOOK_NETWORKNODE_HPP
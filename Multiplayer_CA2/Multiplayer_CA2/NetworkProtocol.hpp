@@ -8,14 +8,22 @@
 
 
 const unsigned short ServerPort = 50005;
+const unsigned short RelayPort = 50006;		// Match server accepts a single spectator relay here
+const unsigned short SpectatorPort = 50007;	// Spectator relay accepts spectator clients here
+const unsigned short NetSimPort = 50008;	// Network condition simulator accepts clients here
+const unsigned short LobbyPort = 50009;		// Matchmaking lobby accepts queueing clients here
+const unsigned short MatchServerBasePort = 50100;	// Lobby-run match servers use every second port from here (game, relay)
 
+const sf::Int32 ServerTickRate = 20;		// Server ticks per second, the unit of the serverTick header field
+
+// Every server packet starts with [Int32:packetType] [Uint32:serverTick]; the formats below list the fields after that header
 namespace Server
 {
 	// Packets originated in the server
 	enum PacketType
 	{
-		BroadcastMessage,	// format: [Int32:packetType] [string:message]
-		SpawnSelf,			// format: [Int32:packetType]
+		BroadcastMessage,	// format: [string:message]
+		SpawnSelf,			// format: (empty)
 		InitialState,
 		PlayerEvent,
 		PlayerRealtimeChange,
@@ -25,7 +33,21 @@ namespace Server
 		SpawnEnemy,
 		SpawnPickup,
 		UpdateClientState,
-		MissionSuccess
+		MissionSuccess,
+		UpdateObjectState,	// format: [Uint32:version] [Int32:count] ReplicatedState...
+		MatchSeed,			// format: [Uint64:seed], sent after InitialState
+		FireEvent,			// format: [Int32:tank] [Uint32:tick] [Uint32:seed]
+		Ping,				// format: [Uint32:sequence], answered with Client::Pong
+		UpdateClientStateCompact,	// format: [float:battlefield] [Int32:count] ([Int32:id] [Int16:x] [Int16:y] [Uint8:rotation])...
+		ClockPong,			// format: [Uint32:sequence] [Int64:clientSendUs] [Int64:serverReceiveUs] [Int64:serverSendUs]
+		SessionToken,		// format: [Uint64:token], sent after SpawnSelf; present it in Client::Hello to resume after a drop
+		SessionResumed,		// format: [Uint64:token] [bool:full] [float:battlefield]
+							//   [Int32:count] ([Int32:id] [float:x] [float:y] [Int32:hitpoints] [float:rotation])...	tanks that joined (full: every tank)
+							//   [Int32:count] [Int32:id]...									tanks that left
+							//   [Int32:count] ([Int32:id] [Int32:hitpoints])...				hitpoint changes
+		DesyncProbe,		// format: [Uint32:tick], the client's state hash for that tick disagreed for too long; answered with Client::DesyncDetail
+		AssetManifest,		// format: [Int32:count] ([string:name] [Uint64:hash] [Uint32:size])..., answers Client::Hello; answered with Client::AssetRequest
+		AssetChunk			// format: [Uint64:hash] [Uint32:offset] [Uint32:size] [size bytes], requested blobs stream in order before the peer is admitted
 	};
 }
 
@@ -37,9 +59,29 @@ namespace Client
 		PlayerEvent,
 		PlayerRealtimeChange,
 		RequestCoopPartner,
-		PositionUpdate,
+		PositionUpdate,		// format: [Int32:packetType] [Int32:count] ([Int32:id] [float:x] [float:y] [Int32:hitpoints] [float:rotation])... [Uint32:hashTick] [Uint32:stateHash]
 		GameEvent,
-		Quit
+		Quit,
+		Heartbeat,			// format: [Int32:packetType], keeps idle connections (e.g. the spectator relay) alive
+		ObjectStateUpdate,	// format: [Int32:packetType] [Int32:count] ReplicatedState..., only accepted from the authority
+		ObjectStateAck,		// format: [Int32:packetType] [Uint32:version]
+		FireEvent,			// format: [Int32:packetType] [Int32:tank] [Uint32:tick] [Uint32:seed]
+		Pong,				// format: [Int32:packetType] [Uint32:sequence]
+		ClockPing,			// format: [Int32:packetType] [Uint32:sequence] [Int64:clientSendUs], answered with Server::ClockPong
+		Hello,				// format: [Int32:packetType] [Uint64:sessionToken] [Uint32:lastServerTick] [bool:authority], first packet on every connection; token 0 joins as a new player
+		DesyncDetail,		// format: [Int32:packetType] [Uint32:tick] [Int32:count] ([Uint64:key] [Uint32:hash])..., the StateHash entries for that tick
+		AssetRequest		// format: [Int32:packetType] [Int32:count] [Uint64:hash]..., manifest blobs missing from the client's cache; empty joins right away
+	};
+}
+
+// Lobby protocol, spoken on LobbyPort only. No tick header, the lobby is not a match server.
+namespace Lobby
+{
+	enum PacketType
+	{
+		JoinQueue,			// client -> lobby, format: [Int32:packetType]
+		QueueStatus,		// lobby -> client, format: [Int32:packetType] [Int32:position] [Int32:queued] [Int32:servers]
+		MatchFound			// lobby -> client, format: [Int32:packetType] [string:address] [Uint16:port] [bool:authority]
 	};
 }
 
@@ -62,6 +104,7 @@ namespace GameActions
 	enum Type
 	{
 		EnemyExplode,
+		TankFired,			// A locally controlled tank fired; identifier, tick and seed are set
 	};
 
 	struct Action
@@ -73,11 +116,26 @@ namespace GameActions
 		Action(Type type, sf::Vector2f position)
 		: type(type)
 		, position(position)
+		, identifier(0)
+		, tick(0)
+		, seed(0)
+		{
+		}
+
+		Action(Type type, sf::Vector2f position, sf::Int32 identifier, sf::Uint32 seed)
+		: type(type)
+		, position(position)
+		, identifier(identifier)
+		, tick(0)
+		, seed(seed)
 		{
 		}
 
 		Type			type;
 		sf::Vector2f	position;
+		sf::Int32		identifier;
+		sf::Uint32		tick;
+		sf::Uint32		seed;
 	};
 }
 
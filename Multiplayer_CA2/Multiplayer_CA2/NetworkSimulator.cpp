@@ -0,0 +1,326 @@
+//D00137655 - Jason Lynch
+//D00194504 - Dylan
+#include "NetworkSimulator.hpp"
+#include "NetworkProtocol.hpp"
+#include "Foreach.hpp"
+
+#include <SFML/System/Sleep.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+
+namespace
+{
+	// Lower bound TCP applies to its retransmission timer
+	const sf::Time MinimumRetransmitTimeout = sf::milliseconds(200);
+}
+
+NetworkSimulator::LinkConditions::LinkConditions()
+: latency(sf::Time::Zero)
+, jitter(sf::Time::Zero)
+, loss(0.f)
+, reorder(0.f)
+, bandwidth(0)
+{
+}
+
+NetworkSimulator::LinkStatistics::LinkStatistics()
+: packets(0)
+, bytes(0)
+, lost(0)
+, reordered(0)
+, totalDelay(sf::Time::Zero)
+, maxDelay(sf::Time::Zero)
+{
+}
+
+NetworkSimulator::Connection::Connection()
+: identifier(0)
+, client()
+, server()
+, connector(server)
+, upstream()
+, downstream()
+, closed(false)
+{
+}
+
+NetworkSimulator::NetworkSimulator(const sf::IpAddress& serverAddress, const std::string& configFile)
+: mServerAddress(serverAddress)
+, mConnectionCounter(0)
+, mRandomEngine(1)
+, mLogInterval(sf::seconds(5.f))
+, mLastLogTime(sf::Time::Zero)
+, mLog("netsim.log", std::ios::app)
+{
+	mListenerSocket.setBlocking(false);
+	loadConfig(configFile);
+
+	mLog << "time_s,connection,direction,packets,bytes,lost,reordered,mean_delay_ms,max_delay_ms,queued" << std::endl;
+}
+
+void NetworkSimulator::run()
+{
+	if (mListenerSocket.listen(NetSimPort) != sf::Socket::Done)
+	{
+		std::cout << "NetSim: could not listen on port " << NetSimPort << std::endl;
+		return;
+	}
+
+	std::cout << "NetSim: proxying port " << NetSimPort << " to " << mServerAddress << ":" << ServerPort << std::endl;
+
+	for (;;)
+	{
+		handleIncomingConnections();
+
+		FOREACH(ConnectionPtr& connection, mConnections)
+		{
+			// The client's first packets wait in its socket until the server side is up
+			if (!updateConnector(*connection))
+				continue;
+
+			if (!receive(connection->client, connection->upstream) || !receive(connection->server, connection->downstream))
+				connection->closed = true;
+
+			if (!deliver(connection->upstream, connection->server) || !deliver(connection->downstream, connection->client))
+				connection->closed = true;
+		}
+
+		if (now() >= mLastLogTime + mLogInterval)
+			logStatistics();
+
+		// Drop closed connections; the other side notices through its own socket
+		for (auto itr = mConnections.begin(); itr != mConnections.end(); )
+		{
+			if ((*itr)->closed)
+			{
+				std::cout << "NetSim: connection " << (*itr)->identifier << " closed" << std::endl;
+				itr = mConnections.erase(itr);
+			}
+			else
+			{
+				++itr;
+			}
+		}
+
+		// Delivery is timed to the millisecond, so only sleep briefly
+		sf::sleep(sf::milliseconds(1));
+	}
+}
+
+// Config lines are "<setting> <value>", '#' starts a comment. Times are in milliseconds, probabilities in [0,1].
+void NetworkSimulator::loadConfig(const std::string& configFile)
+{
+	std::ifstream inputFile(configFile.c_str());
+	if (!inputFile)
+	{
+		// Write a template with every setting so there's something to edit
+		std::ofstream outputFile(configFile.c_str());
+		outputFile << "# up = client to server, down = server to client\n"
+			<< "up.latency 50\nup.jitter 10\nup.loss 0\nup.reorder 0\nup.bandwidth 0\n"
+			<< "down.latency 50\ndown.jitter 10\ndown.loss 0\ndown.reorder 0\ndown.bandwidth 0\n"
+			<< "seed 1\nlog_interval 5\n";
+
+		mUpstreamConditions.latency = mDownstreamConditions.latency = sf::milliseconds(50);
+		mUpstreamConditions.jitter = mDownstreamConditions.jitter = sf::milliseconds(10);
+		return;
+	}
+
+	std::string line;
+	while (std::getline(inputFile, line))
+	{
+		std::istringstream stream(line);
+		std::string setting;
+		float value;
+		if (!(stream >> setting >> value) || setting[0] == '#')
+			continue;
+
+		std::string::size_type dot = setting.find('.');
+		if (dot != std::string::npos)
+		{
+			std::string direction = setting.substr(0, dot);
+			std::string name = setting.substr(dot + 1);
+			LinkConditions& conditions = (direction == "up") ? mUpstreamConditions : mDownstreamConditions;
+
+			if (name == "latency")
+				conditions.latency = sf::milliseconds(static_cast<sf::Int32>(value));
+			else if (name == "jitter")
+				conditions.jitter = sf::milliseconds(static_cast<sf::Int32>(value));
+			else if (name == "loss")
+				conditions.loss = value;
+			else if (name == "reorder")
+				conditions.reorder = value;
+			else if (name == "bandwidth")
+				conditions.bandwidth = static_cast<std::size_t>(value);
+		}
+		else if (setting == "seed")
+		{
+			mRandomEngine.seed(static_cast<std::mt19937::result_type>(value));
+		}
+		else if (setting == "log_interval")
+		{
+			mLogInterval = sf::seconds(value);
+		}
+	}
+}
+
+void NetworkSimulator::handleIncomingConnections()
+{
+	ConnectionPtr connection(new Connection());
+	if (mListenerSocket.accept(connection->client) != sf::Socket::Done)
+		return;
+
+	// Connecting without blocking, a slow or missing server must not stall the links already relaying
+	connection->client.setBlocking(false);
+	connection->connector.start(mServerAddress, ServerPort, sf::seconds(5.f));
+	connection->identifier = ++mConnectionCounter;
+	connection->upstream.conditions = mUpstreamConditions;
+	connection->downstream.conditions = mDownstreamConditions;
+
+	std::cout << "NetSim: connection " << connection->identifier << " from " << connection->client.getRemoteAddress() << std::endl;
+	mConnections.push_back(std::move(connection));
+}
+
+// Returns true once the connection is ready to relay
+bool NetworkSimulator::updateConnector(Connection& connection)
+{
+	if (connection.connector.getStatus() == AsyncConnector::Connected)
+		return true;
+
+	switch (connection.connector.update())
+	{
+		case AsyncConnector::Connected:
+			std::cout << "NetSim: connection " << connection.identifier << " reached the server" << std::endl;
+			return true;
+
+		case AsyncConnector::Connecting:
+			return false;
+
+		default:
+			std::cout << "NetSim: could not reach the server, dropping connection " << connection.identifier << std::endl;
+			connection.closed = true;
+			return false;
+	}
+}
+
+bool NetworkSimulator::receive(sf::TcpSocket& socket, Link& link)
+{
+	sf::Packet packet;
+	sf::Socket::Status status;
+	while ((status = socket.receive(packet)) == sf::Socket::Done)
+	{
+		schedule(link, packet);
+		packet.clear();
+	}
+
+	return status != sf::Socket::Disconnected && status != sf::Socket::Error;
+}
+
+// The game runs on TCP, so the simulation keeps TCP's guarantees: a lost segment is retransmitted
+// after a timeout and holds back everything behind it. Reordering is the exception and lets later
+// packets overtake, to exercise code paths meant for an unreliable transport.
+void NetworkSimulator::schedule(Link& link, sf::Packet& packet)
+{
+	const LinkConditions& conditions = link.conditions;
+	std::size_t size = packet.getDataSize() + sizeof(sf::Uint32);
+
+	InFlightPacket inFlight;
+	inFlight.sendTime = now();
+	inFlight.packet = packet;
+
+	sf::Time departure = inFlight.sendTime;
+	if (conditions.bandwidth > 0)
+	{
+		departure = std::max(departure, link.lineFreeTime) + sf::seconds(static_cast<float>(size) / conditions.bandwidth);
+		link.lineFreeTime = departure;
+	}
+
+	sf::Time delay = conditions.latency + conditions.jitter * (2.f * randomFloat() - 1.f);
+	inFlight.deliveryTime = departure + std::max(sf::Time::Zero, delay);
+
+	if (randomFloat() < conditions.loss)
+	{
+		inFlight.deliveryTime += std::max(MinimumRetransmitTimeout, conditions.latency * 2.f);
+		++link.statistics.lost;
+	}
+
+	if (randomFloat() < conditions.reorder)
+	{
+		inFlight.deliveryTime += std::max(sf::milliseconds(10), conditions.latency);
+		++link.statistics.reordered;
+	}
+	else
+	{
+		inFlight.deliveryTime = std::max(inFlight.deliveryTime, link.lastInOrderDelivery);
+		link.lastInOrderDelivery = inFlight.deliveryTime;
+	}
+
+	auto position = std::upper_bound(link.inFlight.begin(), link.inFlight.end(), inFlight.deliveryTime, [] (sf::Time time, const InFlightPacket& other)
+	{
+		return time < other.deliveryTime;
+	});
+	link.inFlight.insert(position, inFlight);
+}
+
+// Returns false once the socket has gone away
+bool NetworkSimulator::deliver(Link& link, sf::TcpSocket& socket)
+{
+	while (!link.inFlight.empty() && link.inFlight.front().deliveryTime <= now())
+	{
+		InFlightPacket& inFlight = link.inFlight.front();
+
+		// Partial keeps its progress inside the packet and NotReady means the socket buffer is full,
+		// either way the packet stays at the front and is retried on the next loop
+		sf::Socket::Status status = socket.send(inFlight.packet);
+		if (status == sf::Socket::Partial || status == sf::Socket::NotReady)
+			return true;
+
+		if (status != sf::Socket::Done)
+			return false;
+
+		sf::Time delay = now() - inFlight.sendTime;
+		++link.statistics.packets;
+		link.statistics.bytes += inFlight.packet.getDataSize();
+		link.statistics.totalDelay += delay;
+		link.statistics.maxDelay = std::max(link.statistics.maxDelay, delay);
+
+		link.inFlight.pop_front();
+	}
+
+	return true;
+}
+
+void NetworkSimulator::logStatistics()
+{
+	FOREACH(ConnectionPtr& connection, mConnections)
+	{
+		logLink(*connection, "up", connection->upstream);
+		logLink(*connection, "down", connection->downstream);
+	}
+
+	mLastLogTime = now();
+}
+
+void NetworkSimulator::logLink(const Connection& connection, const char* direction, Link& link)
+{
+	LinkStatistics& statistics = link.statistics;
+	float meanDelay = statistics.packets > 0 ? statistics.totalDelay.asSeconds() * 1000.f / statistics.packets : 0.f;
+
+	mLog << now().asSeconds() << ',' << connection.identifier << ',' << direction << ','
+		<< statistics.packets << ',' << statistics.bytes << ',' << statistics.lost << ',' << statistics.reordered << ','
+		<< meanDelay << ',' << statistics.maxDelay.asSeconds() * 1000.f << ',' << link.inFlight.size() << std::endl;
+
+	statistics = LinkStatistics();
+}
+
+float NetworkSimulator::randomFloat()
+{
+	return std::uniform_real_distribution<float>(0.f, 1.f)(mRandomEngine);
+}
+
+sf::Time NetworkSimulator::now() const
+{
+	return mClock.getElapsedTime();
+}
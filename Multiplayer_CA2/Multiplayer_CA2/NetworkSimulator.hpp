@@ -0,0 +1,120 @@
+#ifndef BOOK_NETWORKSIMULATOR_HPP
+#define BOOK_NETWORKSIMULATOR_HPP
+
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/Time.hpp>
+#include <SFML/Network/IpAddress.hpp>
+#include <SFML/Network/TcpListener.hpp>
+#include <SFML/Network/TcpSocket.hpp>
+#include <SFML/Network/Packet.hpp>
+
+#include "AsyncConnector.hpp"
+
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+
+
+// Loopback proxy between clients and a GameServer that degrades traffic in a reproducible way.
+// Clients join "<proxy ip>:<NetSimPort>" instead of the server address.
+class NetworkSimulator
+{
+	public:
+		// Conditions for one direction of a connection
+		struct LinkConditions
+		{
+									LinkConditions();
+
+			sf::Time				latency;
+			sf::Time				jitter;
+			float					loss;				// Probability [0,1] a packet needs a retransmission
+			float					reorder;			// Probability [0,1] a packet is overtaken by later ones
+			std::size_t				bandwidth;			// Bytes per second, 0 = unlimited
+		};
+
+
+	public:
+											NetworkSimulator(const sf::IpAddress& serverAddress, const std::string& configFile);
+
+		// Blocks forever, proxying every accepted client to the server
+		void								run();
+
+
+	private:
+		struct InFlightPacket
+		{
+			sf::Time				deliveryTime;
+			sf::Time				sendTime;
+			sf::Packet				packet;
+		};
+
+		struct LinkStatistics
+		{
+									LinkStatistics();
+
+			std::size_t				packets;
+			std::size_t				bytes;
+			std::size_t				lost;
+			std::size_t				reordered;
+			sf::Time				totalDelay;
+			sf::Time				maxDelay;
+		};
+
+		struct Link
+		{
+			LinkConditions			conditions;
+			std::deque<InFlightPacket>	inFlight;		// Sorted by delivery time
+			sf::Time				lineFreeTime;		// When the bandwidth cap lets the next packet out
+			sf::Time				lastInOrderDelivery;
+			LinkStatistics			statistics;
+		};
+
+		struct Connection
+		{
+									Connection();
+
+			std::size_t				identifier;
+			sf::TcpSocket			client;
+			sf::TcpSocket			server;
+			AsyncConnector			connector;			// Server side, relaying starts once it has connected
+			Link					upstream;			// Client to server
+			Link					downstream;			// Server to client
+			bool					closed;
+		};
+
+		typedef std::unique_ptr<Connection> ConnectionPtr;
+
+
+	private:
+		void								loadConfig(const std::string& configFile);
+		void								handleIncomingConnections();
+		bool								updateConnector(Connection& connection);
+		bool								receive(sf::TcpSocket& socket, Link& link);
+		void								schedule(Link& link, sf::Packet& packet);
+		bool								deliver(Link& link, sf::TcpSocket& socket);
+		void								logStatistics();
+		void								logLink(const Connection& connection, const char* direction, Link& link);
+		float								randomFloat();
+		sf::Time							now() const;
+
+
+	private:
+		sf::IpAddress						mServerAddress;
+		sf::TcpListener						mListenerSocket;
+		std::vector<ConnectionPtr>			mConnections;
+		std::size_t							mConnectionCounter;
+
+		LinkConditions						mUpstreamConditions;
+		LinkConditions						mDownstreamConditions;
+		std::mt19937						mRandomEngine;
+
+		sf::Clock							mClock;
+		sf::Time							mLogInterval;
+		sf::Time							mLastLogTime;
+		std::ofstream						mLog;
+};
+
+#endif // BOOK_NETWORKSIMULATOR_HPP
@@ -0,0 +1,8 @@
+//D00137655 - Jason Lynch
+//D00194504 - Dylan
+#include "NodePool.hpp"
+
+
+NodeRecycler::~NodeRecycler()
+{
+}
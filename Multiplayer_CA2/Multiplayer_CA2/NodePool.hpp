@@ -0,0 +1,50 @@
+#ifndef BOOK_NODEPOOL_HPP
+#define BOOK_NODEPOOL_HPP
+
+#include "SceneNode.hpp"
+#include "Foreach.hpp"
+
+#include <SFML/System/NonCopyable.hpp>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+
+// What SceneNode::Deleter hands a pooled node back to, without knowing its type
+class NodeRecycler
+{
+	public:
+		virtual							~NodeRecycler();
+
+		virtual void					recycle(SceneNode& node) = 0;
+};
+
+// Recycles scene nodes of one class, keeping a free list per Node::Type so a reused node (children included)
+// already has the structure its type needs and only has to be reset. Nodes go back on their free list when
+// removeWrecks() lets go of them, so once the lists hold enough nodes spawning never allocates.
+// The pool must outlive every node it handed out, i.e. be declared before the scene graph that holds them.
+template <typename Node>
+class NodePool : public NodeRecycler, private sf::NonCopyable
+{
+	public:
+		typedef std::unique_ptr<Node, SceneNode::Deleter> Ptr;
+
+
+	public:
+										NodePool();
+		virtual							~NodePool();
+
+		// A recycled node reset by SceneNode::reset(), or a new Node(type, args...) when none is free
+		template <typename... Args>
+		Ptr								acquire(typename Node::Type type, Args&&... args);
+
+		virtual void					recycle(SceneNode& node);
+
+
+	private:
+		std::vector<std::vector<Node*>>	mFree;
+};
+
+#include "NodePool.inl"
+#endif // BOOK_NODEPOOL_HPP
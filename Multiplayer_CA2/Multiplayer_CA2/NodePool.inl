@@ -0,0 +1,43 @@
+template <typename Node>
+NodePool<Node>::NodePool()
+: mFree(Node::TypeCount)
+{
+}
+
+template <typename Node>
+NodePool<Node>::~NodePool()
+{
+	FOREACH(std::vector<Node*>& free, mFree)
+	{
+		FOREACH(Node* node, free)
+		{
+			node->mRecycler = nullptr;
+			delete node;
+		}
+	}
+}
+
+template <typename Node>
+template <typename... Args>
+typename NodePool<Node>::Ptr NodePool<Node>::acquire(typename Node::Type type, Args&&... args)
+{
+	std::vector<Node*>& free = mFree[type];
+	if (free.empty())
+	{
+		Ptr node(new Node(type, std::forward<Args>(args)...));
+		node->mRecycler = this;
+		return node;
+	}
+
+	Ptr node(free.back());
+	free.pop_back();
+	node->reset();
+	return node;
+}
+
+template <typename Node>
+void NodePool<Node>::recycle(SceneNode& node)
+{
+	Node& pooled = static_cast<Node&>(node);
+	mFree[pooled.getType()].push_back(&pooled);
+}
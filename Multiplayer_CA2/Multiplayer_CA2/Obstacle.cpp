@@ -29,6 +29,7 @@ Obstacle::Obstacle(Obstacle::Type type, const TextureHolder& textures, const Fon
 	, mIsMarkedForRemoval(false)
 	, mHealthDisplay(nullptr)
 	, mCurrentHitpoints(Table[static_cast<int>(type)].hitpoints)
+	, mRandom()
 {
 	//Set up animation with custom paramaters 
 	mExplosion.setFrameSize(frameSize);
@@ -85,6 +86,11 @@ void Obstacle::playerLocalSound(CommandQueue& commands, SoundEffect::ID effect)
 	commands.push(command);
 }
 
+void Obstacle::setRandomSeed(sf::Uint64 seed)
+{
+	mRandom.seed(seed);
+}
+
 void Obstacle::drawCurrent(sf::RenderTarget& target, sf::RenderStates states) const
 {
 	if (isDestroyed() && mShowExplosion)
@@ -104,7 +110,7 @@ void Obstacle::updateCurrent(sf::Time dt, CommandQueue& commands)
 		//Play explosion sound
 		if (!mPlayedExplosionSound)
 		{
-			SoundEffect::ID soundEffect = (randomInt(2) == 0) ? SoundEffect::Explosion1 : SoundEffect::Explosion2;
+			SoundEffect::ID soundEffect = (mRandom.nextInt(2) == 0) ? SoundEffect::Explosion1 : SoundEffect::Explosion2;
 			playerLocalSound(commands, soundEffect);
 
 			mPlayedExplosionSound = true;
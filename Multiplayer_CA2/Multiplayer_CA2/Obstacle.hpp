@@ -7,6 +7,7 @@
 #include "TextNode.hpp"
 #include "Projectile.hpp"
 #include "Animation.hpp"
+#include "RandomEngine.hpp"
 
 class Obstacle : public Entity //Built from tank.hpp framework. Handles all environmental objects in ObstacleID - Jason Lynch
 {
@@ -28,6 +29,7 @@ public:
 	virtual unsigned int getDamage() const; //Returns damage object deals - Jason Lynch 
 
 	void playerLocalSound(CommandQueue& command, SoundEffect::ID effect); //Plays sound effect - Jason Lynch
+	void setRandomSeed(sf::Uint64 seed); //Obstacles update on worker threads, so their draws come from their own engine
 
 private:
 	virtual void drawCurrent(sf::RenderTarget& target, sf::RenderStates states) const;
@@ -45,4 +47,5 @@ private:
 	bool mPlayedExplosionSound;
 
 	int mCurrentHitpoints;
+	RandomEngine mRandom;
 };
\ No newline at end of file
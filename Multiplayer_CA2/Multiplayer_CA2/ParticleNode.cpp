@@ -5,6 +5,7 @@
 #include "DataTables.hpp"
 #include "ResourceHolder.hpp"
 
+#include <SFML/System/Lock.hpp>
 #include <SFML/Graphics/RenderTarget.hpp>
 #include <SFML/Graphics/Texture.hpp>
 
@@ -19,6 +20,7 @@ namespace
 ParticleNode::ParticleNode(Particle::Type type, const TextureHolder& textures)
 : SceneNode()
 , mParticles()
+, mMutex()
 , mTexture(textures.get(Textures::Particle))
 , mType(type)
 , mVertexArray(sf::Quads)
@@ -33,6 +35,7 @@ void ParticleNode::addParticle(sf::Vector2f position)
 	particle.color = Table[mType].color;
 	particle.lifetime = Table[mType].lifetime;
 
+	sf::Lock lock(mMutex);
 	mParticles.push_back(particle);
 }
 
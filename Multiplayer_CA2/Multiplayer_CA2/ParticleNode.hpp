@@ -5,6 +5,7 @@
 #include "ResourceIdentifiers.hpp"
 #include "Particle.hpp"
 
+#include <SFML/System/Mutex.hpp>
 #include <SFML/Graphics/VertexArray.hpp>
 
 #include <deque>
@@ -15,6 +16,7 @@ class ParticleNode : public SceneNode
 	public:
 								ParticleNode(Particle::Type type, const TextureHolder& textures);
 
+		// Emitters on entities call this from the World's update jobs, concurrently
 		void					addParticle(sf::Vector2f position);
 		Particle::Type			getParticleType() const;
 		virtual unsigned int	getCategory() const;
@@ -30,6 +32,7 @@ class ParticleNode : public SceneNode
 
 	private:
 		std::deque<Particle>	mParticles;
+		sf::Mutex				mMutex;
 		const sf::Texture&		mTexture;
 		Particle::Type			mType;
 
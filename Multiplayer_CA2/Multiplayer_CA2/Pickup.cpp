@@ -23,6 +23,16 @@ Pickup::Pickup(Type type, const TextureHolder& textures)
 	centerOrigin(mSprite);
 }
 
+void Pickup::resetCurrent()
+{
+	resetEntity(1);
+}
+
+Pickup::Type Pickup::getType() const
+{
+	return mType;
+}
+
 unsigned int Pickup::getCategory() const
 {
 	return Category::Pickup;
@@ -30,6 +30,7 @@ class Pickup : public Entity
 	public:
 								Pickup(Type type, const TextureHolder& textures);
 
+		Type					getType() const;
 		virtual unsigned int	getCategory() const;
 		virtual sf::FloatRect	getBoundingRect() const;
 
@@ -37,6 +38,7 @@ class Pickup : public Entity
 
 
 	protected:
+		virtual void			resetCurrent();
 		virtual void			drawCurrent(sf::RenderTarget& target, sf::RenderStates states) const;
 
 
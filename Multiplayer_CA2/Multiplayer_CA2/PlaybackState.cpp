@@ -0,0 +1,165 @@
+//D00137655 - Jason Lynch
+//D00194504 - Dylan
+#include "PlaybackState.hpp"
+#include "Foreach.hpp"
+#include "Utility.hpp"
+
+#include <SFML/Graphics/RenderWindow.hpp>
+
+#include <algorithm>
+
+
+PlaybackState::PlaybackState(StateStack& stack, Context context)
+: State(stack, context)
+, mWorld(*context.window, *context.fonts, *context.sounds, *context.jobs, true)
+, mWindow(*context.window)
+, mPlayback()
+, mSnapshot()
+, mTankIdentifiers()
+, mPlaybackTime(sf::Time::Zero)
+, mPaused(false)
+{
+	// Matches are recorded from deterministic worlds
+	mWorld.setDeterministic(true);
+
+	mStatusText.setFont(context.fonts->get(Fonts::Main));
+	mStatusText.setCharacterSize(20);
+	mStatusText.setPosition(10.f, 740.f);
+
+	if (mPlayback.open(MatchRecording::Filename))
+	{
+		mWorld.setWorldHeight(mPlayback.getWorldHeight());
+		applySnapshot();
+	}
+
+	updateStatusText();
+}
+
+void PlaybackState::draw()
+{
+	if (mPlayback.isOpen())
+		mWorld.draw();
+
+	mWindow.setView(mWindow.getDefaultView());
+	mWindow.draw(mStatusText);
+}
+
+bool PlaybackState::update(sf::Time dt)
+{
+	if (!mPlayback.isOpen())
+		return true;
+
+	if (!mPaused)
+	{
+		mPlaybackTime = std::min(mPlaybackTime + dt, mPlayback.getDuration());
+		applySnapshot();
+	}
+
+	mWorld.update(dt);
+
+	// Nothing to send game actions to during a replay
+	GameActions::Action gameAction;
+	while (mWorld.pollGameAction(gameAction))
+	{
+	}
+
+	updateStatusText();
+	return true;
+}
+
+bool PlaybackState::handleEvent(const sf::Event& event)
+{
+	if (event.type != sf::Event::KeyPressed)
+		return true;
+
+	switch (event.key.code)
+	{
+		case sf::Keyboard::Escape:
+			requestStackPop();
+			requestStackPush(States::Menu);
+			break;
+
+		case sf::Keyboard::Space:
+			mPaused = !mPaused;
+			break;
+
+		case sf::Keyboard::Left:
+			seek(sf::seconds(-10.f));
+			break;
+
+		case sf::Keyboard::Right:
+			seek(sf::seconds(10.f));
+			break;
+
+		default:
+			break;
+	}
+
+	return true;
+}
+
+void PlaybackState::seek(sf::Time offset)
+{
+	if (!mPlayback.isOpen())
+		return;
+
+	mPlaybackTime = std::max(sf::Time::Zero, std::min(mPlaybackTime + offset, mPlayback.getDuration()));
+	applySnapshot();
+}
+
+void PlaybackState::applySnapshot()
+{
+	float battlefieldPosition;
+	if (!mPlayback.sample(mPlaybackTime, mSnapshot, battlefieldPosition))
+		return;
+
+	mWorld.setCurrentBattleFieldPosition(battlefieldPosition);
+
+	// Remove tanks that are gone at this point of the match (e.g. after seeking backwards past their spawn)
+	for (auto itr = mTankIdentifiers.begin(); itr != mTankIdentifiers.end(); )
+	{
+		sf::Int32 identifier = *itr;
+		bool present = std::any_of(mSnapshot.begin(), mSnapshot.end(), [identifier] (const MatchRecording::TankSnapshot& tank)
+		{
+			return tank.identifier == identifier;
+		});
+
+		if (present)
+		{
+			++itr;
+			continue;
+		}
+
+		mWorld.removeTank(identifier);
+		itr = mTankIdentifiers.erase(itr);
+	}
+
+	FOREACH(const MatchRecording::TankSnapshot& snapshot, mSnapshot)
+	{
+		Tank* tank = mWorld.getTank(snapshot.identifier);
+		if (!tank)
+		{
+			tank = mWorld.addTank(snapshot.identifier);
+			mTankIdentifiers.insert(snapshot.identifier);
+		}
+
+		tank->setPosition(snapshot.position);
+		tank->setRotation(snapshot.rotation);
+		if (snapshot.hitpoints > 0)
+			tank->setHitpoints(snapshot.hitpoints);
+	}
+}
+
+void PlaybackState::updateStatusText()
+{
+	if (!mPlayback.isOpen())
+	{
+		mStatusText.setString("No recording found - host a match to record one. Escape to go back");
+		return;
+	}
+
+	mStatusText.setString(toString(static_cast<int>(mPlaybackTime.asSeconds())) + "s / "
+		+ toString(static_cast<int>(mPlayback.getDuration().asSeconds())) + "s"
+		+ (mPaused ? "  (paused)" : "")
+		+ "   Space: pause   Left/Right: seek 10s   Escape: menu");
+}
@@ -0,0 +1,42 @@
+#ifndef BOOK_PLAYBACKSTATE_HPP
+#define BOOK_PLAYBACKSTATE_HPP
+
+#include "State.hpp"
+#include "World.hpp"
+#include "MatchPlayback.hpp"
+
+#include <SFML/Graphics/Text.hpp>
+
+#include <set>
+
+
+// Renders a recorded match; Space pauses, Left/Right seek, Escape returns to the menu
+class PlaybackState : public State
+{
+	public:
+							PlaybackState(StateStack& stack, Context context);
+
+		virtual void		draw();
+		virtual bool		update(sf::Time dt);
+		virtual bool		handleEvent(const sf::Event& event);
+
+
+	private:
+		void				seek(sf::Time offset);
+		void				applySnapshot();
+		void				updateStatusText();
+
+
+	private:
+		World				mWorld;
+		sf::RenderWindow&	mWindow;
+		MatchPlayback		mPlayback;
+		MatchRecording::Snapshot mSnapshot;
+		std::set<sf::Int32>	mTankIdentifiers;
+
+		sf::Time			mPlaybackTime;
+		bool				mPaused;
+		sf::Text			mStatusText;
+};
+
+#endif // BOOK_PLAYBACKSTATE_HPP
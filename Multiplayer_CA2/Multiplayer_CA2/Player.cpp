@@ -12,6 +12,7 @@
 #include <map>
 #include <string>
 #include <algorithm>
+#include <functional>
 
 
 using namespace std::placeholders;
@@ -20,81 +21,57 @@ using namespace std::placeholders;
 //Added to allow the tank to rotate rather than move left and right
 struct TankRotator
 {
-	TankRotator(float r, int identifier)
+	TankRotator(float r)
 		: rotation(r)
-		, TankID(identifier)
 	{
 	}
 
 	void operator() (Tank& Tank, sf::Time) const
 	{
-		if (Tank.getIdentifier() == TankID)
-			Tank.rotate(rotation);
+		Tank.rotate(rotation);
 	}
 
 	float rotation;
-	int TankID;
 };
 
 //Dylan Reilly
 //Modified to move in the direction the tank is facing, not just up and down
 struct TankMover
 {
-	TankMover(int x, int identifier)
+	TankMover(int x)
 	: direction(x)
-	, TankID(identifier)
 	{
 	}
 
 	void operator() (Tank& Tank, sf::Time) const
 	{
-		if (Tank.getIdentifier() == TankID)
+		if (direction == 1)
 		{
-			if (direction == 1)
-			{
-				Tank.move(Tank.getMaxSpeed() * sin(toRadian(Tank.getRotation())), Tank.getMaxSpeed() * -cos(toRadian(Tank.getRotation())));
-			}
-			else
-			{
-				Tank.move(Tank.getMaxSpeed() * -sin(toRadian(Tank.getRotation())), Tank.getMaxSpeed() * cos(toRadian(Tank.getRotation())));
-			}
+			Tank.drive(-Tank.getMaxSpeed());
+		}
+		else
+		{
+			Tank.drive(Tank.getMaxSpeed());
 		}
 	}
 
 	int direction;
-	int TankID;
 };
 
 struct TankFireTrigger
 {
-	TankFireTrigger(int identifier)
-	: TankID(identifier)
-	{
-	}
-
 	void operator() (Tank& Tank, sf::Time) const
 	{
-		if (Tank.getIdentifier() == TankID)
-			Tank.fire();
+		Tank.fire();
 	}
-
-	int TankID;
 };
 
 struct TankMissileTrigger
 {
-	TankMissileTrigger(int identifier)
-	: TankID(identifier)
-	{
-	}
-
 	void operator() (Tank& Tank, sf::Time) const
 	{
-		if (Tank.getIdentifier() == TankID)
-			Tank.launchMissile();
+		Tank.launchMissile();
 	}
-
-	int TankID;
 };
 
 
@@ -107,9 +84,12 @@ Player::Player(sf::TcpSocket* socket, sf::Int32 identifier, const KeyBinding* bi
 	// Set initial action bindings
 	initializeActions();
 
-	// Assign all categories to player's Tank
+	// Assign all categories to player's Tank, World delivers them to this player's tank only
 	FOREACH(auto & pair, mActionBinding)
+	{
 		pair.second.category = Category::Tank;
+		pair.second.tankIdentifier = mIdentifier;
+	}
 }
 
 //Added joystick handling - Jason Lynch
@@ -260,12 +240,12 @@ Player::MissionStatus Player::getMissionStatus() const
 
 void Player::initializeActions()
 {
-	mActionBinding[PlayerAction::MoveLeft].action      = derivedAction<Tank>(TankRotator(-5.f, mIdentifier));
-	mActionBinding[PlayerAction::MoveRight].action     = derivedAction<Tank>(TankRotator(5.f, mIdentifier));
-	mActionBinding[PlayerAction::MoveUp].action        = derivedAction<Tank>(TankMover(0, mIdentifier));
-	mActionBinding[PlayerAction::MoveDown].action      = derivedAction<Tank>(TankMover(1, mIdentifier));
-	mActionBinding[PlayerAction::Fire].action          = derivedAction<Tank>(TankFireTrigger(mIdentifier));
-	mActionBinding[PlayerAction::LaunchMissile].action = derivedAction<Tank>(TankMissileTrigger(mIdentifier));
+	mActionBinding[PlayerAction::MoveLeft].action      = derivedAction<Tank>(TankRotator(-5.f));
+	mActionBinding[PlayerAction::MoveRight].action     = derivedAction<Tank>(TankRotator(5.f));
+	mActionBinding[PlayerAction::MoveUp].action        = derivedAction<Tank>(TankMover(0));
+	mActionBinding[PlayerAction::MoveDown].action      = derivedAction<Tank>(TankMover(1));
+	mActionBinding[PlayerAction::Fire].action          = derivedAction<Tank>(TankFireTrigger());
+	mActionBinding[PlayerAction::LaunchMissile].action = derivedAction<Tank>(TankMissileTrigger());
 }
 
 //mActionBinding[ActionID::MoveUp].action = derivedAction<Tank>([](Tank& a, sf::Time) { a.move(1.5f * -sin(toRadian(a.getRotation())), 1.5f * cos(toRadian(a.getRotation()))); });
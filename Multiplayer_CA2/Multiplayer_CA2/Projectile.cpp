@@ -5,6 +5,7 @@
 #include "DataTables.hpp"
 #include "Utility.hpp"
 #include "ResourceHolder.hpp"
+#include "FixedPoint.hpp"
 
 #include <SFML/Graphics/RenderTarget.hpp>
 #include <SFML/Graphics/RenderStates.hpp>
@@ -67,12 +68,24 @@ void Projectile::updateCurrent(sf::Time dt, CommandQueue& commands)
 	{
 		const float approachRate = 200.f;
 
-		sf::Vector2f newVelocity = unitVector(approachRate * dt.asSeconds() * mTargetDirection + getVelocity());
-		newVelocity *= getMaxSpeed();
-		float angle = std::atan2(newVelocity.y, newVelocity.x);
-
-		setRotation(toDegree(angle) + 90.f);
-		setVelocity(newVelocity);
+		if (isDeterministic())
+		{
+			// Heading from the steered velocity, speed along it from the tables; no float trigonometry or square root
+			FixedVector steered = FixedVector(mTargetDirection) * (Fixed::fromFloat(approachRate) * Fixed::fromTime(dt)) + FixedVector(getVelocity());
+			Fixed angle = fixedAtan2(steered.y, steered.x);
+
+			setRotation((angle + Fixed(90)).toFloat());
+			setVelocity((FixedVector(fixedCos(angle), fixedSin(angle)) * Fixed::fromFloat(getMaxSpeed())).toVector2f());
+		}
+		else
+		{
+			sf::Vector2f newVelocity = unitVector(approachRate * dt.asSeconds() * mTargetDirection + getVelocity());
+			newVelocity *= getMaxSpeed();
+			float angle = std::atan2(newVelocity.y, newVelocity.x);
+
+			setRotation(toDegree(angle) + 90.f);
+			setVelocity(newVelocity);
+		}
 	}
 
 	//Updates the firing animation if it shoots a tesla bullet - Dylan Reilly
@@ -97,12 +110,30 @@ void Projectile::drawCurrent(sf::RenderTarget& target, sf::RenderStates states)
 	}
 }
 
-//Modified for host projectile - Jason Lynch 
+// Back to how the constructor left it when NodePool reuses the projectile; the smoke emitters reset themselves
+void Projectile::resetCurrent()
+{
+	resetEntity(1);
+	mTargetDirection = sf::Vector2f();
+	mFiringAnimation.restart();
+}
+
+Projectile::Type Projectile::getType() const
+{
+	return mType;
+}
+
 unsigned int Projectile::getCategory() const
 {
-	if (mType == RedLmgBullet || mType == RedHmgBullet || mType == RedGatlingBullet || mType == RedTeslaBullet)
+	return getCategory(mType);
+}
+
+//Modified for host projectile - Jason Lynch 
+unsigned int Projectile::getCategory(Type type)
+{
+	if (type == RedLmgBullet || type == RedHmgBullet || type == RedGatlingBullet || type == RedTeslaBullet)
 		return Category::EnemyProjectile;
-	else if (mType == GreenLmgBullet || mType == GreenHmgBullet || mType == GreenGatlingBullet || mType == GreenTeslaBullet)
+	else if (type == GreenLmgBullet || type == GreenHmgBullet || type == GreenGatlingBullet || type == GreenTeslaBullet)
 		return Category::AlliedProjectile;
 	else
 		return Category::HostProjectile;
@@ -115,7 +146,12 @@ sf::FloatRect Projectile::getBoundingRect() const
 
 float Projectile::getMaxSpeed() const
 {
-	return Table[mType].speed;
+	return getMaxSpeed(mType);
+}
+
+float Projectile::getMaxSpeed(Type type)
+{
+	return Table[type].speed;
 }
 
 int Projectile::getDamage() const
@@ -39,14 +39,18 @@ class Projectile : public Entity
 		void					guideTowards(sf::Vector2f position);
 		bool					isGuided() const;
 
+		Type					getType() const;
 		virtual unsigned int	getCategory() const;
+		static unsigned int		getCategory(Type type);
 		virtual sf::FloatRect	getBoundingRect() const;
 		float					getMaxSpeed() const;
+		static float			getMaxSpeed(Type type);
 		int						getDamage() const;
 
 	
 	private:
 		virtual void			updateCurrent(sf::Time dt, CommandQueue& commands);
+		virtual void			resetCurrent();
 		virtual void			drawCurrent(sf::RenderTarget& target, sf::RenderStates states) const;
 
 
@@ -0,0 +1,368 @@
+//D00137655 - Jason Lynch
+//D00194504 - Dylan
+#include "ProjectileSystem.hpp"
+#include "DataTables.hpp"
+#include "ResourceHolder.hpp"
+#include "Utility.hpp"
+#include "FixedPoint.hpp"
+
+#include <SFML/Graphics/RenderTarget.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#define BOOK_PROJECTILESYSTEM_SSE
+	#include <xmmintrin.h>
+#endif
+
+
+namespace
+{
+	const std::vector<ProjectileData> Table = initializeProjectileData();
+
+	// position += velocity * dt, the same operations Entity::updateCurrent() does per node
+	void integrate(float* position, const float* velocity, std::size_t count, float dt)
+	{
+		std::size_t i = 0;
+#ifdef BOOK_PROJECTILESYSTEM_SSE
+		__m128 step = _mm_set1_ps(dt);
+		for (; i + 4 <= count; i += 4)
+			_mm_storeu_ps(position + i, _mm_add_ps(_mm_loadu_ps(position + i), _mm_mul_ps(_mm_loadu_ps(velocity + i), step)));
+#endif
+		for (; i < count; ++i)
+			position[i] += velocity[i] * dt;
+	}
+
+	// The same step in fixed point, for the deterministic mode
+	void integrateFixed(float* position, const float* velocity, std::size_t count, Fixed dt)
+	{
+		for (std::size_t i = 0; i < count; ++i)
+			position[i] = (Fixed::fromFloat(position[i]) + Fixed::fromFloat(velocity[i]) * dt).toFloat();
+	}
+
+	void computeBounds(const float* position, const float* lowOffset, const float* highOffset, float* low, float* high, std::size_t count)
+	{
+		std::size_t i = 0;
+#ifdef BOOK_PROJECTILESYSTEM_SSE
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 center = _mm_loadu_ps(position + i);
+			_mm_storeu_ps(low + i, _mm_add_ps(center, _mm_loadu_ps(lowOffset + i)));
+			_mm_storeu_ps(high + i, _mm_add_ps(center, _mm_loadu_ps(highOffset + i)));
+		}
+#endif
+		for (; i < count; ++i)
+		{
+			low[i] = position[i] + lowOffset[i];
+			high[i] = position[i] + highOffset[i];
+		}
+	}
+
+	// Clears the alive flag of every box that doesn't intersect the area (as sf::FloatRect::intersects() decides), returns how many
+	std::size_t cull(const float* left, const float* top, const float* right, const float* bottom, const sf::FloatRect& area, sf::Uint8* alive, std::size_t count)
+	{
+		float areaRight = area.left + area.width;
+		float areaBottom = area.top + area.height;
+		std::size_t culled = 0;
+
+		std::size_t i = 0;
+#ifdef BOOK_PROJECTILESYSTEM_SSE
+		__m128 minX = _mm_set1_ps(area.left);
+		__m128 minY = _mm_set1_ps(area.top);
+		__m128 maxX = _mm_set1_ps(areaRight);
+		__m128 maxY = _mm_set1_ps(areaBottom);
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 outside = _mm_or_ps(
+				_mm_or_ps(_mm_cmple_ps(_mm_loadu_ps(right + i), minX), _mm_cmpge_ps(_mm_loadu_ps(left + i), maxX)),
+				_mm_or_ps(_mm_cmple_ps(_mm_loadu_ps(bottom + i), minY), _mm_cmpge_ps(_mm_loadu_ps(top + i), maxY)));
+
+			int mask = _mm_movemask_ps(outside);
+			for (std::size_t lane = 0; mask != 0; ++lane, mask >>= 1)
+			{
+				if ((mask & 1) && alive[i + lane])
+				{
+					alive[i + lane] = 0;
+					++culled;
+				}
+			}
+		}
+#endif
+		for (; i < count; ++i)
+		{
+			bool outside = right[i] <= area.left || left[i] >= areaRight || bottom[i] <= area.top || top[i] >= areaBottom;
+			if (outside && alive[i])
+			{
+				alive[i] = 0;
+				++culled;
+			}
+		}
+
+		return culled;
+	}
+
+	// Drops the entries whose alive flag is clear, keeping the order of the rest
+	template <typename T>
+	void compact(std::vector<T>& values, const std::vector<sf::Uint8>& alive)
+	{
+		std::size_t kept = 0;
+		for (std::size_t i = 0; i < values.size(); ++i)
+		{
+			if (alive[i])
+				values[kept++] = values[i];
+		}
+
+		values.resize(kept);
+	}
+
+	// Corners of the bullet sprite as centerOrigin() leaves it, before rotation
+	void getLocalCorners(Projectile::Type type, sf::Vector2f corners[4])
+	{
+		const sf::IntRect& rect = Table[type].textureRect;
+		float width = static_cast<float>(rect.width);
+		float height = static_cast<float>(rect.height);
+		float originX = std::floor(width / 2.f);
+		float originY = std::floor(height / 2.f);
+
+		corners[0] = sf::Vector2f(-originX, -originY);
+		corners[1] = sf::Vector2f(width - originX, -originY);
+		corners[2] = sf::Vector2f(width - originX, height - originY);
+		corners[3] = sf::Vector2f(-originX, height - originY);
+	}
+}
+
+ProjectileSystem::ProjectileSystem(const TextureHolder& textures)
+: SceneNode()
+, mTexture(textures.get(Textures::Entities))
+, mCullBounds()
+, mDeadCount(0)
+, mDeterministic(false)
+, mVertexArray(sf::Quads)
+, mNeedsVertexUpdate(true)
+{
+}
+
+bool ProjectileSystem::handles(Projectile::Type type)
+{
+	switch (type)
+	{
+		case Projectile::GreenLmgBullet:
+		case Projectile::GreenGatlingBullet:
+		case Projectile::RedLmgBullet:
+		case Projectile::RedGatlingBullet:
+		case Projectile::HostLmgBullet:
+		case Projectile::HostGatlingBullet:
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+void ProjectileSystem::spawn(Projectile::Type type, sf::Int32 owner, sf::Vector2f position, sf::Vector2f velocity, float rotation)
+{
+	assert(handles(type) && Table[type].texture == Textures::Entities);
+
+	float cosine;
+	float sine;
+	if (mDeterministic)
+	{
+		cosine = fixedCos(Fixed::fromFloat(rotation)).toFloat();
+		sine = fixedSin(Fixed::fromFloat(rotation)).toFloat();
+	}
+	else
+	{
+		float radians = toRadian(rotation);
+		cosine = std::cos(radians);
+		sine = std::sin(radians);
+	}
+
+	sf::Vector2f corners[4];
+	getLocalCorners(type, corners);
+
+	sf::Vector2f low(std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+	sf::Vector2f high(-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max());
+	for (std::size_t i = 0; i < 4; ++i)
+	{
+		sf::Vector2f rotated(cosine * corners[i].x - sine * corners[i].y, sine * corners[i].x + cosine * corners[i].y);
+		low.x = std::min(low.x, rotated.x);
+		low.y = std::min(low.y, rotated.y);
+		high.x = std::max(high.x, rotated.x);
+		high.y = std::max(high.y, rotated.y);
+	}
+
+	mPositionX.push_back(position.x);
+	mPositionY.push_back(position.y);
+	mVelocityX.push_back(velocity.x);
+	mVelocityY.push_back(velocity.y);
+	mRotationCos.push_back(cosine);
+	mRotationSin.push_back(sine);
+	mLowOffsetX.push_back(low.x);
+	mLowOffsetY.push_back(low.y);
+	mHighOffsetX.push_back(high.x);
+	mHighOffsetY.push_back(high.y);
+
+	// Collisions run before the next update, so a bullet needs its box right away
+	mLeft.push_back(position.x + low.x);
+	mTop.push_back(position.y + low.y);
+	mRight.push_back(position.x + high.x);
+	mBottom.push_back(position.y + high.y);
+
+	mType.push_back(static_cast<sf::Uint8>(type));
+	mOwner.push_back(owner);
+	mAlive.push_back(1);
+
+	mNeedsVertexUpdate = true;
+}
+
+void ProjectileSystem::kill(std::size_t index)
+{
+	if (mAlive[index])
+	{
+		mAlive[index] = 0;
+		++mDeadCount;
+	}
+}
+
+void ProjectileSystem::setCullBounds(const sf::FloatRect& bounds)
+{
+	mCullBounds = bounds;
+}
+
+void ProjectileSystem::setDeterministic(bool deterministic)
+{
+	mDeterministic = deterministic;
+}
+
+std::size_t ProjectileSystem::getCount() const
+{
+	return mAlive.size();
+}
+
+bool ProjectileSystem::isAlive(std::size_t index) const
+{
+	return mAlive[index] != 0;
+}
+
+sf::FloatRect ProjectileSystem::getBulletBounds(std::size_t index) const
+{
+	return sf::FloatRect(mLeft[index], mTop[index], mRight[index] - mLeft[index], mBottom[index] - mTop[index]);
+}
+
+unsigned int ProjectileSystem::getBulletCategory(std::size_t index) const
+{
+	return Projectile::getCategory(static_cast<Projectile::Type>(mType[index]));
+}
+
+int ProjectileSystem::getBulletDamage(std::size_t index) const
+{
+	return Table[mType[index]].damage;
+}
+
+sf::Int32 ProjectileSystem::getBulletOwner(std::size_t index) const
+{
+	return mOwner[index];
+}
+
+void ProjectileSystem::updateCurrent(sf::Time dt, CommandQueue&)
+{
+	// Bullets killed by collisions since the last update
+	removeDead();
+
+	std::size_t count = getCount();
+	float seconds = dt.asSeconds();
+
+	if (mDeterministic)
+	{
+		integrateFixed(mPositionX.data(), mVelocityX.data(), count, Fixed::fromTime(dt));
+		integrateFixed(mPositionY.data(), mVelocityY.data(), count, Fixed::fromTime(dt));
+	}
+	else
+	{
+		integrate(mPositionX.data(), mVelocityX.data(), count, seconds);
+		integrate(mPositionY.data(), mVelocityY.data(), count, seconds);
+	}
+
+	computeBounds(mPositionX.data(), mLowOffsetX.data(), mHighOffsetX.data(), mLeft.data(), mRight.data(), count);
+	computeBounds(mPositionY.data(), mLowOffsetY.data(), mHighOffsetY.data(), mTop.data(), mBottom.data(), count);
+
+	mDeadCount += cull(mLeft.data(), mTop.data(), mRight.data(), mBottom.data(), mCullBounds, mAlive.data(), count);
+	removeDead();
+
+	mNeedsVertexUpdate = true;
+}
+
+void ProjectileSystem::removeDead()
+{
+	if (mDeadCount == 0)
+		return;
+
+	compact(mPositionX, mAlive);
+	compact(mPositionY, mAlive);
+	compact(mVelocityX, mAlive);
+	compact(mVelocityY, mAlive);
+	compact(mRotationCos, mAlive);
+	compact(mRotationSin, mAlive);
+	compact(mLowOffsetX, mAlive);
+	compact(mLowOffsetY, mAlive);
+	compact(mHighOffsetX, mAlive);
+	compact(mHighOffsetY, mAlive);
+	compact(mLeft, mAlive);
+	compact(mTop, mAlive);
+	compact(mRight, mAlive);
+	compact(mBottom, mAlive);
+	compact(mType, mAlive);
+	compact(mOwner, mAlive);
+	// Last, every other array reads the flags
+	compact(mAlive, mAlive);
+
+	mDeadCount = 0;
+	mNeedsVertexUpdate = true;
+}
+
+void ProjectileSystem::drawCurrent(sf::RenderTarget& target, sf::RenderStates states) const
+{
+	if (mNeedsVertexUpdate)
+	{
+		computeVertices();
+		mNeedsVertexUpdate = false;
+	}
+
+	states.texture = &mTexture;
+	target.draw(mVertexArray, states);
+}
+
+void ProjectileSystem::computeVertices() const
+{
+	// Resizing within the capacity of earlier frames doesn't allocate
+	mVertexArray.resize(getCount() * 4);
+
+	for (std::size_t i = 0; i < getCount(); ++i)
+	{
+		Projectile::Type type = static_cast<Projectile::Type>(mType[i]);
+		const sf::IntRect& rect = Table[type].textureRect;
+
+		sf::Vector2f corners[4];
+		getLocalCorners(type, corners);
+
+		sf::Vector2f texCoords[4] =
+		{
+			sf::Vector2f(static_cast<float>(rect.left), static_cast<float>(rect.top)),
+			sf::Vector2f(static_cast<float>(rect.left + rect.width), static_cast<float>(rect.top)),
+			sf::Vector2f(static_cast<float>(rect.left + rect.width), static_cast<float>(rect.top + rect.height)),
+			sf::Vector2f(static_cast<float>(rect.left), static_cast<float>(rect.top + rect.height))
+		};
+
+		for (std::size_t corner = 0; corner < 4; ++corner)
+		{
+			sf::Vertex& vertex = mVertexArray[i * 4 + corner];
+			vertex.position.x = mPositionX[i] + mRotationCos[i] * corners[corner].x - mRotationSin[i] * corners[corner].y;
+			vertex.position.y = mPositionY[i] + mRotationSin[i] * corners[corner].x + mRotationCos[i] * corners[corner].y;
+			vertex.texCoords = texCoords[corner];
+			vertex.color = sf::Color::White;
+		}
+	}
+}
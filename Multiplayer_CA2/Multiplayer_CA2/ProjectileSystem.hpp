@@ -0,0 +1,79 @@
+#ifndef BOOK_PROJECTILESYSTEM_HPP
+#define BOOK_PROJECTILESYSTEM_HPP
+
+#include "SceneNode.hpp"
+#include "ResourceIdentifiers.hpp"
+#include "Projectile.hpp"
+
+#include <SFML/Config.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/Graphics/VertexArray.hpp>
+
+#include <vector>
+
+
+// Plain bullets (no smoke, animation or guidance) as one scene node that stores them in parallel arrays.
+// Moving, culling against the battlefield and updating bounding boxes run over whole arrays at a time
+// (SSE where the compiler targets it, scalar otherwise) and all bullets are drawn with a single vertex array.
+// Bullets have no scene node of their own; World collides them through their index.
+class ProjectileSystem : public SceneNode
+{
+	public:
+		explicit				ProjectileSystem(const TextureHolder& textures);
+
+		// Types with extra child nodes or behaviour stay Projectile nodes
+		static bool				handles(Projectile::Type type);
+
+		void					spawn(Projectile::Type type, sf::Int32 owner, sf::Vector2f position, sf::Vector2f velocity, float rotation);
+		void					kill(std::size_t index);
+		// Bullets whose bounding box leaves this area are removed
+		void					setCullBounds(const sf::FloatRect& bounds);
+		// Fixed point motion and rotation for bullets spawned from now on, see World::setDeterministic()
+		void					setDeterministic(bool deterministic);
+
+		std::size_t				getCount() const;
+		bool					isAlive(std::size_t index) const;
+		sf::FloatRect			getBulletBounds(std::size_t index) const;
+		unsigned int			getBulletCategory(std::size_t index) const;
+		int						getBulletDamage(std::size_t index) const;
+		sf::Int32				getBulletOwner(std::size_t index) const;
+
+
+	private:
+		virtual void			updateCurrent(sf::Time dt, CommandQueue& commands);
+		virtual void			drawCurrent(sf::RenderTarget& target, sf::RenderStates states) const;
+
+		void					removeDead();
+		void					computeVertices() const;
+
+
+	private:
+		const sf::Texture&		mTexture;
+		sf::FloatRect			mCullBounds;
+
+		// One entry per bullet in each array, removal keeps the spawn order
+		std::vector<float>		mPositionX;
+		std::vector<float>		mPositionY;
+		std::vector<float>		mVelocityX;
+		std::vector<float>		mVelocityY;
+		std::vector<float>		mRotationCos;
+		std::vector<float>		mRotationSin;
+		std::vector<float>		mLowOffsetX;		// Bounding box relative to the position, fixed as bullets don't turn
+		std::vector<float>		mLowOffsetY;
+		std::vector<float>		mHighOffsetX;
+		std::vector<float>		mHighOffsetY;
+		std::vector<float>		mLeft;
+		std::vector<float>		mTop;
+		std::vector<float>		mRight;
+		std::vector<float>		mBottom;
+		std::vector<sf::Uint8>	mType;
+		std::vector<sf::Int32>	mOwner;
+		std::vector<sf::Uint8>	mAlive;
+		std::size_t				mDeadCount;
+		bool					mDeterministic;
+
+		mutable sf::VertexArray	mVertexArray;
+		mutable bool			mNeedsVertexUpdate;
+};
+
+#endif // BOOK_PROJECTILESYSTEM_HPP
@@ -0,0 +1,69 @@
+//D00137655 - Jason Lynch
+//D00194504 - Dylan
+#include "RandomEngine.hpp"
+
+
+namespace
+{
+	// splitmix64, spreads any seed (including 0) over the whole state
+	sf::Uint64 splitMix(sf::Uint64& state)
+	{
+		sf::Uint64 z = (state += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		return z ^ (z >> 31);
+	}
+
+	sf::Uint32 rotateLeft(sf::Uint32 value, int bits)
+	{
+		return (value << bits) | (value >> (32 - bits));
+	}
+}
+
+RandomEngine::RandomEngine(sf::Uint64 seed)
+{
+	this->seed(seed);
+}
+
+void RandomEngine::seed(sf::Uint64 seed)
+{
+	sf::Uint64 first = splitMix(seed);
+	sf::Uint64 second = splitMix(seed);
+
+	mState[0] = static_cast<sf::Uint32>(first);
+	mState[1] = static_cast<sf::Uint32>(first >> 32);
+	mState[2] = static_cast<sf::Uint32>(second);
+	mState[3] = static_cast<sf::Uint32>(second >> 32);
+}
+
+sf::Uint32 RandomEngine::next()
+{
+	const sf::Uint32 result = rotateLeft(mState[1] * 5, 7) * 9;
+	const sf::Uint32 t = mState[1] << 9;
+
+	mState[2] ^= mState[0];
+	mState[3] ^= mState[1];
+	mState[1] ^= mState[2];
+	mState[0] ^= mState[3];
+	mState[2] ^= t;
+	mState[3] = rotateLeft(mState[3], 11);
+
+	return result;
+}
+
+int RandomEngine::nextInt(int exclusiveMax)
+{
+	// Multiply-shift range reduction, avoids the modulo and its bias towards low values
+	return static_cast<int>((static_cast<sf::Uint64>(next()) * static_cast<sf::Uint32>(exclusiveMax)) >> 32);
+}
+
+float RandomEngine::nextFloat()
+{
+	return (next() >> 8) * (1.f / 16777216.f);
+}
+
+sf::Uint64 mixSeed(sf::Uint64 seed, sf::Uint64 value)
+{
+	sf::Uint64 state = seed ^ (value * 0xD1B54A32D192ED03ULL);
+	return splitMix(state);
+}
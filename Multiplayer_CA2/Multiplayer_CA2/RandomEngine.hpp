@@ -0,0 +1,39 @@
+#ifndef BOOK_RANDOMENGINE_HPP
+#define BOOK_RANDOMENGINE_HPP
+
+#include <SFML/Config.hpp>
+
+
+// xoshiro128** generator. Small and cheap to seed, so every world, thread or tank can own
+// an independent stream that replays identically from the same seed.
+class RandomEngine
+{
+	public:
+		typedef sf::Uint32		result_type;
+
+
+	public:
+		explicit				RandomEngine(sf::Uint64 seed = 0);
+
+		void					seed(sf::Uint64 seed);
+		sf::Uint32				next();
+
+		// Uniform in [0, exclusiveMax)
+		int						nextInt(int exclusiveMax);
+		// Uniform in [0, 1)
+		float					nextFloat();
+
+		// Standard UniformRandomBitGenerator interface, for <random> distributions
+		static result_type		min() { return 0; }
+		static result_type		max() { return 0xFFFFFFFF; }
+		result_type				operator()() { return next(); }
+
+
+	private:
+		sf::Uint32				mState[4];
+};
+
+// Derives an independent seed from a parent seed and a discriminator (tank identifier, shot index...)
+sf::Uint64					mixSeed(sf::Uint64 seed, sf::Uint64 value);
+
+#endif // BOOK_RANDOMENGINE_HPP
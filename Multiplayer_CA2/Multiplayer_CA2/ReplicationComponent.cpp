@@ -0,0 +1,74 @@
+//D00137655 - Jason Lynch
+//D00194504 - Dylan
+#include "ReplicationComponent.hpp"
+
+
+ReplicationComponent::ReplicationComponent()
+: mIdentifier(0)
+, mDirtyFields(0)
+{
+}
+
+void ReplicationComponent::setIdentifier(sf::Int32 identifier)
+{
+	mIdentifier = identifier;
+}
+
+sf::Int32 ReplicationComponent::getIdentifier() const
+{
+	return mIdentifier;
+}
+
+bool ReplicationComponent::isReplicated() const
+{
+	return mIdentifier != 0;
+}
+
+void ReplicationComponent::markDirty(unsigned int fields)
+{
+	if (isReplicated())
+		mDirtyFields |= fields;
+}
+
+unsigned int ReplicationComponent::getDirtyFields() const
+{
+	return mDirtyFields;
+}
+
+void ReplicationComponent::clearDirtyFields()
+{
+	mDirtyFields = 0;
+}
+
+ReplicatedState::ReplicatedState()
+: identifier(0)
+, fields(0)
+, hitpoints(0)
+, position()
+{
+}
+
+// format: [Int32:identifier] [Uint8:fields] [Int32:hitpoints]? [float:x float:y]?
+sf::Packet& operator <<(sf::Packet& packet, const ReplicatedState& state)
+{
+	packet << state.identifier << state.fields;
+
+	if (state.fields & ReplicationComponent::Hitpoints)
+		packet << state.hitpoints;
+	if (state.fields & ReplicationComponent::Position)
+		packet << state.position.x << state.position.y;
+
+	return packet;
+}
+
+sf::Packet& operator >>(sf::Packet& packet, ReplicatedState& state)
+{
+	packet >> state.identifier >> state.fields;
+
+	if (state.fields & ReplicationComponent::Hitpoints)
+		packet >> state.hitpoints;
+	if (state.fields & ReplicationComponent::Position)
+		packet >> state.position.x >> state.position.y;
+
+	return packet;
+}
@@ -0,0 +1,55 @@
+#ifndef BOOK_REPLICATIONCOMPONENT_HPP
+#define BOOK_REPLICATIONCOMPONENT_HPP
+
+#include <SFML/Config.hpp>
+#include <SFML/System/Vector2.hpp>
+#include <SFML/Network/Packet.hpp>
+
+
+// Network identity of an entity plus dirty bits for the fields changed since they were last collected.
+// Entities with identifier 0 (tanks, projectiles) are not replicated and ignore markDirty().
+class ReplicationComponent
+{
+	public:
+		enum Field
+		{
+			Hitpoints	= 1 << 0,
+			Destroyed	= 1 << 1,
+			Position	= 1 << 2,
+			FieldCount	= 3,
+			AllFields	= Hitpoints | Destroyed | Position
+		};
+
+
+	public:
+							ReplicationComponent();
+
+		void				setIdentifier(sf::Int32 identifier);
+		sf::Int32			getIdentifier() const;
+		bool				isReplicated() const;
+
+		void				markDirty(unsigned int fields);
+		unsigned int		getDirtyFields() const;
+		void				clearDirtyFields();
+
+
+	private:
+		sf::Int32			mIdentifier;
+		unsigned int		mDirtyFields;
+};
+
+// The changed fields of one entity as sent over the network. Only the fields set in 'fields' are serialized.
+struct ReplicatedState
+{
+						ReplicatedState();
+
+	sf::Int32			identifier;
+	sf::Uint8			fields;
+	sf::Int32			hitpoints;
+	sf::Vector2f		position;
+};
+
+sf::Packet&				operator <<(sf::Packet& packet, const ReplicatedState& state);
+sf::Packet&				operator >>(sf::Packet& packet, ReplicatedState& state);
+
+#endif // BOOK_REPLICATIONCOMPONENT_HPP
@@ -1,7 +1,8 @@
 //D00137655 - Jason Lynch
 //D00194504 - Dylan
 #include "SceneNode.hpp"
-#include "Command.hpp"
+#include "CategoryIndex.hpp"
+#include "NodePool.hpp"
 #include "Foreach.hpp"
 #include "Utility.hpp"
 
@@ -11,18 +12,36 @@
 #include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <functional>
 
 
 SceneNode::SceneNode(Category::Type category)
 : mChildren()
 , mParent(nullptr)
 , mDefaultCategory(category)
+, mWorldTransform()
+, mWorldTransformDirty(true)
+, mCategoryIndex(nullptr)
+, mIndexList(CategoryIndex::ListCount)
+, mIndexPrev(nullptr)
+, mIndexNext(nullptr)
+, mRecycler(nullptr)
 {
 }
 
+SceneNode::~SceneNode()
+{
+	// Children are destroyed right after and unlink themselves the same way
+	if (mCategoryIndex)
+		mCategoryIndex->remove(*this);
+}
+
 void SceneNode::attachChild(Ptr child)
 {
 	child->mParent = this;
+	child->invalidateWorldTransform();
+	if (mCategoryIndex)
+		child->joinCategoryIndex(*mCategoryIndex);
 	mChildren.push_back(std::move(child));
 }
 
@@ -33,6 +52,8 @@ SceneNode::Ptr SceneNode::detachChild(const SceneNode& node)
 
 	Ptr result = std::move(*found);
 	result->mParent = nullptr;
+	result->invalidateWorldTransform();
+	result->leaveCategoryIndex();
 	mChildren.erase(found);
 	return result;
 }
@@ -43,6 +64,24 @@ void SceneNode::update(sf::Time dt, CommandQueue& commands)
 	updateChildren(dt, commands);
 }
 
+void SceneNode::updateDeferring(sf::Time dt, CommandQueue& commands, unsigned int deferredMask, std::vector<SceneNode*>& deferred)
+{
+	updateCurrent(dt, commands);
+
+	FOREACH(Ptr& child, mChildren)
+	{
+		if (child->getCategory() & deferredMask)
+		{
+			getWorldTransform();
+			deferred.push_back(child.get());
+		}
+		else
+		{
+			child->updateDeferring(dt, commands, deferredMask, deferred);
+		}
+	}
+}
+
 void SceneNode::updateCurrent(sf::Time, CommandQueue&)
 {
 	// Do nothing by default
@@ -97,47 +136,183 @@ sf::Vector2f SceneNode::getWorldPosition() const
 	return getWorldTransform() * sf::Vector2f();
 }
 
-sf::Transform SceneNode::getWorldTransform() const
+const sf::Transform& SceneNode::getWorldTransform() const
+{
+	// Bounding rects, particle emission and sounds ask for this many times a frame, so it is only
+	// recomputed after this node or one of its ancestors has moved
+	if (mWorldTransformDirty)
+	{
+		mWorldTransform = mParent ? mParent->getWorldTransform() * getTransform() : getTransform();
+		mWorldTransformDirty = false;
+	}
+
+	return mWorldTransform;
+}
+
+void SceneNode::setPosition(float x, float y)
+{
+	sf::Transformable::setPosition(x, y);
+	invalidateWorldTransform();
+}
+
+void SceneNode::setPosition(const sf::Vector2f& position)
+{
+	sf::Transformable::setPosition(position);
+	invalidateWorldTransform();
+}
+
+void SceneNode::setRotation(float angle)
+{
+	sf::Transformable::setRotation(angle);
+	invalidateWorldTransform();
+}
+
+void SceneNode::setScale(float factorX, float factorY)
 {
-	sf::Transform transform = sf::Transform::Identity;
+	sf::Transformable::setScale(factorX, factorY);
+	invalidateWorldTransform();
+}
 
-	for (const SceneNode* node = this; node != nullptr; node = node->mParent)
-		transform = node->getTransform() * transform;
+void SceneNode::setScale(const sf::Vector2f& factors)
+{
+	sf::Transformable::setScale(factors);
+	invalidateWorldTransform();
+}
 
-	return transform;
+void SceneNode::setOrigin(float x, float y)
+{
+	sf::Transformable::setOrigin(x, y);
+	invalidateWorldTransform();
 }
 
-void SceneNode::onCommand(const Command& command, sf::Time dt)
+void SceneNode::setOrigin(const sf::Vector2f& origin)
 {
-	// Command current node, if category matches
-	if (command.category & getCategory())
-		command.action(*this, dt);
+	sf::Transformable::setOrigin(origin);
+	invalidateWorldTransform();
+}
+
+void SceneNode::move(float offsetX, float offsetY)
+{
+	sf::Transformable::move(offsetX, offsetY);
+	invalidateWorldTransform();
+}
+
+void SceneNode::move(const sf::Vector2f& offset)
+{
+	sf::Transformable::move(offset);
+	invalidateWorldTransform();
+}
+
+void SceneNode::rotate(float angle)
+{
+	sf::Transformable::rotate(angle);
+	invalidateWorldTransform();
+}
+
+void SceneNode::scale(float factorX, float factorY)
+{
+	sf::Transformable::scale(factorX, factorY);
+	invalidateWorldTransform();
+}
+
+void SceneNode::scale(const sf::Vector2f& factor)
+{
+	sf::Transformable::scale(factor);
+	invalidateWorldTransform();
+}
+
+void SceneNode::joinCategoryIndex(CategoryIndex& index)
+{
+	index.insert(*this);
 
-	// Command children
 	FOREACH(Ptr& child, mChildren)
-		child->onCommand(command, dt);
+		child->joinCategoryIndex(index);
 }
 
-unsigned int SceneNode::getCategory() const
+void SceneNode::leaveCategoryIndex()
 {
-	return mDefaultCategory;
+	if (mCategoryIndex)
+		mCategoryIndex->remove(*this);
+
+	FOREACH(Ptr& child, mChildren)
+		child->leaveCategoryIndex();
 }
 
-void SceneNode::checkSceneCollision(SceneNode& sceneGraph, std::set<Pair>& collisionPairs)
+void SceneNode::reset()
 {
-	checkNodeCollision(sceneGraph, collisionPairs);
+	// Children keep their transforms, they are placed relative to this node once in its constructor
+	static_cast<sf::Transformable&>(*this) = sf::Transformable();
+	invalidateWorldTransform();
 
-	FOREACH(Ptr& child, sceneGraph.mChildren)
-		checkSceneCollision(*child, collisionPairs);
+	resetCurrent();
+	resetChildren();
 }
 
-void SceneNode::checkNodeCollision(SceneNode& node, std::set<Pair>& collisionPairs)
+void SceneNode::resetCurrent()
 {
-	if (this != &node && collision(*this, node) && !isDestroyed() && !node.isDestroyed())
-		collisionPairs.insert(std::minmax(this, &node));
+	// Do nothing by default
+}
 
+void SceneNode::resetChildren()
+{
 	FOREACH(Ptr& child, mChildren)
-		child->checkNodeCollision(node, collisionPairs);
+	{
+		child->resetCurrent();
+		child->resetChildren();
+	}
+}
+
+void SceneNode::recycleCurrent()
+{
+	// Do nothing by default
+}
+
+void SceneNode::recycleChildren()
+{
+	FOREACH(Ptr& child, mChildren)
+	{
+		child->recycleCurrent();
+		child->recycleChildren();
+	}
+}
+
+void SceneNode::prepareForReuse()
+{
+	leaveCategoryIndex();
+	recycleCurrent();
+	recycleChildren();
+	mParent = nullptr;
+}
+
+void SceneNode::invalidateWorldTransform()
+{
+	// A dirty node already has a dirty subtree, which keeps repeated moves in one frame cheap
+	if (mWorldTransformDirty)
+		return;
+
+	mWorldTransformDirty = true;
+	FOREACH(Ptr& child, mChildren)
+		child->invalidateWorldTransform();
+}
+
+unsigned int SceneNode::getCategory() const
+{
+	return mDefaultCategory;
+}
+
+void SceneNode::collectNodes(unsigned int categoryMask, std::vector<SceneNode*>& nodes)
+{
+	if (getCategory() & categoryMask && !isDestroyed())
+	{
+		// Cached now, so the nodes' bounding rects can be computed concurrently without racing on a shared parent
+		if (mParent)
+			mParent->getWorldTransform();
+
+		nodes.push_back(this);
+	}
+
+	FOREACH(Ptr& child, mChildren)
+		child->collectNodes(categoryMask, nodes);
 }
 
 void SceneNode::removeWrecks()
@@ -167,6 +342,23 @@ bool SceneNode::isDestroyed() const
 	return false;
 }
 
+SceneNode::Deleter::Deleter()
+{
+}
+
+void SceneNode::Deleter::operator() (SceneNode* node) const
+{
+	if (node->mRecycler)
+	{
+		node->prepareForReuse();
+		node->mRecycler->recycle(*node);
+	}
+	else
+	{
+		delete node;
+	}
+}
+
 bool collision(const SceneNode& lhs, const SceneNode& rhs)
 {
 	return lhs.getBoundingRect().intersects(rhs.getBoundingRect());
@@ -9,43 +9,84 @@
 #include <SFML/Graphics/Drawable.hpp>
 
 #include <vector>
-#include <set>
 #include <memory>
 #include <utility>
 
 
 struct Command;
 class CommandQueue;
+class CategoryIndex;
+class NodeRecycler;
 
 class SceneNode : public sf::Transformable, public sf::Drawable, private sf::NonCopyable
 {
 	public:
-		typedef std::unique_ptr<SceneNode> Ptr;
+		// Deletes the node, or hands it back to its NodePool if it came from one
+		struct Deleter
+		{
+								Deleter();
+								template <typename Node>
+								Deleter(const std::default_delete<Node>&);
+
+			void				operator() (SceneNode* node) const;
+		};
+
+		typedef std::unique_ptr<SceneNode, Deleter> Ptr;
 		typedef std::pair<SceneNode*, SceneNode*> Pair;
 
 
 	public:
 		explicit				SceneNode(Category::Type category = Category::None);
+		virtual					~SceneNode();
 
 		void					attachChild(Ptr child);
 		Ptr						detachChild(const SceneNode& node);
 		
 		void					update(sf::Time dt, CommandQueue& commands);
+		// Like update(), but nodes whose category is in the mask are appended to deferred, subtree and all, for the
+		// caller to update later; their ancestors' world transforms are cached first, so the deferred nodes can be
+		// updated concurrently with each other
+		void					updateDeferring(sf::Time dt, CommandQueue& commands, unsigned int deferredMask, std::vector<SceneNode*>& deferred);
 
 		sf::Vector2f			getWorldPosition() const;
-		sf::Transform			getWorldTransform() const;
+		const sf::Transform&	getWorldTransform() const;
+
+		// Hide sf::Transformable's setters, so any change invalidates the cached world transform of this subtree
+		void					setPosition(float x, float y);
+		void					setPosition(const sf::Vector2f& position);
+		void					setRotation(float angle);
+		void					setScale(float factorX, float factorY);
+		void					setScale(const sf::Vector2f& factors);
+		void					setOrigin(float x, float y);
+		void					setOrigin(const sf::Vector2f& origin);
+		void					move(float offsetX, float offsetY);
+		void					move(const sf::Vector2f& offset);
+		void					rotate(float angle);
+		void					scale(float factorX, float factorY);
+		void					scale(const sf::Vector2f& factor);
 
-		void					onCommand(const Command& command, sf::Time dt);
 		virtual unsigned int	getCategory() const;
+		// Makes this node and everything attached below it, now or later, part of the index
+		void					joinCategoryIndex(CategoryIndex& index);
+
+		// Puts a recycled node back the way its constructor left it; this node's own transform becomes identity
+		void					reset();
 
-		void					checkSceneCollision(SceneNode& sceneGraph, std::set<Pair>& collisionPairs);
-		void					checkNodeCollision(SceneNode& node, std::set<Pair>& collisionPairs);
+		// Appends this node and its descendants whose category is in the mask and which are not destroyed
+		void					collectNodes(unsigned int categoryMask, std::vector<SceneNode*>& nodes);
 		void					removeWrecks();
 		virtual sf::FloatRect	getBoundingRect() const;
 		virtual bool			isMarkedForRemoval() const;
 		virtual bool			isDestroyed() const;
 
 
+	protected:
+		// Reset hook of pooled nodes and their children, called on every node of the subtree
+		virtual void			resetCurrent();
+		// Counterpart called on every node of the subtree when it goes back to its pool, before it waits for reuse
+		virtual void			recycleCurrent();
+
+
 	private:
 		virtual void			updateCurrent(sf::Time dt, CommandQueue& commands);
 		void					updateChildren(sf::Time dt, CommandQueue& commands);
@@ -54,14 +95,39 @@ class SceneNode : public sf::Transformable, public sf::Drawable, private sf::Non
 		virtual void			drawCurrent(sf::RenderTarget& target, sf::RenderStates states) const;
 		void					drawChildren(sf::RenderTarget& target, sf::RenderStates states) const;
 		void					drawBoundingRect(sf::RenderTarget& target, sf::RenderStates states) const;
+		void					invalidateWorldTransform();
+		void					leaveCategoryIndex();
+		void					resetChildren();
+		void					recycleChildren();
+		void					prepareForReuse();
 
 
 	private:
 		std::vector<Ptr>		mChildren;
 		SceneNode*				mParent;
 		Category::Type			mDefaultCategory;
+
+		mutable sf::Transform	mWorldTransform;
+		mutable bool			mWorldTransformDirty;	// Whenever set, it is set on every descendant as well
+
+		// Intrusive links, maintained by CategoryIndex
+		CategoryIndex*			mCategoryIndex;
+		std::size_t				mIndexList;
+		SceneNode*				mIndexPrev;
+		SceneNode*				mIndexNext;
+
+		NodeRecycler*			mRecycler;				// The pool the node returns to, nullptr for plain nodes
+
+		friend class CategoryIndex;
+		template <typename Node>
+		friend class NodePool;
 };
 
+template <typename Node>
+SceneNode::Deleter::Deleter(const std::default_delete<Node>&)
+{
+}
+
 bool	collision(const SceneNode& lhs, const SceneNode& rhs);
 float	distance(const SceneNode& lhs, const SceneNode& rhs);
 
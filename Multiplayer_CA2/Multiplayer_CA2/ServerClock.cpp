@@ -0,0 +1,144 @@
+//D00137655 - Jason Lynch
+//D00194504 - Dylan
+#include "ServerClock.hpp"
+#include "NetworkProtocol.hpp"
+#include "Foreach.hpp"
+
+#include <algorithm>
+
+
+namespace
+{
+	// Ping quickly until the first few samples are in, then settle to a slow refresh
+	const std::size_t	FastSampleCount = 4;
+	const sf::Int64		FastPingIntervalUs = 200000;
+	const sf::Int64		PingIntervalUs = 1000000;
+
+	const std::size_t	SampleWindow = 8;
+}
+
+ServerClock::ServerClock()
+: mClock()
+, mPingSequence(0)
+, mLastPongSequence(0)
+, mLastPingTimeUs(0)
+, mSampleCount(0)
+, mSamples()
+, mOffsetUs(0)
+, mRttUs(0)
+, mLastServerTimeUs(0)
+, mHasTick(false)
+, mLastTick(0)
+, mLastTickTimeUs(0)
+{
+}
+
+bool ServerClock::shouldSendPing() const
+{
+	if (mPingSequence == 0)
+		return true;
+
+	sf::Int64 interval = (mSampleCount < FastSampleCount) ? FastPingIntervalUs : PingIntervalUs;
+	return localTimeUs() >= mLastPingTimeUs + interval;
+}
+
+void ServerClock::writePing(sf::Packet& packet)
+{
+	mLastPingTimeUs = localTimeUs();
+	packet << static_cast<sf::Int32>(Client::ClockPing) << ++mPingSequence << mLastPingTimeUs;
+}
+
+void ServerClock::handlePong(sf::Packet& packet)
+{
+	sf::Uint32 sequence;
+	sf::Int64 clientSendUs, serverReceiveUs, serverSendUs;
+	packet >> sequence >> clientSendUs >> serverReceiveUs >> serverSendUs;
+	sf::Int64 clientReceiveUs = localTimeUs();
+
+	// Duplicates and pongs overtaken by a newer one carry nothing new
+	if (sequence <= mLastPongSequence)
+		return;
+	mLastPongSequence = sequence;
+
+	Sample sample;
+	sample.rttUs = (clientReceiveUs - clientSendUs) - (serverSendUs - serverReceiveUs);
+	sample.offsetUs = ((serverReceiveUs - clientSendUs) + (serverSendUs - clientReceiveUs)) / 2;
+	if (sample.rttUs < 0)
+		return;
+
+	mSamples.push_back(sample);
+	if (mSamples.size() > SampleWindow)
+		mSamples.pop_front();
+
+	// The lowest RTT sample has the least room for asymmetric queueing delay, so its offset is the most trustworthy
+	const Sample* best = &mSamples.front();
+	FOREACH(const Sample& candidate, mSamples)
+	{
+		if (candidate.rttUs < best->rttUs)
+			best = &candidate;
+	}
+
+	if (mSampleCount == 0)
+	{
+		mOffsetUs = best->offsetUs;
+		mRttUs = sample.rttUs;
+	}
+	else
+	{
+		mOffsetUs += (best->offsetUs - mOffsetUs) / 4;
+		mRttUs += (sample.rttUs - mRttUs) / 8;
+	}
+
+	++mSampleCount;
+}
+
+void ServerClock::observeTick(sf::Uint32 tick)
+{
+	if (mHasTick && tick <= mLastTick)
+		return;
+
+	mHasTick = true;
+	mLastTick = tick;
+	mLastTickTimeUs = localTimeUs();
+}
+
+bool ServerClock::isSynchronized() const
+{
+	return mSampleCount > 0;
+}
+
+sf::Time ServerClock::getServerTime() const
+{
+	mLastServerTimeUs = std::max(mLastServerTimeUs, localTimeUs() + mOffsetUs);
+	return sf::microseconds(mLastServerTimeUs);
+}
+
+sf::Time ServerClock::getOffset() const
+{
+	return sf::microseconds(mOffsetUs);
+}
+
+sf::Time ServerClock::getRoundTripTime() const
+{
+	return sf::microseconds(mRttUs);
+}
+
+sf::Uint32 ServerClock::getLastServerTick() const
+{
+	return mLastTick;
+}
+
+float ServerClock::getEstimatedServerTick() const
+{
+	if (!mHasTick)
+		return 0.f;
+
+	// The stamped tick is already half a round trip old when it arrives
+	sf::Int64 elapsedUs = localTimeUs() - mLastTickTimeUs + mRttUs / 2;
+	return static_cast<float>(mLastTick) + static_cast<float>(elapsedUs) * ServerTickRate / 1000000.f;
+}
+
+sf::Int64 ServerClock::localTimeUs() const
+{
+	return mClock.getElapsedTime().asMicroseconds();
+}
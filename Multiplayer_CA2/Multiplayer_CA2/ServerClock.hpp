@@ -0,0 +1,60 @@
+#ifndef BOOK_SERVERCLOCK_HPP
+#define BOOK_SERVERCLOCK_HPP
+
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/Time.hpp>
+#include <SFML/Network/Packet.hpp>
+
+#include <deque>
+
+
+// Client side estimate of the server clock. Offset and RTT come from NTP style ping/pong exchanges,
+// the server tick is extrapolated from the tick stamped on every server packet.
+class ServerClock
+{
+	public:
+								ServerClock();
+
+		bool					shouldSendPing() const;
+		void					writePing(sf::Packet& packet);
+		void					handlePong(sf::Packet& packet);
+		void					observeTick(sf::Uint32 tick);
+
+		bool					isSynchronized() const;
+		sf::Time				getServerTime() const;
+		sf::Time				getOffset() const;
+		sf::Time				getRoundTripTime() const;
+		sf::Uint32				getLastServerTick() const;
+		float					getEstimatedServerTick() const;
+
+
+	private:
+		struct Sample
+		{
+			sf::Int64			offsetUs;
+			sf::Int64			rttUs;
+		};
+
+
+	private:
+		sf::Int64				localTimeUs() const;
+
+
+	private:
+		sf::Clock				mClock;
+		sf::Uint32				mPingSequence;
+		sf::Uint32				mLastPongSequence;
+		sf::Int64				mLastPingTimeUs;
+		std::size_t				mSampleCount;
+		std::deque<Sample>		mSamples;
+
+		sf::Int64				mOffsetUs;
+		sf::Int64				mRttUs;
+		mutable sf::Int64		mLastServerTimeUs;	// getServerTime() never runs backwards
+
+		bool					mHasTick;
+		sf::Uint32				mLastTick;
+		sf::Int64				mLastTickTimeUs;
+};
+
+#endif // BOOK_SERVERCLOCK_HPP
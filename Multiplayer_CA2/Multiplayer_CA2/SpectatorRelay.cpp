@@ -0,0 +1,329 @@
+//D00137655 - Jason Lynch
+//D00194504 - Dylan
+#include "SpectatorRelay.hpp"
+#include "NetworkProtocol.hpp"
+#include "Foreach.hpp"
+
+#include <SFML/System/Sleep.hpp>
+
+#include <iostream>
+
+
+namespace
+{
+	// A spectator this far behind is not going to catch up, drop it rather than buffer without bound
+	const std::size_t MaxOutboundBytes = 1024 * 1024;
+}
+
+SpectatorRelay::OutboundQueue::OutboundQueue()
+: packets()
+, bytes(0)
+{
+}
+
+SpectatorRelay::Spectator::Spectator()
+: ready(false)
+, outbound()
+, dropped(false)
+{
+	socket.setBlocking(false);
+}
+
+SpectatorRelay::SpectatorRelay(const sf::IpAddress& serverAddress, sf::Time delay)
+: mServerAddress(serverAddress)
+, mServerConnected(false)
+, mServerTimeoutTime(sf::seconds(3.f))
+, mLastServerPacketTime(sf::Time::Zero)
+, mLastHeartbeatTime(sf::Time::Zero)
+, mMaxSpectators(256)
+, mDelay(delay)
+, mHasWorldState(false)
+, mWorldHeight(768.f)
+, mBattleFieldPosition(768.f)
+, mMatchSeed(0)
+, mServerTick(0)
+{
+	mListenerSocket.setBlocking(false);
+}
+
+void SpectatorRelay::run()
+{
+	if (!connectToServer())
+	{
+		std::cout << "Relay: could not subscribe to " << mServerAddress << ":" << RelayPort << std::endl;
+		return;
+	}
+
+	mListenerSocket.listen(SpectatorPort);
+	std::cout << "Relay: serving spectators on port " << SpectatorPort << " with a " << mDelay.asSeconds() << "s delay" << std::endl;
+
+	while (mServerConnected || !mDelayedPackets.empty())
+	{
+		if (mServerConnected)
+			handleServerPackets();
+
+		handleIncomingSpectators();
+		releaseDelayedPackets();
+		flushSpectators();
+
+		// Short sleep, packets are released on a timer so the relay has to stay responsive
+		sf::sleep(sf::milliseconds(10));
+	}
+
+	std::cout << "Relay: match server closed the subscription" << std::endl;
+}
+
+bool SpectatorRelay::connectToServer()
+{
+	if (mServerSocket.connect(mServerAddress, RelayPort, sf::seconds(5.f)) != sf::TcpSocket::Done)
+		return false;
+
+	mServerSocket.setBlocking(false);
+	mServerConnected = true;
+	mLastServerPacketTime = now();
+	return true;
+}
+
+void SpectatorRelay::handleServerPackets()
+{
+	sf::Packet packet;
+	sf::Socket::Status status;
+	while ((status = mServerSocket.receive(packet)) == sf::Socket::Done)
+	{
+		DelayedPacket delayed;
+		delayed.arrivalTime = now();
+		delayed.packet = packet;
+		mDelayedPackets.push_back(delayed);
+
+		mLastServerPacketTime = now();
+		packet.clear();
+	}
+
+	if (status == sf::Socket::Disconnected || now() >= mLastServerPacketTime + mServerTimeoutTime)
+	{
+		mServerConnected = false;
+		return;
+	}
+
+	// The server drops silent subscribers, let it know we're still here. One queued heartbeat is enough.
+	if (now() >= mLastHeartbeatTime + sf::seconds(1.f) && mServerOutbound.packets.empty())
+	{
+		sf::Packet heartbeat;
+		heartbeat << static_cast<sf::Int32>(Client::Heartbeat);
+		mServerOutbound.packets.push_back(heartbeat);
+		mServerOutbound.bytes += heartbeat.getDataSize() + sizeof(sf::Uint32);
+		mLastHeartbeatTime = now();
+	}
+
+	if (!flushOutbound(mServerSocket, mServerOutbound))
+		mServerConnected = false;
+}
+
+void SpectatorRelay::handleIncomingSpectators()
+{
+	if (mSpectators.size() < mMaxSpectators)
+	{
+		SpectatorPtr spectator(new Spectator());
+		if (mListenerSocket.accept(spectator->socket) == sf::TcpListener::Done)
+			mSpectators.push_back(std::move(spectator));
+	}
+
+	for (auto itr = mSpectators.begin(); itr != mSpectators.end(); )
+	{
+		Spectator& spectator = **itr;
+
+		// Spectators run the normal client, which keeps sending input and position packets. Ignore them.
+		sf::Packet packet;
+		sf::Socket::Status status;
+		while ((status = spectator.socket.receive(packet)) == sf::Socket::Done)
+			packet.clear();
+
+		if (status == sf::Socket::Disconnected || status == sf::Socket::Error)
+		{
+			itr = mSpectators.erase(itr);
+			continue;
+		}
+
+		// Catch up late joiners once the delayed stream has produced a world state to show them
+		if (!spectator.ready && mHasWorldState)
+		{
+			informWorldState(spectator);
+			spectator.ready = true;
+		}
+
+		++itr;
+	}
+}
+
+void SpectatorRelay::releaseDelayedPackets()
+{
+	while (!mDelayedPackets.empty() && now() >= mDelayedPackets.front().arrivalTime + mDelay)
+	{
+		sf::Packet& packet = mDelayedPackets.front().packet;
+		trackWorldState(packet);
+
+		// Spectators get a synthesized initial state when they join, the server's one only seeds our own copy
+		sf::Int32 packetType;
+		sf::Packet peek = packet;
+		peek >> packetType;
+		if (packetType != Server::InitialState)
+			sendToSpectators(packet);
+
+		mDelayedPackets.pop_front();
+	}
+}
+
+void SpectatorRelay::trackWorldState(sf::Packet packet)
+{
+	sf::Int32 packetType;
+	packet >> packetType >> mServerTick;
+
+	switch (packetType)
+	{
+		case Server::InitialState:
+		{
+			sf::Int32 tankCount;
+			packet >> mWorldHeight >> mBattleFieldPosition >> tankCount;
+
+			mHasWorldState = true;
+			mTankInfo.clear();
+			for (sf::Int32 i = 0; i < tankCount; ++i)
+			{
+				sf::Int32 identifier;
+				TankInfo tank;
+				packet >> identifier >> tank.position.x >> tank.position.y >> tank.hitpoints >> tank.rotation;
+				mTankInfo[identifier] = tank;
+			}
+		} break;
+
+		case Server::MatchSeed:
+		{
+			packet >> mMatchSeed;
+		} break;
+
+		case Server::PlayerConnect:
+		{
+			sf::Int32 identifier;
+			TankInfo tank;
+			packet >> identifier >> tank.position.x >> tank.position.y;
+			tank.hitpoints = 100;
+			tank.rotation = 0.f;
+			mTankInfo[identifier] = tank;
+		} break;
+
+		case Server::PlayerDisconnect:
+		{
+			sf::Int32 identifier;
+			packet >> identifier;
+			mTankInfo.erase(identifier);
+		} break;
+
+		case Server::UpdateClientState:
+		{
+			sf::Int32 tankCount;
+			packet >> mBattleFieldPosition >> tankCount;
+
+			for (sf::Int32 i = 0; i < tankCount; ++i)
+			{
+				sf::Int32 identifier;
+				sf::Vector2f position;
+				float rotation;
+				packet >> identifier >> position.x >> position.y >> rotation;
+
+				auto found = mTankInfo.find(identifier);
+				if (found != mTankInfo.end())
+				{
+					found->second.position = position;
+					found->second.rotation = rotation;
+				}
+			}
+		} break;
+	}
+}
+
+// Same layout as GameServer::informWorldState, built from the delayed copy of the world
+void SpectatorRelay::informWorldState(Spectator& spectator)
+{
+	sf::Packet packet;
+	packet << static_cast<sf::Int32>(Server::InitialState) << mServerTick;
+	packet << mWorldHeight << mBattleFieldPosition;
+	packet << static_cast<sf::Int32>(mTankInfo.size());
+
+	FOREACH(auto& pair, mTankInfo)
+		packet << pair.first << pair.second.position.x << pair.second.position.y << pair.second.hitpoints << pair.second.rotation;
+
+	sendToSpectator(spectator, packet);
+
+	sf::Packet seedPacket;
+	seedPacket << static_cast<sf::Int32>(Server::MatchSeed) << mServerTick << mMatchSeed;
+	sendToSpectator(spectator, seedPacket);
+}
+
+void SpectatorRelay::sendToSpectators(sf::Packet& packet)
+{
+	FOREACH(SpectatorPtr& spectator, mSpectators)
+	{
+		if (spectator->ready)
+			sendToSpectator(*spectator, packet);
+	}
+}
+
+// Queued like GameServer::sendToPeer, a non-blocking send may take only part of a packet or none at all
+void SpectatorRelay::sendToSpectator(Spectator& spectator, sf::Packet& packet)
+{
+	if (spectator.dropped)
+		return;
+
+	spectator.outbound.packets.push_back(packet);
+	spectator.outbound.bytes += packet.getDataSize() + sizeof(sf::Uint32);
+
+	if (spectator.outbound.bytes > MaxOutboundBytes)
+	{
+		spectator.outbound = OutboundQueue();
+		spectator.dropped = true;
+	}
+}
+
+void SpectatorRelay::flushSpectators()
+{
+	for (auto itr = mSpectators.begin(); itr != mSpectators.end(); )
+	{
+		Spectator& spectator = **itr;
+
+		if (!spectator.dropped && !flushOutbound(spectator.socket, spectator.outbound))
+			spectator.dropped = true;
+
+		if (spectator.dropped)
+			itr = mSpectators.erase(itr);
+		else
+			++itr;
+	}
+}
+
+// Returns false once the socket has gone away. Partial keeps its progress inside the front packet and NotReady
+// means the socket buffer is full, either way the front packet stays queued for the next loop.
+bool SpectatorRelay::flushOutbound(sf::TcpSocket& socket, OutboundQueue& outbound)
+{
+	while (!outbound.packets.empty())
+	{
+		sf::Packet& front = outbound.packets.front();
+		std::size_t size = front.getDataSize() + sizeof(sf::Uint32);
+
+		sf::Socket::Status status = socket.send(front);
+		if (status == sf::Socket::Partial || status == sf::Socket::NotReady)
+			return true;
+
+		if (status != sf::Socket::Done)
+			return false;
+
+		outbound.bytes -= size;
+		outbound.packets.pop_front();
+	}
+
+	return true;
+}
+
+sf::Time SpectatorRelay::now() const
+{
+	return mClock.getElapsedTime();
+}
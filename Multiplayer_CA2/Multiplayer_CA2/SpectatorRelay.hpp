@@ -0,0 +1,105 @@
+#ifndef BOOK_SPECTATORRELAY_HPP
+#define BOOK_SPECTATORRELAY_HPP
+
+#include <SFML/System/Vector2.hpp>
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/Time.hpp>
+#include <SFML/Network/IpAddress.hpp>
+#include <SFML/Network/TcpListener.hpp>
+#include <SFML/Network/TcpSocket.hpp>
+#include <SFML/Network/Packet.hpp>
+
+#include <deque>
+#include <vector>
+#include <memory>
+#include <map>
+
+
+// Subscribes to a GameServer once and re-serves its packet stream to any number of spectators, delayed by a fixed amount
+class SpectatorRelay
+{
+	public:
+											SpectatorRelay(const sf::IpAddress& serverAddress, sf::Time delay);
+
+		// Blocks until the match server closes the subscription
+		void								run();
+
+
+	private:
+		// Packets waiting for a non-blocking socket to take them
+		struct OutboundQueue
+		{
+									OutboundQueue();
+
+			std::deque<sf::Packet>	packets;
+			std::size_t				bytes;
+		};
+
+		struct Spectator
+		{
+									Spectator();
+
+			sf::TcpSocket			socket;
+			bool					ready;
+			OutboundQueue			outbound;
+			bool					dropped;		// Socket failed or the queue overflowed, removed on the next flush
+		};
+
+		struct DelayedPacket
+		{
+			sf::Time				arrivalTime;
+			sf::Packet				packet;
+		};
+
+		// Tank state as seen by spectators, i.e. after the delay, used to catch up late joiners
+		struct TankInfo
+		{
+			sf::Vector2f			position;
+			sf::Int32				hitpoints;
+			float					rotation;
+		};
+
+		typedef std::unique_ptr<Spectator> SpectatorPtr;
+
+
+	private:
+		bool								connectToServer();
+		void								handleServerPackets();
+		void								handleIncomingSpectators();
+		void								releaseDelayedPackets();
+
+		void								trackWorldState(sf::Packet packet);
+		void								informWorldState(Spectator& spectator);
+		void								sendToSpectators(sf::Packet& packet);
+		void								sendToSpectator(Spectator& spectator, sf::Packet& packet);
+		void								flushSpectators();
+		bool								flushOutbound(sf::TcpSocket& socket, OutboundQueue& outbound);
+		sf::Time							now() const;
+
+
+	private:
+		sf::IpAddress						mServerAddress;
+		sf::TcpSocket						mServerSocket;
+		OutboundQueue						mServerOutbound;
+		bool								mServerConnected;
+		sf::Time							mServerTimeoutTime;
+		sf::Time							mLastServerPacketTime;
+		sf::Time							mLastHeartbeatTime;
+
+		sf::TcpListener						mListenerSocket;
+		std::vector<SpectatorPtr>			mSpectators;
+		std::size_t							mMaxSpectators;
+
+		sf::Clock							mClock;
+		sf::Time							mDelay;
+		std::deque<DelayedPacket>			mDelayedPackets;
+
+		bool								mHasWorldState;
+		float								mWorldHeight;
+		float								mBattleFieldPosition;
+		std::map<sf::Int32, TankInfo>		mTankInfo;
+		sf::Uint64							mMatchSeed;
+		sf::Uint32							mServerTick;	// Tick of the newest packet released to spectators
+};
+
+#endif // BOOK_SPECTATORRELAY_HPP
@@ -5,7 +5,7 @@
 
 
 State::Context::Context(sf::RenderWindow& window, TextureHolder& textures, FontHolder& fonts,
-	MusicPlayer& music, SoundPlayer& sounds, KeyBinding& keys1, KeyBinding& keys2)
+	MusicPlayer& music, SoundPlayer& sounds, KeyBinding& keys1, KeyBinding& keys2, JobSystem& jobs)
 : window(&window)
 , textures(&textures)
 , fonts(&fonts)
@@ -13,6 +13,7 @@ State::Context::Context(sf::RenderWindow& window, TextureHolder& textures, FontH
 , sounds(&sounds)
 , keys1(&keys1)
 , keys2(&keys2)
+, jobs(&jobs)
 {
 }
 
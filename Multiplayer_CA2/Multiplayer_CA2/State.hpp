@@ -19,6 +19,7 @@ class StateStack;
 class MusicPlayer;
 class SoundPlayer;
 class KeyBinding;
+class JobSystem;
 
 class State
 {
@@ -28,7 +29,7 @@ class State
 		struct Context
 		{
 								Context(sf::RenderWindow& window, TextureHolder& textures, FontHolder& fonts,
-									MusicPlayer& music, SoundPlayer& sounds, KeyBinding& keys1, KeyBinding& keys2);
+									MusicPlayer& music, SoundPlayer& sounds, KeyBinding& keys1, KeyBinding& keys2, JobSystem& jobs);
 
 			sf::RenderWindow*	window;
 			TextureHolder*		textures;
@@ -37,6 +38,7 @@ class State
 			SoundPlayer*		sounds;
 			KeyBinding*			keys1;
 			KeyBinding*			keys2;
+			JobSystem*			jobs;
 		};
 
 
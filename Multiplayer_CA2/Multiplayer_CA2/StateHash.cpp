@@ -0,0 +1,141 @@
+//D00137655 - Jason Lynch
+//D00194504 - Dylan
+#include "StateHash.hpp"
+
+#include <cmath>
+
+
+namespace
+{
+	// MurmurHash3 finalizer, good avalanche for a handful of operations
+	sf::Uint32 mix(sf::Uint32 value)
+	{
+		value ^= value >> 16;
+		value *= 0x85EBCA6Bu;
+		value ^= value >> 13;
+		value *= 0xC2B2AE35u;
+		value ^= value >> 16;
+		return value;
+	}
+
+	sf::Uint32 combine(sf::Uint32 seed, sf::Uint32 value)
+	{
+		return mix(seed ^ (value + 0x9E3779B9u + (seed << 6) + (seed >> 2)));
+	}
+
+	// The key goes into every contribution, otherwise two entities in the same state would cancel out
+	sf::Uint32 contribution(sf::Uint64 key, sf::Uint32 hash)
+	{
+		return combine(combine(static_cast<sf::Uint32>(key), static_cast<sf::Uint32>(key >> 32)), hash);
+	}
+}
+
+StateHash::StateHash()
+: mEntries()
+, mValue(0)
+{
+}
+
+void StateHash::set(Kind kind, sf::Int32 identifier, sf::Uint32 hash)
+{
+	sf::Uint64 key = makeKey(kind, identifier);
+
+	auto found = mEntries.find(key);
+	if (found != mEntries.end())
+	{
+		if (found->second == hash)
+			return;
+
+		mValue ^= contribution(key, found->second);
+		found->second = hash;
+	}
+	else
+	{
+		mEntries[key] = hash;
+	}
+
+	mValue ^= contribution(key, hash);
+}
+
+void StateHash::erase(Kind kind, sf::Int32 identifier)
+{
+	auto found = mEntries.find(makeKey(kind, identifier));
+	if (found == mEntries.end())
+		return;
+
+	mValue ^= contribution(found->first, found->second);
+	mEntries.erase(found);
+}
+
+sf::Uint32 StateHash::getValue() const
+{
+	return mValue;
+}
+
+sf::Uint32 StateHash::getValueWithout(Kind kind, const std::vector<sf::Int32>& identifiers) const
+{
+	sf::Uint32 value = mValue;
+	for (std::size_t i = 0; i < identifiers.size(); ++i)
+	{
+		auto found = mEntries.find(makeKey(kind, identifiers[i]));
+		if (found != mEntries.end())
+			value ^= contribution(found->first, found->second);
+	}
+
+	return value;
+}
+
+const StateHash::Entries& StateHash::getEntries() const
+{
+	return mEntries;
+}
+
+sf::Uint64 StateHash::makeKey(Kind kind, sf::Int32 identifier)
+{
+	return (static_cast<sf::Uint64>(kind) << 32) | static_cast<sf::Uint32>(identifier);
+}
+
+StateHash::Kind StateHash::getKind(sf::Uint64 key)
+{
+	return static_cast<Kind>(key >> 32);
+}
+
+sf::Int32 StateHash::getIdentifier(sf::Uint64 key)
+{
+	return static_cast<sf::Int32>(static_cast<sf::Uint32>(key));
+}
+
+const char* StateHash::getKindName(Kind kind)
+{
+	switch (kind)
+	{
+		case TankTransform:	return "tank transform";
+		case TankStatus:	return "tank hitpoints";
+		case Object:		return "obstacle/pickup";
+	}
+	return "unknown";
+}
+
+sf::Uint32 StateHash::hashTransform(sf::Vector2f position, float rotation)
+{
+	float wrapped = std::fmod(rotation, 360.f);
+	if (wrapped < 0.f)
+		wrapped += 360.f;
+
+	sf::Int32 x = static_cast<sf::Int32>(std::floor(position.x + 0.5f));
+	sf::Int32 y = static_cast<sf::Int32>(std::floor(position.y + 0.5f));
+	sf::Uint32 sector = static_cast<sf::Uint32>(static_cast<int>(wrapped * 256.f / 360.f + 0.5f) & 0xFF);
+
+	return combine(combine(mix(static_cast<sf::Uint32>(x)), static_cast<sf::Uint32>(y)), sector);
+}
+
+sf::Uint32 StateHash::hashTankStatus(sf::Int32 hitpoints)
+{
+	return mix(static_cast<sf::Uint32>(hitpoints));
+}
+
+// Destroyed objects hash the same whatever their last hitpoints were, the authority doesn't always send them
+sf::Uint32 StateHash::hashObject(sf::Int32 hitpoints, bool destroyed)
+{
+	return destroyed ? mix(0xDEADu) : combine(1u, static_cast<sf::Uint32>(hitpoints));
+}
@@ -0,0 +1,52 @@
+#ifndef BOOK_STATEHASH_HPP
+#define BOOK_STATEHASH_HPP
+
+#include <SFML/Config.hpp>
+#include <SFML/System/Vector2.hpp>
+
+#include <map>
+#include <vector>
+
+
+// Order independent hash of the simulation state with one entry per entity aspect. Entries combine by XOR,
+// so updating one entity costs two XORs, and two states that disagree can be diffed entry by entry.
+class StateHash
+{
+	public:
+		enum Kind
+		{
+			TankTransform,
+			TankStatus,
+			Object
+		};
+
+		typedef std::map<sf::Uint64, sf::Uint32> Entries;
+
+
+	public:
+								StateHash();
+
+		void					set(Kind kind, sf::Int32 identifier, sf::Uint32 hash);
+		void					erase(Kind kind, sf::Int32 identifier);
+		sf::Uint32				getValue() const;
+		// The value as if the given entries were absent, e.g. a peer's own tanks which it doesn't hash
+		sf::Uint32				getValueWithout(Kind kind, const std::vector<sf::Int32>& identifiers) const;
+		const Entries&			getEntries() const;
+
+		static sf::Uint64		makeKey(Kind kind, sf::Int32 identifier);
+		static Kind				getKind(sf::Uint64 key);
+		static sf::Int32		getIdentifier(sf::Uint64 key);
+		static const char*		getKindName(Kind kind);
+
+		// Quantized like the compact snapshot, so full and compact snapshots hash the same
+		static sf::Uint32		hashTransform(sf::Vector2f position, float rotation);
+		static sf::Uint32		hashTankStatus(sf::Int32 hitpoints);
+		static sf::Uint32		hashObject(sf::Int32 hitpoints, bool destroyed);
+
+
+	private:
+		Entries					mEntries;
+		sf::Uint32				mValue;
+};
+
+#endif // BOOK_STATEHASH_HPP
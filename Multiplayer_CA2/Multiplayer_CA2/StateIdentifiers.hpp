@@ -21,7 +21,11 @@ namespace States
 		HostGame,
 		HostIpEntry,
 		JoinGame,
-		JoinIpEntry
+		JoinIpEntry,
+		SpectateGame,
+		Playback,
+		Lobby,
+		MatchAuthorityGame
 	};
 }
 
@@ -40,6 +40,10 @@ class StateStack : private sf::NonCopyable
 		void				registerState(States::ID stateID, Param1 arg1);
 		template <typename T, typename Param1, typename Param2>
 		void				registerState(States::ID stateID, Param1 arg1, Param2 arg2);
+		template <typename T, typename Param1, typename Param2, typename Param3>
+		void				registerState(States::ID stateID, Param1 arg1, Param2 arg2, Param3 arg3);
+		template <typename T, typename Param1, typename Param2, typename Param3, typename Param4>
+		void				registerState(States::ID stateID, Param1 arg1, Param2 arg2, Param3 arg3, Param4 arg4);
 
 		void				update(sf::Time dt);
 		void				draw();
@@ -104,4 +108,22 @@ void StateStack::registerState(States::ID stateID, Param1 arg1, Param2 arg2)
 	};
 }
 
+template <typename T, typename Param1, typename Param2, typename Param3>
+void StateStack::registerState(States::ID stateID, Param1 arg1, Param2 arg2, Param3 arg3)
+{
+	mFactories[stateID] = [this, arg1, arg2, arg3]()
+	{
+		return State::Ptr(new T(*this, mContext, arg1, arg2, arg3));
+	};
+}
+
+template <typename T, typename Param1, typename Param2, typename Param3, typename Param4>
+void StateStack::registerState(States::ID stateID, Param1 arg1, Param2 arg2, Param3 arg3, Param4 arg4)
+{
+	mFactories[stateID] = [this, arg1, arg2, arg3, arg4]()
+	{
+		return State::Ptr(new T(*this, mContext, arg1, arg2, arg3, arg4));
+	};
+}
+
 #endif // BOOK_STATESTACK_HPP
@@ -9,14 +9,14 @@
 #include "NetworkNode.hpp"
 #include "ResourceHolder.hpp"
 #include "EmitterNode.hpp"
+#include "Foreach.hpp"
+#include "FixedPoint.hpp"
 
 #include <SFML/Graphics/RenderTarget.hpp>
 #include <SFML/Graphics/RenderStates.hpp>
 
 #include <cmath>
 
-extern std::string userName;
-
 using namespace std::placeholders;
 
 namespace
@@ -24,7 +24,7 @@ namespace
 	const std::vector<TankData> Table = initializeTankData();
 }
 
-Tank::Tank(Type type, const TextureHolder& textures, const FontHolder& fonts)
+Tank::Tank(Type type, const TextureHolder& textures)
 : Entity(Table[type].hitpoints)
 , mType(type)
 , mSprite(textures.get(Table[type].texture), Table[type].textureRect)
@@ -43,9 +43,19 @@ Tank::Tank(Type type, const TextureHolder& textures, const FontHolder& fonts)
 , mSpreadLevel(1)
 , mMissileAmmo(2)
 , mDropPickupCommand()
+, mDropPickupType(Pickup::HealthRefill)
 , mTravelledDistance(0.f)
 , mDirectionIndex(0)
-, mMissileDisplay(nullptr)
+, mHealthLabel()
+, mLabelledHitpoints(-1)
+, mRandom()
+, mNetworkFired(false)
+, mPendingShotSeeds()
+, mLastShotTick(0)
+, mHasShotTick(false)
+, mProjectilePool(nullptr)
+, mPickupPool(nullptr)
+, mProjectileSystem(nullptr)
 , mIdentifier(0)
 {
 	mExplosion.setFrameSize(sf::Vector2i(256, 256));
@@ -73,25 +83,6 @@ Tank::Tank(Type type, const TextureHolder& textures, const FontHolder& fonts)
 		createPickup(node, textures);
 	};
 
-	std::unique_ptr<TextNode> healthDisplay(new TextNode(fonts, ""));
-	mHealthDisplay = healthDisplay.get();
-	mHealthDisplay->setColor(sf::Color::Green);
-	attachChild(std::move(healthDisplay));
-
-	/*std::unique_ptr<TextNode> userNameDisplay(new TextNode(fonts, ""));
-	mUserNameDisplay = userNameDisplay.get();
-	mUserNameDisplay->setString(userName);
-	mUserNameDisplay->setColor(sf::Color::Yellow);
-	attachChild(std::move(userNameDisplay));*/
-
-	/*if (getCategory() == Category::PlayerTank)
-	{
-		std::unique_ptr<TextNode> missileDisplay(new TextNode(fonts, ""));
-		missileDisplay->setPosition(0, 70);
-		mMissileDisplay = missileDisplay.get();
-		attachChild(std::move(missileDisplay));
-	}*/
-
 	// Dust trails for tank treads - Dylan
 	//Adds trail to the front left & right of the sprite
 	std::unique_ptr<EmitterNode> smokeLeft(new EmitterNode(Particle::Type::TankDust));
@@ -101,8 +92,6 @@ Tank::Tank(Type type, const TextureHolder& textures, const FontHolder& fonts)
 	std::unique_ptr<EmitterNode> smokeRight(new EmitterNode(Particle::Type::TankDust));
 	smokeRight->setPosition(40.f, getBoundingRect().height / 2.f);
 	attachChild(std::move(smokeRight));
-
-	updateTexts();
 }
 
 int Tank::getMissileAmmo() const
@@ -130,9 +119,6 @@ void Tank::disablePickups()
 
 void Tank::updateCurrent(sf::Time dt, CommandQueue& commands)
 {
-	// Update texts and roll animation
-	updateTexts();
-
 	// Entity has been destroyed: Possibly drop pickup, mark for removal
 	if (isDestroyed())
 	{
@@ -143,7 +129,7 @@ void Tank::updateCurrent(sf::Time dt, CommandQueue& commands)
 		if (!mExplosionBegan)
 		{
 			// Play sound effect
-			SoundEffect::ID soundEffect = (randomInt(2) == 0) ? SoundEffect::Explosion1 : SoundEffect::Explosion2;
+			SoundEffect::ID soundEffect = (mRandom.nextInt(2) == 0) ? SoundEffect::Explosion1 : SoundEffect::Explosion2;
 			playLocalSound(commands, soundEffect);
 		}
 		return;
@@ -252,6 +238,58 @@ void Tank::playLocalSound(CommandQueue& commands, SoundEffect::ID effect)
 	commands.push(command);
 }
 
+void Tank::drive(float distance)
+{
+	if (isDeterministic())
+	{
+		Fixed angle = Fixed::fromFloat(getRotation());
+		FixedVector position(getPosition());
+		position += FixedVector(-fixedSin(angle), fixedCos(angle)) * Fixed::fromFloat(distance);
+		setPosition(position.toVector2f());
+	}
+	else
+	{
+		move(distance * -sin(toRadian(getRotation())), distance * cos(toRadian(getRotation())));
+	}
+}
+
+void Tank::setNetworkFired(bool networkFired)
+{
+	mNetworkFired = networkFired;
+}
+
+bool Tank::isNetworkFired() const
+{
+	return mNetworkFired;
+}
+
+void Tank::fireFromNetwork(sf::Uint32 tick, sf::Uint32 seed)
+{
+	// Drop duplicates and stale events, the owner never fires twice in one tick
+	if (mHasShotTick && tick <= mLastShotTick)
+		return;
+
+	mLastShotTick = tick;
+	mHasShotTick = true;
+	mPendingShotSeeds.push_back(seed);
+}
+
+void Tank::setRandomSeed(sf::Uint64 seed)
+{
+	mRandom.seed(seed);
+}
+
+void Tank::setNodePools(NodePool<Projectile>& projectiles, NodePool<Pickup>& pickups)
+{
+	mProjectilePool = &projectiles;
+	mPickupPool = &pickups;
+}
+
+void Tank::setProjectileSystem(ProjectileSystem& system)
+{
+	mProjectileSystem = &system;
+}
+
 int	Tank::getIdentifier()
 {
 	return mIdentifier;
@@ -266,20 +304,46 @@ void Tank::checkPickupDrop(CommandQueue& commands)
 {
 	// Drop pickup, if enemy airplane, with probability 1/3, if pickup not yet dropped
 	// and if not in network mode (where pickups are dropped via packets)
-	if (!isAllied() && randomInt(3) == 0 && !mSpawnedPickup && mPickupsEnabled)
+	// Updates run on worker threads, so the draws come from the tank's own engine, once
+	if (!isAllied() && !mSpawnedPickup && mPickupsEnabled && mRandom.nextInt(3) == 0)
+	{
+		mDropPickupType = static_cast<Pickup::Type>(mRandom.nextInt(Pickup::TypeCount));
 		commands.push(mDropPickupCommand);
+	}
 
 	mSpawnedPickup = true;
 }
 
 void Tank::checkProjectileLaunch(sf::Time dt, CommandQueue& commands)
 {
+	// Remote tanks: replay the shots their owner reported, in order
+	if (mNetworkFired)
+	{
+		FOREACH(sf::Uint32 seed, mPendingShotSeeds)
+			launchShot(seed, commands);
+
+		mPendingShotSeeds.clear();
+		mIsFiring = false;
+	}
+
 	// Check for automatic gunfire, allow only in intervals
-	if (mIsFiring && mFireCountdown <= sf::Time::Zero)
+	else if (mIsFiring && mFireCountdown <= sf::Time::Zero)
 	{
 		// Interval expired: We can fire a new bullet
-		commands.push(mFireCommand);
-		checkProjectileType(commands);
+		sf::Uint32 seed = mRandom.next();
+		launchShot(seed, commands);
+
+		// Report the shot so every other client spawns the same projectiles
+		sf::Int32 identifier = mIdentifier;
+		sf::Vector2f position = getWorldPosition();
+
+		Command notifyCommand;
+		notifyCommand.category = Category::Network;
+		notifyCommand.action = derivedAction<NetworkNode>([identifier, position, seed] (NetworkNode& node, sf::Time)
+		{
+			node.notifyGameAction(GameActions::Action(GameActions::TankFired, position, identifier, seed));
+		});
+		commands.push(notifyCommand);
 
 		mFireCountdown += Table[mType].fireInterval / (mFireRateLevel + 1.f);
 		mIsFiring = false;
@@ -301,7 +365,16 @@ void Tank::checkProjectileLaunch(sf::Time dt, CommandQueue& commands)
 	}
 }
 
-void Tank::checkProjectileType(CommandQueue& commands)
+void Tank::launchShot(sf::Uint32 seed, CommandQueue& commands)
+{
+	// Everything random about a shot comes from its seed, so all clients agree on it
+	RandomEngine shotRandom(seed);
+
+	commands.push(mFireCommand);
+	checkProjectileType(commands, shotRandom);
+}
+
+void Tank::checkProjectileType(CommandQueue& commands, RandomEngine& shotRandom)
 {
 	Projectile::Type id = getProjectile();
 
@@ -311,7 +384,7 @@ void Tank::checkProjectileType(CommandQueue& commands)
 	}
 	else if (id == Projectile::Type::GreenHmgBullet || id == Projectile::Type::RedHmgBullet || id == Projectile::Type::HostHmgBullet) //If tank type is HMG - Jason lynch 
 	{
-		SoundEffect::ID soundEffect = (randomInt(2) == 0) ? SoundEffect::TankCannon1 : SoundEffect::TankCannon2; //Pick one of two sounds - Jason lynch  
+		SoundEffect::ID soundEffect = (shotRandom.nextInt(2) == 0) ? SoundEffect::TankCannon1 : SoundEffect::TankCannon2; //Pick one of two sounds - Jason lynch  
 		playLocalSound(commands, soundEffect); //Play that sound - Jason lynch 
 	}
 	else if (id == Projectile::Type::GreenGatlingBullet || id == Projectile::Type::RedGatlingBullet || id == Projectile::Type::HostGatlingBullet) //If tank type is Gatling - Jason lynch  
@@ -405,56 +478,75 @@ void Tank::createBullets(SceneNode& node, const TextureHolder& textures) const
 void Tank::createProjectile(SceneNode& node, Projectile::Type type, float xOffset, float yOffset, const TextureHolder& textures) const
 {
 	Projectile::Type bulletType = getProjectile();
+	float speed = Projectile::getMaxSpeed(bulletType);
+
+	sf::Vector2f position;
+	sf::Vector2f velocity;
+	if (isDeterministic())
+	{
+		Fixed angle = Fixed::fromFloat(Tank::getRotation());
+		FixedVector heading(-fixedSin(angle), fixedCos(angle));
+		FixedVector spread(Fixed::fromFloat(xOffset), Fixed::fromFloat(yOffset));
 
-	std::unique_ptr<Projectile> projectile(new Projectile(bulletType, textures));
+		position = (FixedVector(getWorldPosition()) + heading * Fixed(15) + spread).toVector2f();
+		velocity = (heading * Fixed::fromFloat(speed * 1.5f) + spread).toVector2f();
+	}
+	else
+	{
+		//Sets projectile spawn position to origin on the tank - Dylan
+		sf::Vector2f offset(15.f * -sin(toRadian(Tank::getRotation()))+xOffset, 15.f * cos(toRadian(Tank::getRotation()))+yOffset);
 
-	//Sets projectile spawn position to origin on the tank - Dylan
-	sf::Vector2f offset(15.f * -sin(toRadian(Tank::getRotation()))+xOffset, 15.f * cos(toRadian(Tank::getRotation()))+yOffset);
+		//Sets velocity respective to the type of bullet and direction based on the direction the tank is facing - Dylan
+		velocity = sf::Vector2f(speed * 1.5f * -sin(toRadian(Tank::getRotation()))+xOffset, 
+			speed * 1.5f * cos(toRadian(Tank::getRotation()))+yOffset);
+
+		position = getWorldPosition() + offset;
+	}
 
-	//Sets velocity respective to the type of bullet and direction based on the direction the tank is facing - Dylan
-	sf::Vector2f velocity(projectile->getMaxSpeed() * 1.5f * -sin(toRadian(Tank::getRotation()))+xOffset, 
-		projectile->getMaxSpeed() * 1.5f * cos(toRadian(Tank::getRotation()))+yOffset);
+	float rotation = Tank::getRotation() + 180.f;
+
+	// Plain bullets live in the projectile system, the others need a node for their smoke or animation
+	if (mProjectileSystem && ProjectileSystem::handles(bulletType))
+	{
+		mProjectileSystem->spawn(bulletType, mIdentifier, position, velocity, rotation);
+		return;
+	}
 
-	projectile->setPosition(getWorldPosition() + offset);
+	assert(mProjectilePool);
+	NodePool<Projectile>::Ptr projectile = mProjectilePool->acquire(bulletType, textures);
+	projectile->setPosition(position);
 	projectile->setVelocity(velocity);
-	projectile->setRotation(Tank::getRotation() + 180.f);
+	projectile->setRotation(rotation);
+	projectile->setDeterministic(isDeterministic());
 	node.attachChild(std::move(projectile));
 }
 
 void Tank::createPickup(SceneNode& node, const TextureHolder& textures) const
 {
-	auto type = static_cast<Pickup::Type>(randomInt(Pickup::TypeCount));
-
-	std::unique_ptr<Pickup> pickup(new Pickup(type, textures));
+	assert(mPickupPool);
+	NodePool<Pickup>::Ptr pickup = mPickupPool->acquire(mDropPickupType, textures);
 	pickup->setPosition(getWorldPosition());
 	pickup->setVelocity(0.f, 1.f);
+	pickup->setDeterministic(isDeterministic());
 	node.attachChild(std::move(pickup));
 }
 
-void Tank::updateTexts()
+void Tank::appendLabels(LabelBatch& labels)
 {
-	// Display hitpoints
-	if (isDestroyed()) {
-		mHealthDisplay->setString("");
-		//mUserNameDisplay->setString("");
-	}
-	else
-		mHealthDisplay->setString(toString(getHitpoints()) + " HP");
-
-	mHealthDisplay->setPosition(0.f, -getBoundingRect().height);
-	mHealthDisplay->setRotation(-getRotation());
-
-	/*mUserNameDisplay->setPosition(0.f, -getBoundingRect().height-50.0f);
-	mUserNameDisplay->setRotation(-getRotation());*/
+	if (isDestroyed())
+		return;
 
-	// Display missiles, if available
-	if (mMissileDisplay)
+	// Formatting and glyph layout only when the value changed
+	if (getHitpoints() != mLabelledHitpoints)
 	{
-		if (mMissileAmmo == 0 || isDestroyed())
-			mMissileDisplay->setString("");
-		else
-			mMissileDisplay->setString("M: " + toString(mMissileAmmo));
+		labels.setText(mHealthLabel, toString(getHitpoints()) + " HP", sf::Color::Green);
+		mLabelledHitpoints = getHitpoints();
 	}
+
+	// Above the tank, turning with it but staying upright; the offset is what the bounding rect gave an
+	// unrotated tank, without computing the rect every frame
+	sf::Vector2f position = getWorldTransform().transformPoint(0.f, -mSprite.getLocalBounds().height * getScale().y);
+	labels.append(mHealthLabel, position, getScale().x);
 }
 
 void Tank::setTankTexture(unsigned int val) { //Allows change of tank texture (e.g pickups) - Jason Lynch
@@ -5,8 +5,12 @@
 #include "Command.hpp"
 #include "ResourceIdentifiers.hpp"
 #include "Projectile.hpp"
-#include "TextNode.hpp"
+#include "LabelBatch.hpp"
 #include "Animation.hpp"
+#include "RandomEngine.hpp"
+#include "NodePool.hpp"
+#include "Pickup.hpp"
+#include "ProjectileSystem.hpp"
 
 #include <SFML/Graphics/Sprite.hpp>
 
@@ -40,10 +44,10 @@ class Tank : public Entity
 
 
 	public:
-								Tank(Type type, const TextureHolder& textures, const FontHolder& fonts);
+								Tank(Type type, const TextureHolder& textures);
 
 		virtual unsigned int	getCategory() const;
-		void					checkProjectileType(CommandQueue& commands);
+		void					checkProjectileType(CommandQueue& commands, RandomEngine& shotRandom);
 		virtual sf::FloatRect	getBoundingRect() const;
 		virtual void			remove();
 		virtual bool 			isMarkedForRemoval() const;
@@ -60,12 +64,26 @@ class Tank : public Entity
 		void 					fire();
 		void					launchMissile();
 		void					playLocalSound(CommandQueue& commands, SoundEffect::ID effect);
+		// Moves along the barrel's direction, backwards for negative distances
+		void					drive(float distance);
 		int						getIdentifier();
 		void					setIdentifier(int identifier);
 		int						getMissileAmmo() const;
 		void					setMissileAmmo(int ammo);
 		Projectile::Type		getProjectile() const;
 
+		// Network-fired tanks ignore their own fire input and only shoot on fire events from their owner
+		void					setNetworkFired(bool networkFired);
+		bool					isNetworkFired() const;
+		void					fireFromNetwork(sf::Uint32 tick, sf::Uint32 seed);
+		void					setRandomSeed(sf::Uint64 seed);
+		// Where fired projectiles and dropped pickups come from, owned by the World
+		void					setNodePools(NodePool<Projectile>& projectiles, NodePool<Pickup>& pickups);
+		// Plain bullets go here instead of becoming Projectile nodes
+		void					setProjectileSystem(ProjectileSystem& system);
+		// Hitpoint label, laid out again only when the hitpoints change; the World calls this on the main thread
+		void					appendLabels(LabelBatch& labels);
+
 
 	private:
 		virtual void			drawCurrent(sf::RenderTarget& target, sf::RenderStates states) const;
@@ -73,13 +91,12 @@ class Tank : public Entity
 		//void					updateMovementPattern(sf::Time dt);
 		void					checkPickupDrop(CommandQueue& commands);
 		void					checkProjectileLaunch(sf::Time dt, CommandQueue& commands);
+		void					launchShot(sf::Uint32 seed, CommandQueue& commands);
 
 		void					createBullets(SceneNode& node, const TextureHolder& textures) const;
 		void					createProjectile(SceneNode& node, Projectile::Type type, float xOffset, float yOffset, const TextureHolder& textures) const;
 		void					createPickup(SceneNode& node, const TextureHolder& textures) const;
 
-		void					updateTexts();
-		
 
 
 	private:
@@ -101,13 +118,22 @@ class Tank : public Entity
 		int						mMissileAmmo;
 
 		Command 				mDropPickupCommand;
+		Pickup::Type			mDropPickupType;		// Drawn with the drop decision, in the tank's own update
 		float					mTravelledDistance;
 		std::size_t				mDirectionIndex;
-		TextNode*				mHealthDisplay;
-		TextNode*				mUserNameDisplay;
-		TextNode*				mMissileDisplay;
+		LabelBatch::Label		mHealthLabel;
+		int						mLabelledHitpoints;		// What mHealthLabel shows, negative before the first layout
 		const					TextureHolder& mTextures; //Hold texture for tank changes - Jason Lynch
 
+		RandomEngine			mRandom;
+		bool					mNetworkFired;
+		std::vector<sf::Uint32>	mPendingShotSeeds;
+		sf::Uint32				mLastShotTick;
+		bool					mHasShotTick;
+		NodePool<Projectile>*	mProjectilePool;
+		NodePool<Pickup>*		mPickupPool;
+		ProjectileSystem*		mProjectileSystem;
+
 	
 		int						mIdentifier;};
 
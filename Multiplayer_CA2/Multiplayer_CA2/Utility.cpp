@@ -2,11 +2,13 @@
 //D00194504 - Dylan
 #include "Utility.hpp"
 #include "Animation.hpp"
+#include "RandomEngine.hpp"
 
 #include <SFML/Graphics/Sprite.hpp>
 #include <SFML/Graphics/Text.hpp>
 
-#include <random>
+#include <functional>
+#include <thread>
 #include <cmath>
 #include <ctime>
 #include <cassert>
@@ -14,13 +16,12 @@
 
 namespace
 {
-	std::default_random_engine createRandomEngine()
+	// One generator per thread: the game and GameServer threads both draw numbers, and sharing one engine was a data race
+	RandomEngine& threadRandomEngine()
 	{
-		auto seed = static_cast<unsigned long>(std::time(nullptr));
-		return std::default_random_engine(seed);
+		thread_local RandomEngine engine(mixSeed(static_cast<sf::Uint64>(std::time(nullptr)), std::hash<std::thread::id>()(std::this_thread::get_id())));
+		return engine;
 	}
-
-	auto RandomEngine = createRandomEngine();
 }
 
 std::string toString(sf::Keyboard::Key key)
@@ -166,8 +167,7 @@ float toRadian(float degree)
 
 int randomInt(int exclusiveMax)
 {
-	std::uniform_int_distribution<> distr(0, exclusiveMax - 1);
-	return distr(RandomEngine);
+	return threadRandomEngine().nextInt(exclusiveMax);
 }
 
 float length(sf::Vector2f vector)
@@ -9,29 +9,56 @@
 #include "SoundNode.hpp"
 #include "NetworkNode.hpp"
 #include "Utility.hpp"
+#include "DataTables.hpp"
+#include "JobSystem.hpp"
 #include <SFML/Graphics/RenderTarget.hpp>
 
 #include <algorithm>
 #include <cmath>
 #include <limits>
 #include <fstream>
+#include <ctime>
 
 
-World::World(sf::RenderTarget& outputTarget, FontHolder& fonts, SoundPlayer& sounds, bool networked)
+namespace
+{
+	// A couple of tank lengths, so a cell rarely holds more than a handful of entities
+	const float CollisionCellSize = 128.f;
+
+	// Nodes that only touch their own subtree when updated, and so are updated concurrently
+	const unsigned int EntityCategories = Category::Tank | Category::Projectile | Category::Pickup | Category::Collidable;
+
+	// Entities per job; a batch should be worth more than the queueing it costs
+	const std::size_t EntityBatchSize = 16;
+
+	// Simulation step of the deterministic mode, whatever the caller's frame time
+	const sf::Time DeterministicTick = sf::seconds(1.f / 60.f);
+}
+
+World::World(sf::RenderTarget& outputTarget, FontHolder& fonts, SoundPlayer& sounds, JobSystem& jobs, bool networked)
 	: mTarget(outputTarget)
 	, mSceneTexture()
 	, mWorldView(outputTarget.getDefaultView())
 	, mTextures()
 	, mFonts(fonts)
 	, mSounds(sounds)
+	, mJobs(jobs)
+	, mCategoryIndex()
+	, mEntityTable()
+	, mProjectilePool()
+	, mPickupPool()
 	, mSceneGraph()
 	, mSceneLayers()
+	, mCommandQueue()
+	, mEntityNodes()
+	, mBatchQueues()
 	, mWorldBounds(0.f, 0.f, mWorldView.getSize().x, mWorldView.getSize().y)
 	, mSpawnPosition(0.0f, 0.0f)
 	, mScrollSpeed(0.0f)
 	, mObstacleSpawnPosition(mWorldView.getSize().x * .25f, mWorldView.getSize().y / 2.f)
 	, mScrollSpeedCompensation(0.0f)
 	, mPlayerTanks()
+	, mTankHandles()
 	, mObstacles()
 	, mPickups()
 	, mEnemySpawnPoints()
@@ -39,9 +66,31 @@ World::World(sf::RenderTarget& outputTarget, FontHolder& fonts, SoundPlayer& sou
 	, mNetworkedWorld(networked)
 	, mNetworkNode(nullptr)
 	, mFinishSprite(nullptr)
+	, mRandomSeed(static_cast<sf::Uint64>(std::time(nullptr)))
+	, mTick(0)
+	, mDeterministic(false)
+	, mReplicationAuthority(false)
+	, mReplicationIdentifierCounter(1)
+	, mReplicatedEntities()
+	, mReplicatedStates()
+	, mStateHash()
+	, mHashedTanks()
+	, mCollisionGrid(CollisionCellSize, jobs)
+	, mCollisionPairs()
+	, mBulletHits()
+	, mProjectileSystem(nullptr)
+	, mLabelBatch(nullptr)
 {
+	// Only the combinations handleCollisions() responds to
+	mCollisionGrid.addRule(Category::Tank, Category::Pickup);
+	mCollisionGrid.addRule(Category::Tank, Category::Projectile);
+	mCollisionGrid.addRule(Category::Projectile, Category::Collidable);
+	mCollisionGrid.addRule(Category::Tank, Category::Collidable);
+
 	mSceneTexture.create(mTarget.getSize().x, mTarget.getSize().y);
 
+	mSceneGraph.joinCategoryIndex(mCategoryIndex);
+
 	loadTextures();
 	buildScene();
 
@@ -51,6 +100,13 @@ World::World(sf::RenderTarget& outputTarget, FontHolder& fonts, SoundPlayer& sou
 
 void World::update(sf::Time dt)
 {
+	if (mDeterministic)
+		dt = DeterministicTick;
+
+	++mTick;
+	if (mNetworkNode)
+		mNetworkNode->setCurrentTick(mTick);
+
 	FOREACH(Tank * a, mPlayerTanks)
 		a->setVelocity(0.f, 0.f);
 
@@ -59,7 +115,7 @@ void World::update(sf::Time dt)
 
 	// Forward commands to scene graph, adapt velocity (scrolling, diagonal correction)
 	while (!mCommandQueue.isEmpty())
-		mSceneGraph.onCommand(mCommandQueue.pop(), dt);
+		dispatchCommand(mCommandQueue.pop(), dt);
 
 	// Collision detection and response (may destroy entities)
 	handleCollisions();
@@ -67,12 +123,24 @@ void World::update(sf::Time dt)
 	// Remove Tanks that were destroyed (World::removeWrecks() only destroys the entities, not the pointers in mPlayerTank)
 	auto firstToRemove = std::remove_if(mPlayerTanks.begin(), mPlayerTanks.end(), std::mem_fn(&Tank::isMarkedForRemoval));
 	mPlayerTanks.erase(firstToRemove, mPlayerTanks.end());
+	for (auto itr = mTankHandles.begin(); itr != mTankHandles.end(); )
+	{
+		Entity* tank = mEntityTable.get(itr->second);
+		if (!tank || tank->isMarkedForRemoval())
+			mTankHandles.erase(itr++);
+		else
+			++itr;
+	}
+
+	// Gather replicated changes while every entity about to be removed is still alive
+	collectReplicatedStates();
 
 	// Remove all destroyed entities, create new ones
 	mSceneGraph.removeWrecks();
 
 	// Regular update step, adapt position (correct if outside view)
-	mSceneGraph.update(dt, mCommandQueue);
+	mProjectileSystem->setCullBounds(getBattlefieldBounds());
+	updateScene(dt);
 
 	adaptPlayerPosition();
 	spawnObstacles();
@@ -97,6 +165,37 @@ void World::draw()
 	}
 }
 
+void World::updateScene(sf::Time dt)
+{
+	// Layers, particles, sounds and the bullet system on this thread, gathering the entities on the way
+	mEntityNodes.clear();
+	mSceneGraph.updateDeferring(dt, mCommandQueue, EntityCategories, mEntityNodes);
+
+	// Entities in independent batches, each queuing its commands apart from the others
+	std::size_t batchCount = (mEntityNodes.size() + EntityBatchSize - 1) / EntityBatchSize;
+	if (mBatchQueues.size() < batchCount)
+		mBatchQueues.resize(batchCount);
+
+	mJobs.parallelFor(batchCount, [this, dt] (std::size_t batch)
+	{
+		std::size_t end = std::min(mEntityNodes.size(), (batch + 1) * EntityBatchSize);
+		for (std::size_t i = batch * EntityBatchSize; i < end; ++i)
+			mEntityNodes[i]->update(dt, mBatchQueues[batch]);
+	});
+
+	// Merged in batch order, so the commands come out in scene graph order however the jobs ran
+	for (std::size_t batch = 0; batch < batchCount; ++batch)
+	{
+		while (!mBatchQueues[batch].isEmpty())
+			mCommandQueue.push(mBatchQueues[batch].pop());
+	}
+
+	// Laying out text fills the shared font's glyph cache, which only this thread may do
+	mLabelBatch->clear();
+	FOREACH(Tank* tank, mPlayerTanks)
+		tank->appendLabels(*mLabelBatch);
+}
+
 CommandQueue& World::getCommandQueue()
 {
 	return mCommandQueue;
@@ -104,13 +203,12 @@ CommandQueue& World::getCommandQueue()
 
 Tank* World::getTank(int identifier) const
 {
-	FOREACH(Tank * a, mPlayerTanks)
-	{
-		if (a->getIdentifier() == identifier)
-			return a;
-	}
+	auto found = mTankHandles.find(identifier);
+	if (found == mTankHandles.end())
+		return nullptr;
 
-	return nullptr;
+	// Only tanks are ever stored under a tank identifier
+	return static_cast<Tank*>(mEntityTable.get(found->second));
 }
 
 void World::removeTank(int identifier)
@@ -120,7 +218,11 @@ void World::removeTank(int identifier)
 	{
 		Tank->destroy();
 		mPlayerTanks.erase(std::find(mPlayerTanks.begin(), mPlayerTanks.end(), Tank));
+		mTankHandles.erase(identifier);
 	}
+
+	mStateHash.erase(StateHash::TankTransform, identifier);
+	mStateHash.erase(StateHash::TankStatus, identifier);
 }
 
 Tank* World::addTank(int identifier)
@@ -173,21 +275,30 @@ Tank* World::addTank(int identifier)
 		}
 	}
 
-	std::unique_ptr<Tank> player(new Tank(type, mTextures, mFonts));
+	std::unique_ptr<Tank> player(new Tank(type, mTextures));
 	player->setPosition(mWorldView.getCenter());
 	player->setIdentifier(identifier);
 	player->setScale(0.6f, 0.6f);
+	player->setRandomSeed(mixSeed(mRandomSeed, static_cast<sf::Uint64>(identifier)));
+
+	// In a networked world only the tanks controlled on this machine fire on their own, see Tank::setNetworkFired()
+	player->setNetworkFired(mNetworkedWorld);
+	player->setNodePools(mProjectilePool, mPickupPool);
+	player->setProjectileSystem(*mProjectileSystem);
+	player->setDeterministic(mDeterministic);
 
 	mPlayerTanks.push_back(player.get());
+	mTankHandles[identifier] = mEntityTable.insert(*player);
 	mSceneLayers[LowerAir]->attachChild(std::move(player));
 	return mPlayerTanks.back();
 }
 
 void World::createPickup(sf::Vector2f position, Pickup::Type type)
 {
-	std::unique_ptr<Pickup> pickup(new Pickup(type, mTextures));
+	NodePool<Pickup>::Ptr pickup = mPickupPool.acquire(type, mTextures);
 	pickup->setPosition(position);
 	pickup->setVelocity(0.f, 1.f);
+	pickup->setDeterministic(mDeterministic);
 	mSceneLayers[LowerAir]->attachChild(std::move(pickup));
 }
 
@@ -196,6 +307,113 @@ bool World::pollGameAction(GameActions::Action& out)
 	return mNetworkNode->pollGameAction(out);
 }
 
+void World::setRandomSeed(sf::Uint64 seed)
+{
+	mRandomSeed = seed;
+
+	FOREACH(Tank* tank, mPlayerTanks)
+		tank->setRandomSeed(mixSeed(seed, static_cast<sf::Uint64>(tank->getIdentifier())));
+
+	// Obstacles are already up when the match seed arrives
+	FOREACH(auto& pair, mReplicatedEntities)
+	{
+		Entity* entity = mEntityTable.get(pair.second);
+		if (entity && entity->getCategory() & Category::Collidable)
+			static_cast<Obstacle*>(entity)->setRandomSeed(mixSeed(seed, static_cast<sf::Uint64>(pair.first)));
+	}
+}
+
+sf::Uint32 World::getTick() const
+{
+	return mTick;
+}
+
+void World::setDeterministic(bool deterministic)
+{
+	mDeterministic = deterministic;
+	mProjectileSystem->setDeterministic(deterministic);
+
+	FOREACH(Tank* tank, mPlayerTanks)
+		tank->setDeterministic(deterministic);
+}
+
+void World::setReplicationAuthority(bool authority)
+{
+	mReplicationAuthority = authority;
+}
+
+void World::pollReplicatedStates(std::vector<ReplicatedState>& out)
+{
+	out.clear();
+	out.swap(mReplicatedStates);
+}
+
+void World::applyReplicatedState(const ReplicatedState& state)
+{
+	auto found = mReplicatedEntities.find(state.identifier);
+	if (found == mReplicatedEntities.end())
+		return;
+
+	Entity* replicated = mEntityTable.get(found->second);
+	if (!replicated)
+		return;
+
+	Entity& entity = *replicated;
+
+	if (state.fields & ReplicationComponent::Position)
+		entity.setPosition(state.position);
+
+	if (state.fields & ReplicationComponent::Destroyed)
+		entity.destroy();
+	else if (state.fields & ReplicationComponent::Hitpoints && state.hitpoints > 0)
+		entity.setHitpoints(state.hitpoints);
+
+	entity.getReplication().clearDirtyFields();
+	if (state.fields & (ReplicationComponent::Hitpoints | ReplicationComponent::Destroyed))
+		mStateHash.set(StateHash::Object, state.identifier, StateHash::hashObject(entity.getHitpoints(), entity.isDestroyed()));
+}
+
+StateHash& World::getStateHash()
+{
+	return mStateHash;
+}
+
+void World::refreshTankHashes()
+{
+	std::vector<sf::Int32> tanks;
+	FOREACH(Tank* tank, mPlayerTanks)
+	{
+		tanks.push_back(tank->getIdentifier());
+		mStateHash.set(StateHash::TankStatus, tank->getIdentifier(), StateHash::hashTankStatus(tank->getHitpoints()));
+	}
+
+	// Tanks destroyed in the simulation since the last refresh
+	FOREACH(sf::Int32 identifier, mHashedTanks)
+	{
+		if (std::find(tanks.begin(), tanks.end(), identifier) == tanks.end())
+		{
+			mStateHash.erase(StateHash::TankTransform, identifier);
+			mStateHash.erase(StateHash::TankStatus, identifier);
+		}
+	}
+
+	mHashedTanks.swap(tanks);
+}
+
+bool World::loadArenaAsset(const std::string& name, const std::string& filename)
+{
+	static const std::vector<ArenaAssetData> Table = initializeArenaAssetData();
+
+	FOREACH(const ArenaAssetData& entry, Table)
+	{
+		// Loaded in place, sprites already using the texture pick up the new one
+		if (entry.name == name)
+			return mTextures.get(entry.texture).loadFromFile(filename);
+	}
+
+	return false;
+}
+
 void World::setCurrentBattleFieldPosition(float lineY)
 {
 	mWorldView.setCenter(mWorldView.getCenter().x, lineY - mWorldView.getSize().y / 2);
@@ -341,6 +559,9 @@ void World::spawnObstacles()
 		obstacle->setScale(spawn.scaleX, spawn.scaleY);
 		obstacle->setPosition(spawn.x, spawn.y);
 		obstacle->setRotation(spawn.rotation);
+		obstacle->setDeterministic(mDeterministic);
+		registerReplicated(*obstacle);
+		obstacle->setRandomSeed(mixSeed(mRandomSeed, static_cast<sf::Uint64>(obstacle->getReplication().getIdentifier())));
 		mSceneLayers[Layer::LowerAir]->attachChild(std::move(obstacle));
 
 		// Object is spawned, remove from the list to spawn
@@ -356,10 +577,12 @@ void World::spawnPickups()//Spawn Tank pickups, set scale, rotation, and positio
 	{
 		PickupSpawnPoint spawn = mPickups.back();
 
-		std::unique_ptr<Pickup> pickup(new Pickup(spawn.type, mTextures));
+		NodePool<Pickup>::Ptr pickup = mPickupPool.acquire(spawn.type, mTextures);
 		pickup->setScale(spawn.scaleX, spawn.scaleY);
 		pickup->setRotation(spawn.rotation);
 		pickup->setPosition(spawn.x, spawn.y);
+		pickup->setDeterministic(mDeterministic);
+		registerReplicated(*pickup);
 
 		mSceneLayers[static_cast<int>(Layer::LowerAir)]->attachChild(std::move(pickup));
 
@@ -368,6 +591,14 @@ void World::spawnPickups()//Spawn Tank pickups, set scale, rotation, and positio
 	}
 }
 
+// Whether a projectile of this category damages a tank of that category - Tanks are immune to their own side's fire
+bool isHostile(unsigned int tankCategory, unsigned int projectileCategory)
+{
+	return (tankCategory & Category::AlliedTank && projectileCategory & (Category::EnemyProjectile | Category::HostProjectile))
+		|| (tankCategory & Category::EnemyTank && projectileCategory & (Category::AlliedProjectile | Category::HostProjectile))
+		|| (tankCategory & Category::HostTank && projectileCategory & (Category::AlliedProjectile | Category::EnemyProjectile));
+}
+
 bool matchesCategories(SceneNode::Pair& colliders, Category::Type type1, Category::Type type2)
 {
 	unsigned int category1 = colliders.first->getCategory();
@@ -389,12 +620,29 @@ bool matchesCategories(SceneNode::Pair& colliders, Category::Type type1, Categor
 	}
 }
 
+void World::dispatchCommand(const Command& command, sf::Time dt)
+{
+	// Player commands go straight to their tank, everything else to the nodes of its categories
+	if (command.tankIdentifier != 0)
+	{
+		Tank* tank = getTank(command.tankIdentifier);
+		if (tank && (tank->getCategory() & command.category))
+			command.action(*tank, dt);
+	}
+	else
+	{
+		mCategoryIndex.dispatch(command, dt);
+	}
+}
+
 void World::handleCollisions()
 {
-	std::set<SceneNode::Pair> collisionPairs;
-	mSceneGraph.checkSceneCollision(mSceneGraph, collisionPairs);
+	for (std::size_t i = 0; i < mProjectileSystem->getCount(); ++i)
+		mCollisionGrid.addProxy(i, mProjectileSystem->getBulletBounds(i), mProjectileSystem->getBulletCategory(i));
 
-	FOREACH(SceneNode::Pair pair, collisionPairs)
+	mCollisionGrid.computePairs(mSceneGraph, mCollisionPairs, mBulletHits);
+
+	FOREACH(SceneNode::Pair pair, mCollisionPairs)
 	{
 		if (matchesCategories(pair, Category::AlliedTank, Category::Pickup) || matchesCategories(pair, Category::EnemyTank, Category::Pickup) || matchesCategories(pair, Category::HostTank, Category::Pickup))
 		{
@@ -414,26 +662,8 @@ void World::handleCollisions()
 			auto& projectile = static_cast<Projectile&>(*pair.second);
 
 			// Apply projectile damage to Tank, destroy projectile
-			tank.damage(projectile.getDamage());
+			damageTank(tank, projectile.getDamage());
 			projectile.destroy();
-
-			if (tank.getHitpoints() <= projectile.getDamage()) //TODO - Recode to only add score for the one person
-			{
-				std::ifstream fileIn;
-				int scores;
-				fileIn.open("scores.txt");
-				if (!fileIn)
-				{
-					std::ofstream outputFile("scores.txt");
-					scores = 0;
-					outputFile << scores;
-				}
-				fileIn >> scores;
-				scores += 5;
-				std::ofstream outputFile("scores.txt");
-				outputFile << scores;
-				fileIn.close();
-			}
 		}
 
 		//Destroy projectile when it hits a wall - Dylan
@@ -442,9 +672,7 @@ void World::handleCollisions()
 			auto& projectile = static_cast<Projectile&>(*pair.first);
 			auto& obstacle = static_cast<Obstacle&>(*pair.second);
 
-			if (obstacle.getType() == Obstacle::Type::Barrel) {
-				obstacle.damage(projectile.getDamage());
-			}
+			damageObstacle(obstacle, projectile.getDamage());
 
 			//Destroy projectile when it hits a wall
 			projectile.destroy();
@@ -503,6 +731,61 @@ void World::handleCollisions()
 
 		}
 	}
+
+	// Bullets of the projectile system, same rules as the projectile nodes above
+	FOREACH(const CollisionGrid::ProxyPair& hit, mBulletHits)
+	{
+		std::size_t bullet = hit.first;
+		if (!mProjectileSystem->isAlive(bullet))
+			continue;
+
+		unsigned int bulletCategory = mProjectileSystem->getBulletCategory(bullet);
+		unsigned int category = hit.second->getCategory();
+
+		if (category & Category::Tank)
+		{
+			if (isHostile(category, bulletCategory))
+			{
+				damageTank(static_cast<Tank&>(*hit.second), mProjectileSystem->getBulletDamage(bullet));
+				mProjectileSystem->kill(bullet);
+			}
+		}
+		else if (category & Category::Collidable)
+		{
+			damageObstacle(static_cast<Obstacle&>(*hit.second), mProjectileSystem->getBulletDamage(bullet));
+			mProjectileSystem->kill(bullet);
+		}
+	}
+}
+
+void World::damageTank(Tank& tank, int damage)
+{
+	tank.damage(damage);
+
+	if (tank.getHitpoints() <= damage) //TODO - Recode to only add score for the one person
+	{
+		std::ifstream fileIn;
+		int scores;
+		fileIn.open("scores.txt");
+		if (!fileIn)
+		{
+			std::ofstream outputFile("scores.txt");
+			scores = 0;
+			outputFile << scores;
+		}
+		fileIn >> scores;
+		scores += 5;
+		std::ofstream outputFile("scores.txt");
+		outputFile << scores;
+		fileIn.close();
+	}
+}
+
+void World::damageObstacle(Obstacle& obstacle, int damage)
+{
+	if (obstacle.getType() == Obstacle::Type::Barrel) {
+		obstacle.damage(damage);
+	}
 }
 
 void World::updateSounds()
@@ -576,6 +859,16 @@ void World::buildScene()
 	std::unique_ptr<ParticleNode> tankDustNode(new ParticleNode(Particle::TankDust, mTextures));
 	mSceneLayers[LowerAir]->attachChild(std::move(tankDustNode));
 
+	// Plain bullets, drawn over the tanks and particles like the projectile nodes they replace
+	std::unique_ptr<ProjectileSystem> projectileSystem(new ProjectileSystem(mTextures));
+	mProjectileSystem = projectileSystem.get();
+	mSceneLayers[UpperAir]->attachChild(std::move(projectileSystem));
+
+	// Tank hitpoints, drawn above everything that moves
+	std::unique_ptr<LabelBatch> labelBatch(new LabelBatch(mFonts.get(Fonts::Main), 20));
+	mLabelBatch = labelBatch.get();
+	mSceneLayers[UpperAir]->attachChild(std::move(labelBatch));
+
 	// Add sound effect node
 	std::unique_ptr<SoundNode> soundNode(new SoundNode(mSounds));
 	mSceneGraph.attachChild(std::move(soundNode));
@@ -648,6 +941,51 @@ void World::addPickup(Pickup::Type type, float posX, float posY, float rotation,
 	mPickups.push_back(spawn);
 }
 
+// Identifiers follow spawn order, which is the same on every client
+void World::registerReplicated(Entity& entity)
+{
+	sf::Int32 identifier = mReplicationIdentifierCounter++;
+	entity.getReplication().setIdentifier(identifier);
+	mReplicatedEntities[identifier] = mEntityTable.insert(entity);
+}
+
+void World::collectReplicatedStates()
+{
+	for (auto itr = mReplicatedEntities.begin(); itr != mReplicatedEntities.end(); )
+	{
+		Entity* replicated = mEntityTable.get(itr->second);
+		if (!replicated)
+		{
+			mReplicatedEntities.erase(itr++);
+			continue;
+		}
+
+		Entity& entity = *replicated;
+		ReplicationComponent& replication = entity.getReplication();
+
+		// Only entities whose hitpoints ever changed are hashed, the server has no entry for untouched ones either
+		if (replication.getDirtyFields() & (ReplicationComponent::Hitpoints | ReplicationComponent::Destroyed))
+			mStateHash.set(StateHash::Object, itr->first, StateHash::hashObject(entity.getHitpoints(), entity.isDestroyed()));
+
+		if (mReplicationAuthority && replication.getDirtyFields() != 0)
+		{
+			ReplicatedState state;
+			state.identifier = itr->first;
+			state.fields = static_cast<sf::Uint8>(replication.getDirtyFields());
+			state.hitpoints = entity.getHitpoints();
+			state.position = entity.getPosition();
+			mReplicatedStates.push_back(state);
+		}
+		replication.clearDirtyFields();
+
+		// Removed by removeWrecks() right after this, no more states to collect
+		if (entity.isMarkedForRemoval())
+			mReplicatedEntities.erase(itr++);
+		else
+			++itr;
+	}
+}
+
 void World::destroyEntitiesOutsideView()
 {
 	Command command;
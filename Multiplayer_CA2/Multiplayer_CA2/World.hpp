@@ -13,6 +13,13 @@
 #include "SoundPlayer.hpp"
 #include "NetworkProtocol.hpp"
 #include "Obstacle.hpp"
+#include "StateHash.hpp"
+#include "CollisionGrid.hpp"
+#include "CategoryIndex.hpp"
+#include "EntityTable.hpp"
+#include "NodePool.hpp"
+#include "ProjectileSystem.hpp"
+#include "LabelBatch.hpp"
 
 #include <SFML/System/NonCopyable.hpp>
 #include <SFML/Graphics/View.hpp>
@@ -20,6 +27,8 @@
 
 #include <array>
 #include <queue>
+#include <map>
+#include <unordered_map>
 
 
 // Forward declaration
@@ -29,11 +38,12 @@ namespace sf
 }
 
 class NetworkNode;
+class JobSystem;
 
 class World : private sf::NonCopyable
 {
 	public:
-											World(sf::RenderTarget& outputTarget, FontHolder& fonts, SoundPlayer& sounds, bool networked = false);
+											World(sf::RenderTarget& outputTarget, FontHolder& fonts, SoundPlayer& sounds, JobSystem& jobs, bool networked = false);
 		void								update(sf::Time dt);
 		void								draw();
 
@@ -44,6 +54,14 @@ class World : private sf::NonCopyable
 		void								setCurrentBattleFieldPosition(float lineY);
 		void								setWorldHeight(float height);
 
+		// Every tank draws from its own stream derived from this seed; networked games use the server's match seed
+		void								setRandomSeed(sf::Uint64 seed);
+		sf::Uint32							getTick() const;
+
+		// Fixed point motion, table trigonometry and a fixed tick, so every machine fed the same commands
+		// moves tanks and projectiles to bit-identical positions
+		void								setDeterministic(bool deterministic);
+
 		bool 								hasAlivePlayer() const;
 		bool 								hasPlayerReachedEnd() const;
 
@@ -54,11 +72,28 @@ class World : private sf::NonCopyable
 		void								createPickup(sf::Vector2f position, Pickup::Type type);
 		bool								pollGameAction(GameActions::Action& out);
 
+		// Replication of obstacles and pickups: the authority collects dirty fields, everyone else applies them
+		void								setReplicationAuthority(bool authority);
+		void								pollReplicatedStates(std::vector<ReplicatedState>& out);
+		void								applyReplicatedState(const ReplicatedState& state);
+
+		// Desync detection: obstacle and pickup entries follow replication, tank transforms are set by the
+		// caller (the snapshot they converge to) and tank hitpoints are refreshed on demand
+		StateHash&							getStateHash();
+		void								refreshTankHashes();
+
+		// Replaces an arena texture with the match server's version, by its ArenaAssetData name
+		bool								loadArenaAsset(const std::string& name, const std::string& filename);
+
 
 	private:
 		void								loadTextures();
 		void								adaptPlayerPosition();
+		void								dispatchCommand(const Command& command, sf::Time dt);
 		void								handleCollisions();
+		void								damageTank(Tank& tank, int damage);
+		void								damageObstacle(Obstacle& obstacle, int damage);
+		void								updateScene(sf::Time dt);
 		void								updateSounds();
 		void								addObstacle(Obstacle::Type type, float posX, float posY, float rotation, float scaleX, float scaleY, Textures::ID deathAnimation, sf::Vector2i frameSize, int numberOfFrames, int seconds, sf::Vector2f scale); //Info for adding an obstacle - Jason Lynch
 		void								addObstacles();
@@ -76,6 +111,8 @@ class World : private sf::NonCopyable
 
 		void								buildScene();
 		void								destroyEntitiesOutsideView();
+		void								registerReplicated(Entity& entity);
+		void								collectReplicatedStates();
 
 
 	private:
@@ -158,10 +195,19 @@ class World : private sf::NonCopyable
 		TextureHolder						mTextures;
 		FontHolder&							mFonts;
 		SoundPlayer&						mSounds;
-
+		JobSystem&							mJobs;
+
+		// Declared before the scene graph, whose nodes unlink themselves from the index and the entity
+		// table and return to the pools when they are destroyed
+		CategoryIndex						mCategoryIndex;
+		EntityTable							mEntityTable;
+		NodePool<Projectile>				mProjectilePool;
+		NodePool<Pickup>					mPickupPool;
 		SceneNode							mSceneGraph;
 		std::array<SceneNode*, LayerCount>	mSceneLayers;
 		CommandQueue						mCommandQueue;
+		std::vector<SceneNode*>				mEntityNodes;
+		std::vector<CommandQueue>			mBatchQueues;		// One per batch of mEntityNodes, merged into mCommandQueue
 
 		sf::FloatRect						mWorldBounds;
 		sf::Vector2f						mSpawnPosition;
@@ -169,6 +215,7 @@ class World : private sf::NonCopyable
 		float								mScrollSpeed;
 		float								mScrollSpeedCompensation;
 		std::vector<Tank*>					mPlayerTanks;
+		std::unordered_map<int, EntityHandle>	mTankHandles;		// By network identifier
 
 		std::vector<ObstacleSpawnPoint>		mObstacles; //Holds obstacle spawn points - Jason Lynch
 		std::vector<PickupSpawnPoint>		mPickups; //Holds pickups spawn points - Jason Lynch
@@ -180,6 +227,24 @@ class World : private sf::NonCopyable
 		bool								mNetworkedWorld;
 		NetworkNode*						mNetworkNode;
 		SpriteNode*							mFinishSprite;
+
+		sf::Uint64							mRandomSeed;
+		sf::Uint32							mTick;
+		bool								mDeterministic;
+
+		bool								mReplicationAuthority;
+		sf::Int32							mReplicationIdentifierCounter;
+		std::map<sf::Int32, EntityHandle>	mReplicatedEntities;
+		std::vector<ReplicatedState>		mReplicatedStates;
+
+		StateHash							mStateHash;
+		std::vector<sf::Int32>				mHashedTanks;
+
+		CollisionGrid						mCollisionGrid;
+		std::vector<SceneNode::Pair>		mCollisionPairs;
+		std::vector<CollisionGrid::ProxyPair>	mBulletHits;
+		ProjectileSystem*					mProjectileSystem;
+		LabelBatch*							mLabelBatch;
 };
 
 #endif // BOOK_WORLD_HPP